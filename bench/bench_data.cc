@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <liteseq/gfa.h>
+#include <liteseq/types.h>
+
+#include "../tools/gfa_gen.h"
+
+using namespace liteseq;
+
+/*
+ * The input of the benchmarks
+ * ---------------------------
+ * A graph of tools/gfa_gen from a fixed seed so that runs compare, or the
+ * GFA at LITESEQ_BENCH_GFA. LITESEQ_BENCH_SEGMENTS sets the size of the
+ * generated graph.
+ */
+
+#define BENCH_SEGMENTS 200000
+#define BENCH_PATHS 8
+#define BENCH_SEED 0x5eed
+
+static struct gfa_gen_opts bench_gen_opts(id_t segments)
+{
+	struct gfa_gen_opts o;
+	gfa_gen_defaults(&o);
+	o.seed = BENCH_SEED;
+	o.segment_count = segments;
+	o.path_count = BENCH_PATHS;
+
+	return o;
+}
+
+// the text of a generated graph of segments segments
+static std::string bench_gen_text(id_t segments)
+{
+	struct gfa_gen_opts o = bench_gen_opts(segments);
+	char *buf = NULL;
+	size_t size = 0;
+	FILE *f = open_memstream(&buf, &size);
+	gfa_gen_write(&o, f, NULL);
+	fclose(f);
+
+	std::string text(buf, size);
+	free(buf);
+
+	return text;
+}
+
+static idx_t bench_env(const char *name, idx_t fallback)
+{
+	const char *v = std::getenv(name);
+	return v ? (idx_t)std::strtoul(v, NULL, 10) : fallback;
+}
+
+struct bench_gfa {
+	std::string fp;
+	size_t bytes;
+	idx_t lines;
+};
+
+static std::string bench_tmp_fp;
+
+static void bench_remove_tmp()
+{
+	std::remove(bench_tmp_fp.c_str());
+}
+
+#define BENCH_READ_CHUNK (1 << 20)
+
+// the size and the newlines of the file at fp, read a chunk at a time
+static void bench_count_lines(const char *fp, size_t *bytes, idx_t *lines)
+{
+	std::ifstream f(fp, std::ios::binary);
+	std::vector<char> buf(BENCH_READ_CHUNK);
+	*bytes = 0;
+	*lines = 0;
+	while (f) {
+		f.read(buf.data(), (std::streamsize)buf.size());
+		size_t n = (size_t)f.gcount();
+		*bytes += n;
+		*lines += (idx_t)std::count(buf.begin(), buf.begin() + n, '\n');
+	}
+}
+
+// the GFA file the end to end benchmarks load, written on first use
+static const bench_gfa &bench_input()
+{
+	static bench_gfa in = [] {
+		bench_gfa g;
+		if (const char *fp = std::getenv("LITESEQ_BENCH_GFA")) {
+			g.fp = fp;
+			bench_count_lines(fp, &g.bytes, &g.lines);
+			return g;
+		}
+
+		const char *dir = std::getenv("TMPDIR");
+		g.fp = std::string(dir ? dir : "/tmp") + "/liteseq_bench.gfa";
+		struct gfa_gen_opts o = bench_gen_opts(
+			bench_env("LITESEQ_BENCH_SEGMENTS", BENCH_SEGMENTS));
+		struct gfa_gen_counts c = {};
+		gfa_gen_file(&o, g.fp.c_str(), &c);
+		bench_tmp_fp = g.fp;
+		std::atexit(bench_remove_tmp);
+
+		// the header and the S, L, P and W lines
+		g.bytes = c.bytes;
+		g.lines = 1 + c.segments + c.links + c.p_lines + c.w_lines;
+
+		return g;
+	}();
+
+	return in;
+}
+
+/**
+ * The lines of text that start with prefix, pointing into text which must
+ * outlive them
+ */
+static std::vector<line> bench_lines(std::string &text, char prefix)
+{
+	std::vector<line> out;
+	char *c = text.data();
+	char *end = c + text.size();
+	for (idx_t i = 0; c < end; i++) {
+		char *nl = (char *)memchr(c, '\n', end - c);
+		if (!nl)
+			nl = end;
+		if (*c == prefix)
+			out.push_back(line{c, i, (idx_t)(nl - c)});
+		c = nl + 1;
+	}
+
+	return out;
+}
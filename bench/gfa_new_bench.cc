@@ -0,0 +1,47 @@
+/*
+ * gfa_new end to end on the bench input, for each set of what gets loaded
+ * and each number of worker threads
+ */
+
+struct bench_preset {
+	const char *name;
+	bool inc_vtx_labels;
+	bool inc_refs;
+	bool inc_occ_index;
+	bool inc_stats;
+};
+
+static const bench_preset bench_presets[] = {
+	{"structure", false, false, false, false},
+	{"labels", true, false, false, false},
+	{"refs", true, true, false, false},
+	{"all", true, true, true, true},
+};
+
+static void BM_GfaNew(benchmark::State &state)
+{
+	const bench_gfa &in = bench_input();
+	const bench_preset &p = bench_presets[state.range(0)];
+	gfa_config_cpp conf(in.fp.c_str(), p.inc_vtx_labels, p.inc_refs,
+			    p.inc_occ_index, (u32)state.range(1), p.inc_stats);
+
+	for (auto _ : state) {
+		gfa_props *gfa = gfa_new(&conf);
+		if (gfa->status != SUCCESS) {
+			state.SkipWithError("failed to load the bench input");
+			gfa_free(gfa);
+			return;
+		}
+		gfa_free(gfa);
+	}
+
+	state.SetLabel(p.name);
+	state.SetBytesProcessed((int64_t)(state.iterations() * in.bytes));
+	auto rate = benchmark::Counter::kIsIterationInvariantRate;
+	state.counters["lines"] = benchmark::Counter((double)in.lines, rate);
+}
+BENCHMARK(BM_GfaNew)
+	->ArgNames({"config", "threads"})
+	->ArgsProduct({{0, 1, 2, 3}, {1, 2, 4, 8}})
+	->UseRealTime()
+	->Unit(benchmark::kMillisecond);
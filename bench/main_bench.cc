@@ -0,0 +1,5 @@
+#include <benchmark/benchmark.h>
+
+#include "./bench_data.cc"
+#include "./parse_bench.cc"
+#include "./gfa_new_bench.cc"
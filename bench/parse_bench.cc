@@ -0,0 +1,228 @@
+#include <liteseq/refs.h>
+
+#include "../src/gfa_impl.h"
+#include "../src/gfa_l.h"
+#include "../src/gfa_s.h"
+#include "../src/internal/lq_arena.h"
+#include "../src/internal/lq_utils.h"
+#include "../src/refs/ref_walk.h"
+
+/*
+ * The phases of a load one at a time, on the lines of a generated graph
+ */
+
+#define BENCH_PARSE_SEGMENTS 20000
+
+static std::string &bench_parse_text()
+{
+	static std::string text = bench_gen_text(BENCH_PARSE_SEGMENTS);
+	return text;
+}
+
+static void set_line_counters(benchmark::State &state,
+			      const std::vector<line> &lines)
+{
+	size_t bytes = 0;
+	for (const line &l : lines)
+		bytes += l.len + 1;
+	state.SetBytesProcessed((int64_t)(state.iterations() * bytes));
+	state.SetItemsProcessed((int64_t)(state.iterations() * lines.size()));
+}
+
+// tokenize S lines (arg 0) or L lines (arg 1) like their handlers do
+static void BM_SplitStr(benchmark::State &state)
+{
+	std::vector<line> lines =
+		bench_lines(bench_parse_text(), state.range(0) ? 'L' : 'S');
+	struct lq_arena *scratch = lq_arena_new(LQ_ARENA_BLOCK_SIZE);
+	char *tokens[EXPECTED_L_LINE_TOKENS] = {NULL};
+
+	for (auto _ : state) {
+		for (const line &l : lines) {
+			struct split_str_params p = {
+				.str = l.start,
+				.up_to = l.start + l.len,
+				.delimiter = TAB_CHAR,
+				.fallbacks = "",
+				.fallback_chars_count = 0,
+				.max_splits = EXPECTED_L_LINE_TOKENS,
+				.tokens_found = 0,
+				.tokens = tokens,
+				.end = NULL,
+				.arena = scratch,
+			};
+			split_str(&p);
+			benchmark::DoNotOptimize(tokens[0]);
+			lq_arena_reset(scratch);
+		}
+	}
+
+	lq_arena_destroy(&scratch);
+	set_line_counters(state, lines);
+}
+BENCHMARK(BM_SplitStr)->ArgName("l_lines")->Arg(0)->Arg(1);
+
+// the vertex id of every S line, as the scan for the id bounds reads it
+static void BM_ParseVertexIds(benchmark::State &state)
+{
+	std::vector<line> lines = bench_lines(bench_parse_text(), 'S');
+	gfa_props gfa = {};
+
+	for (auto _ : state) {
+		gfa.min_v_id = NULL_ID;
+		gfa.max_v_id = 0;
+		for (const line &l : lines)
+			set_v_id_bounds(l.start, &gfa, l.line_idx);
+		benchmark::DoNotOptimize(gfa.max_v_id);
+	}
+
+	set_line_counters(state, lines);
+}
+BENCHMARK(BM_ParseVertexIds);
+
+// the walk column of a P line, or of a W line when w
+static std::string bench_walk(bool w, idx_t steps)
+{
+	std::string s;
+	for (idx_t i = 1; i <= steps; i++) {
+		std::string id = std::to_string(i * 7);
+		if (w)
+			s += (i % 2 ? ">" : "<") + id;
+		else
+			s += (i > 1 ? "," : "") + id + (i % 2 ? "+" : "-");
+	}
+
+	return s;
+}
+
+static void BM_CountSteps(benchmark::State &state)
+{
+	enum gfa_line_prefix prefix = state.range(0) ? W_LINE : P_LINE;
+	std::string walk = bench_walk(state.range(0), state.range(1));
+
+	for (auto _ : state)
+		benchmark::DoNotOptimize(count_steps(prefix, walk.c_str()));
+
+	state.SetBytesProcessed((int64_t)(state.iterations() * walk.size()));
+	state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_CountSteps)
+	->ArgNames({"w_line", "steps"})
+	->ArgsProduct({{0, 1}, {64, 4096, 262144}});
+
+static void BM_ParseWalk(benchmark::State &state)
+{
+	bool w = state.range(0);
+	std::string walk = bench_walk(w, state.range(1));
+	struct ref_walk *rw = alloc_ref_walk(state.range(1), NULL);
+
+	for (auto _ : state) {
+		if (w)
+			parse_data_line_w(walk.c_str(), &rw);
+		else
+			parse_data_line_p(walk.c_str(), &rw);
+		benchmark::DoNotOptimize(rw->v_ids[0]);
+	}
+
+	destroy_ref_walk(&rw);
+	state.SetBytesProcessed((int64_t)(state.iterations() * walk.size()));
+	state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_ParseWalk)
+	->ArgNames({"w_line", "steps"})
+	->ArgsProduct({{0, 1}, {64, 4096, 262144}});
+
+// the S line worker with (arg 1) or without the labels
+static void BM_HandleS(benchmark::State &state)
+{
+	std::vector<line> lines = bench_lines(bench_parse_text(), 'S');
+	std::vector<vtx *> vertices(BENCH_PARSE_SEGMENTS + 1);
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		struct lq_arena *arena = lq_arena_new(LQ_ARENA_BLOCK_SIZE);
+		state.ResumeTiming();
+
+		struct s_thread_meta meta = {
+			.arena = arena,
+			.vertices = vertices.data(),
+			.v_lo = 0,
+			.s_lines = lines.data(),
+			.s_line_count = (idx_t)lines.size(),
+			.inc_vtx_labels = state.range(0) != 0,
+			.seg_lens = NULL,
+			.load = NULL,
+		};
+		t_handle_s(&meta);
+
+		state.PauseTiming();
+		lq_arena_destroy(&arena);
+		state.ResumeTiming();
+	}
+
+	set_line_counters(state, lines);
+}
+BENCHMARK(BM_HandleS)->ArgName("labels")->Arg(0)->Arg(1);
+
+static void BM_HandleL(benchmark::State &state)
+{
+	std::vector<line> lines = bench_lines(bench_parse_text(), 'L');
+	std::vector<edge> edges(lines.size());
+
+	for (auto _ : state) {
+		struct l_thread_meta meta = {
+			.edges = edges.data(),
+			.l_lines = lines.data(),
+			.l_line_count = (idx_t)lines.size(),
+			.stats = NULL,
+			.load = NULL,
+		};
+		t_handle_l(&meta);
+		benchmark::DoNotOptimize(edges[0]);
+	}
+
+	set_line_counters(state, lines);
+}
+BENCHMARK(BM_HandleL);
+
+// the loci and the positional index of all the refs of the bench input. The
+// index is allocated from the refs arena, so each iteration gets a fresh graph
+// loaded out of the timed region and the arena does not grow across them
+static gfa_props *load_loci_input(benchmark::State &state)
+{
+	gfa_config conf = gfa_config_cpp(bench_input().fp.c_str(), true, true);
+	gfa_props *gfa = gfa_new(&conf);
+	if (gfa->status != SUCCESS) {
+		state.SkipWithError("failed to load the bench input");
+		gfa_free(gfa);
+		return NULL;
+	}
+
+	return gfa;
+}
+
+static void BM_SetRefLoci(benchmark::State &state)
+{
+	gfa_props *gfa = load_loci_input(state);
+	if (!gfa)
+		return;
+
+	idx_t steps = 0;
+	for (idx_t i = 0; i < gfa->ref_count; i++)
+		steps += get_step_count(get_ref(gfa, i));
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		gfa_free(gfa);
+		gfa = load_loci_input(state);
+		state.ResumeTiming();
+		if (!gfa)
+			return;
+
+		set_ref_loci(gfa, 0);
+	}
+
+	state.SetItemsProcessed((int64_t)(state.iterations() * steps));
+	gfa_free(gfa);
+}
+BENCHMARK(BM_SetRefLoci)->Unit(benchmark::kMillisecond);
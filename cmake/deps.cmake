@@ -28,3 +28,16 @@ CPMAddPackage(
   "gtest_force_shared_crt ON"
 )
 endif()
+
+if (LITESEQ_BUILD_BENCH)
+CPMAddPackage(
+  benchmark
+  GITHUB_REPOSITORY google/benchmark
+  GIT_TAG        v1.9.1
+  VERSION        1.9.1
+  OPTIONS
+  "BENCHMARK_ENABLE_TESTING OFF"
+  "BENCHMARK_ENABLE_INSTALL OFF"
+  "BENCHMARK_INSTALL_DOCS OFF"
+)
+endif()
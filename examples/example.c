@@ -31,6 +31,7 @@ gfa_config gen_config(const char *fp)
 		.fp = fp,
 		.inc_vtx_labels = true,
 		.inc_refs = true,
+		.inc_stats = true,
 	};
 
 	return conf_c;
@@ -59,6 +60,18 @@ int main(int argc, char *argv[])
 	log_info("GFA version %s", to_string_gfa_version(gfa->version));
 	log_info("vtx count %u", gfa->s_line_count);
 
+	const struct gfa_stats *st = gfa->stats;
+	if (st) {
+		log_info("segments %u total length %lu N50 %u", st->seg_count,
+			 (unsigned long)st->seg_total_len, st->seg_n50);
+		log_info("edges %u self loops %u tips %u isolated %u",
+			 st->edge_count, st->self_loops, st->tips,
+			 st->isolated);
+		log_info("refs %u steps %lu bases %lu", st->ref_count,
+			 (unsigned long)st->ref_total_steps,
+			 (unsigned long)st->ref_total_len);
+	}
+
 	/* confirm the refs parsed */
 	if (gfa->inc_refs) {
 		printf("refs:\n");
@@ -3,6 +3,7 @@
 
 #include <pthread.h> // multithreading
 #include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
 
 #include "../src/internal/lq_enums.h"
@@ -27,6 +28,15 @@ typedef enum {
 
 DEFINE_ENUM(gfa_version, GFA_VERSION_ITEMS)
 
+// bump allocator backing the graph, see src/internal/lq_arena.h
+struct lq_arena;
+// pool of interned strings, see src/internal/lq_intern.h
+struct lq_intern;
+// hash index over the refs, see src/refs/ref_lookup.h
+struct ref_lookup;
+// the progress and the cancel flag of a load, see src/gfa_load.h
+struct gfa_load_state;
+
 // a line in the GFA file
 typedef struct {
 	char *start;
@@ -49,6 +59,96 @@ typedef struct {
 	vtx_side_e v2_side; // the side of the second vertex
 } edge;
 
+// a step of a ref that passes through a vertex, see get_vtx_occs
+struct vtx_occ {
+	idx_t ref_idx; // the index of the ref in gfa_props refs
+	idx_t step;    // the index of the step in the walk of the ref
+};
+
+#define GFA_STATS_DEGREE_BUCKETS 16
+#define GFA_STATS_LEN_BUCKETS 32
+
+// QC metrics collected while parsing, see inc_stats in gfa_config
+struct gfa_stats {
+	/* segments i.e. S lines */
+	idx_t seg_count;
+	u64 seg_total_len;
+	idx_t seg_min_len;
+	idx_t seg_max_len;
+	idx_t seg_n50;
+
+	/* links i.e. L lines */
+	idx_t edge_count;
+	idx_t self_loops;
+	idx_t tips;	// vertices with edges on only one side
+	idx_t isolated; // vertices with no edges
+	// vertices by the number of edge ends on them, the last bucket holds
+	// the rest
+	idx_t degree_hist[GFA_STATS_DEGREE_BUCKETS];
+
+	/* refs i.e. P and W lines, the lengths are in bases and need labels */
+	idx_t ref_count;
+	u64 ref_total_steps;
+	idx_t ref_min_steps;
+	idx_t ref_max_steps;
+	u64 ref_total_len;
+	idx_t ref_min_len;
+	idx_t ref_max_len;
+	idx_t ref_len_hist[GFA_STATS_LEN_BUCKETS]; // by floor(log2(len))
+};
+
+/*
+ * The phases of a load that gfa_metrics times, in the order they start: the
+ * mapping of the file, the structure scan or the read of the .lqi sidecar,
+ * the line tables, the allocation of the graph, the S, L and P and W lines,
+ * the loci, the gfa_stats and the occurrence index
+ */
+#define GFA_METRIC_ITEMS(_)                                                    \
+	_(GFA_METRIC_MAP, "map")                                               \
+	_(GFA_METRIC_SCAN, "scan")                                             \
+	_(GFA_METRIC_INDEX, "index")                                           \
+	_(GFA_METRIC_ALLOC, "alloc")                                           \
+	_(GFA_METRIC_S, "s_lines")                                             \
+	_(GFA_METRIC_L, "l_lines")                                             \
+	_(GFA_METRIC_REFS, "refs")                                             \
+	_(GFA_METRIC_LOCI, "loci")                                             \
+	_(GFA_METRIC_STATS, "stats")                                           \
+	_(GFA_METRIC_OCC, "occ_index")
+
+DEFINE_ENUM(gfa_metric, GFA_METRIC_ITEMS)
+
+#define GFA_METRIC_COUNT gfa_metric_INVALID
+
+// what a phase of a load took, all 0 when it did not run
+struct gfa_phase_metrics {
+	// CLOCK_MONOTONIC when the first of its threads started and the last
+	// one ended, the S, L and ref lines are parsed side by side
+	u64 start_ns;
+	u64 end_ns;
+	u64 wall_ns; // end_ns - start_ns
+	// of its threads, of the whole process when it ran workers of its own
+	u64 cpu_ns;
+	u64 bytes;	 // of the lines it went through
+	idx_t lines;	 // or refs for the phases after the parse
+	u32 threads;	 // or tasks of gfa_new_batch that ran it
+	u64 allocs;	 // objects from the arenas of the graph
+	u64 heap_allocs; // blocks those arenas took from the heap
+	// page faults of its threads or the process as with cpu_ns, those of
+	// the mapping of the file are in the scan
+	u64 minor_faults;
+	u64 major_faults;
+};
+
+// what a load took phase by phase, see gfa_metrics_print
+struct gfa_metrics {
+	struct gfa_phase_metrics phases[GFA_METRIC_COUNT];
+	u64 start_ns; // CLOCK_MONOTONIC
+	u64 wall_ns;  // of the whole load, 0 until it is done
+	u64 file_size;
+	u32 thread_count;    // of the graph
+	bool line_index_hit; // the lines came from the .lqi sidecar
+};
+
 // This struct holds metadata about the GFA file
 // for internal use
 // TODO: rename to gfa_meta
@@ -57,6 +157,11 @@ typedef struct {
 
 	bool inc_vtx_labels;
 	bool inc_refs;
+	bool inc_occ_index;
+	bool inc_stats;
+	bool use_line_index; // read and write the <fp>.lqi sidecar
+	const struct ref_filter *ref_filter; // the refs to load or NULL
+	u32 thread_count;    // worker threads for the parallel passes
 
 	char *start;	  // pointer to the start of the memory mapped file
 	char *end;	  // pointer to the end of the memory mapped file
@@ -70,12 +175,64 @@ typedef struct {
 
 	u32 min_v_id;	  // the minimum vertex id in the GFA file
 	u32 max_v_id;	  // the maximum vertex id in the GFA file
-	u32 vtx_arr_size; // the size of the vertex array (max_v_id + 1)
+	u32 vtx_arr_size; // the size of the vertex array, see gfa_vtx_slot
+
+	// the vertex ids loaded, [v_lo, v_hi). All of them i.e. 0 and NULL_ID
+	// unless this is a partial load, see v_lo in gfa_config
+	id_t v_lo;
+	id_t v_hi;
 
 	vtx **v;	   // the array of vertices
 	edge *e;	   // the array of edges
 	struct ref **refs; // the reference sequences
 
+	// the vertices, their labels and the refs are allocated from these
+	// per-thread arenas and are released all at once by gfa_free
+	struct lq_arena **arenas;
+	idx_t arena_count;
+
+	// PanSN sample and contig names shared by all refs
+	struct lq_intern *names;
+
+	struct gfa_stats *stats; // NULL unless inc_stats
+
+	// finds refs by tag or PanSN name, lives in the refs arena
+	struct ref_lookup *ref_lookup;
+
+	// the steps through each vertex in CSR form by gfa_vtx_slot, those of
+	// slot s are occs[occ_offsets[s]] up to occs[occ_offsets[s + 1]]
+	u64 *occ_offsets; // vtx_arr_size + 1 entries
+	struct vtx_occ *occs;
+
+	// the edges incident to each vertex in CSR form, built on first use
+	idx_t *adj_offsets; // vtx_arr_size + 1 entries
+	idx_t *adj_edges;   // indices into e
+
+	// the arrays gfa_refresh swapped out, which readers may still hold,
+	// freed by gfa_free
+	void **retired;
+	idx_t retired_count;
+
+	// guards the indexes built on first use and serialises gfa_refresh
+	pthread_mutex_t lock;
+
+	// the phases of the load that are done as bits 1 << gfa_phase, guarded
+	// by lock and signalled on phase_cond, see gfa_wait
+	u32 phases_done;
+	pthread_cond_t phase_cond;
+
+	// the mapping of the snapshot or the shared graph the graph came from,
+	// NULL otherwise
+	void *snapshot;
+	size_t snapshot_size;
+
+	// the progress and the cancel flag of a load by gfa_new_async, NULL
+	// once the graph is loaded
+	struct gfa_load_state *load;
+
+	// what the load took, all 0 for a snapshot or a shared graph
+	struct gfa_metrics metrics;
+
 	enum gfa_version version; // version
 
 	/* number of S, L, P and W lines in the file */
@@ -87,17 +244,407 @@ typedef struct {
 	idx_t ref_count; // p_line_count + w_line_count
 } gfa_props;
 
+// the part of a ref that lies in a region, see gfa_extract_region
+struct region_walk {
+	idx_t ref_idx;	  // the index of the ref in gfa_props refs
+	idx_t step_start; // the first step of the fragment
+	idx_t step_count; // the number of consecutive steps in the region
+};
+
+// a subgraph of a gfa_props, the walks are views into its refs
+struct gfa_region {
+	id_t *v_ids; // sorted ids of the vertices in the region
+	idx_t v_count;
+
+	edge *e; // copies of the edges between vertices of the region
+	idx_t e_count;
+
+	struct region_walk *walks; // sorted by ref_idx then step_start
+	idx_t walk_count;
+};
+
+// the weakly connected components of a graph, see gfa_connected_components
+struct gfa_components {
+	// vtx_arr_size entries by gfa_vtx_slot, the component of each vertex
+	// or NULL_ID for ids with no S line. Components are numbered from 0
+	// in the order of their smallest vertex id
+	id_t *comp_ids;
+	idx_t *sizes; // the number of vertices in each component
+	idx_t count;  // the number of components
+};
+
+// how the refs cover each vertex, see gfa_compute_coverage
+struct gfa_coverage {
+	// vtx_arr_size entries by gfa_vtx_slot
+	idx_t *depth;	  // the steps through a vertex
+	idx_t *hap_count; // the walks through a vertex
+	id_t v_lo;	  // the v_lo of the graph
+};
+
+// a run of bases of a ref with the same depth, see ref_depth_runs
+struct depth_run {
+	idx_t len;   // the number of bases
+	idx_t depth; // the depth of the vertices under them
+};
+
 typedef struct {
 	const char *fp;
 	bool inc_vtx_labels;
 	bool inc_refs;
+	bool inc_occ_index; // build the vertex to ref index, needs inc_refs
+	u32 thread_count;   // 0 to use one thread per online processor
+	bool inc_stats;	    // collect gfa_stats while parsing
+	// keep the line counts, id bounds and line offsets in <fp>.lqi so that
+	// later loads of the unchanged file skip the structure scan
+	bool use_line_index;
+	// the refs to load, NULL for all of them. The other P and W lines cost
+	// only a scan of their names
+	const struct ref_filter *ref_filter;
+	// a partial load of the vertex ids [v_lo, v_hi), v_hi of 0 for no
+	// upper bound. Only the S lines in range are kept, the L lines with an
+	// end in range and the refs that step into it. A walk is split into
+	// its runs of steps in range, each a ref of its own with the name of
+	// the line and loci from 1, see get_first_step. Such a graph is not
+	// written back by gfa_write or gfa_write_fasta.
+	id_t v_lo;
+	id_t v_hi;
 } gfa_config;
 
+/**
+ * The vertex array and the per vertex arrays derived from it, such as the
+ * components and the coverage, hold the ids [v_lo, v_lo + vtx_arr_size) of
+ * the graph. The slot of an id is its offset from v_lo, ids out of the array
+ * get a slot of vtx_arr_size or more.
+ */
+static inline u32 gfa_vtx_slot(const gfa_props *gfa, id_t v_id)
+{
+	return v_id - gfa->v_lo;
+}
+
 vtx *get_vtx(gfa_props *gfa, id_t v_id);
 struct ref *get_ref(gfa_props *gfa, idx_t ref_idx);
 
+/*
+ * PanSN sample and contig names are interned, get_sample_id and get_contig_id
+ * return handles that can be turned back into names and vice versa
+ */
+const char *get_pansn_name(const gfa_props *gfa, id_t name_id);
+id_t find_pansn_name(const gfa_props *gfa, const char *name);
+
+/*
+ * Ref lookup, needs inc_refs. The finds return the ref_idx of the ref or
+ * NULL_IDX if there is none, of the first run of a walk a partial load split.
+ */
+idx_t find_ref_by_tag(const gfa_props *gfa, const char *tag);
+idx_t find_ref_by_pansn(const gfa_props *gfa, const char *sample_name,
+			id_t hap_id, const char *contig_name);
+
+/**
+ * The ref_idx of every ref of a sample or of a contig in increasing order.
+ * Returns NULL with count set to 0 when there are none.
+ */
+const idx_t *get_sample_refs(const gfa_props *gfa, id_t sample_id,
+			     idx_t *count);
+const idx_t *get_contig_refs(const gfa_props *gfa, id_t contig_id,
+			     idx_t *count);
+
+/*
+ * The vertex to ref occurrence index. gfa_new builds it when inc_occ_index is
+ * set, otherwise gfa_build_occ_index can be called on a gfa with refs.
+ */
+status_t gfa_build_occ_index(gfa_props *gfa);
+
+/**
+ * The steps of all refs that pass through v_id sorted by ref_idx then step.
+ * Returns NULL with count set to 0 when the index is not built or v_id is out
+ * of range.
+ */
+const struct vtx_occ *get_vtx_occs(const gfa_props *gfa, id_t v_id,
+				   idx_t *count);
+
+/**
+ * Extract the subgraph under bases [start, end] of ref r (1 based, inclusive)
+ * grown by context_steps hops along the edges, together with the fragments of
+ * every ref that passes through it.
+ *
+ * Needs the loci i.e. inc_vtx_labels and inc_refs. The cost is proportional
+ * to the size of the region when the occurrence index is built, otherwise
+ * the walks of all refs are scanned for the fragments.
+ *
+ * @return the region to be freed with gfa_region_free or NULL on error
+ */
+struct gfa_region *gfa_extract_region(gfa_props *gfa, const struct ref *r,
+				      idx_t start, idx_t end,
+				      idx_t context_steps);
+void gfa_region_free(struct gfa_region **region);
+
+/**
+ * Write the len bases of ref r from base start (1 based) to buf followed by a
+ * null terminator, so buf needs room for len + 1 chars. Reverse steps are
+ * reverse complemented. Needs the loci i.e. inc_vtx_labels and inc_refs.
+ *
+ * @return SUCCESS, ERROR_CODE_OUT_OF_BOUNDS when the bases are not all in the
+ * ref or ERROR_CODE_INVALID_ARGUMENT when the ref has no loci or labels
+ */
+status_t ref_get_sequence(const gfa_props *gfa, const struct ref *r,
+			  idx_t start, idx_t len, char *buf);
+
+// the whole haplotype, buf needs room for get_hap_len(r) + 1 chars
+status_t ref_get_haplotype(const gfa_props *gfa, const struct ref *r,
+			   char *buf);
+
+/**
+ * Write every ref as a FASTA record named by its tag to the file at fp, in the
+ * order of the refs, with line_width bases per line or one line if it is 0.
+ * Refs are written concurrently by thread_count workers. Needs the loci.
+ * ERROR_CODE_INVALID_ARGUMENT for a partial load, whose split walks would
+ * give records of the same name.
+ */
+status_t gfa_write_fasta(const gfa_props *gfa, const char *fp,
+			 idx_t line_width);
+
+/**
+ * Label the weakly connected components of the graph formed by the L lines
+ * with a lock-free union-find run by thread_count workers. Edges to ids with
+ * no S line are ignored.
+ *
+ * @return the components to be freed with gfa_components_free or NULL on
+ * error
+ */
+struct gfa_components *gfa_connected_components(const gfa_props *gfa);
+void gfa_components_free(struct gfa_components **cc);
+
+/**
+ * Count the steps and the distinct refs through every vertex, in parallel
+ * across the refs. Needs inc_refs.
+ *
+ * @return the coverage to be freed with gfa_coverage_free or NULL on error
+ */
+struct gfa_coverage *gfa_compute_coverage(const gfa_props *gfa);
+void gfa_coverage_free(struct gfa_coverage **cov);
+
+/**
+ * The per base depth along ref r as runs of equal depth, in the order of the
+ * ref. *runs is allocated and is to be freed by the caller. Needs the loci.
+ */
+status_t ref_depth_runs(const struct gfa_coverage *cov, const struct ref *r,
+			struct depth_run **runs, idx_t *run_count);
+
+/* what gfa_write emits besides the header and the S lines */
+struct gfa_write_opts {
+	bool inc_edges; // L lines
+	bool inc_refs;	// P and W lines, if the graph has refs
+};
+
+/**
+ * Write the graph as GFA to fp, formatting in parallel and writing each part
+ * in place. opts may be NULL to write everything the graph holds.
+ *
+ * The output is canonical: S lines by id with * when there are no labels, L
+ * lines with a 0M overlap, P lines with a * overlap field then W lines that
+ * span their whole haplotype. Optional tags are not kept. A file in that form
+ * is written back byte for byte.
+ *
+ * ERROR_CODE_INVALID_ARGUMENT for a partial load, which has L lines to
+ * vertices it does not hold and walks split into runs with no known place
+ * in the whole walk.
+ */
+status_t gfa_write(const gfa_props *gfa, const char *fp,
+		   const struct gfa_write_opts *opts);
+
+/**
+ * Parse the lines appended to the GFA file since it was loaded or last
+ * refreshed. A line without its newline yet is left for the next refresh.
+ *
+ * The vertices, edges and refs of the new lines go after the existing ones,
+ * in new arrays and indexes that are swapped in once they are complete. What
+ * they replace is not changed and is kept until gfa_free, so readers may go
+ * on concurrently with arrays they already hold and see the new ones once
+ * they are in. Refs loaded earlier keep their loci even if a vertex they walk
+ * through only gets its S line in the tail.
+ *
+ * Refreshes of the same gfa are serialised by its lock.
+ */
+status_t gfa_refresh(gfa_props *gfa);
+
+/**
+ * Write the parsed graph to a binary snapshot at fp that gfa_load_snapshot
+ * maps back without parsing. The file is replaced atomically.
+ */
+status_t gfa_save_snapshot(const gfa_props *gfa, const char *fp);
+
+/**
+ * Load a graph written by gfa_save_snapshot. The file is checked against its
+ * checksum and must come from a machine of the same byte order and word size.
+ *
+ * @return the graph to be freed with gfa_free or NULL on error
+ */
+gfa_props *gfa_load_snapshot(const char *fp);
+
+/*
+ * Shared graphs
+ * -------------
+ * A parsed graph published to shared memory is attached to by any number of
+ * processes without parsing or copying it, the host holds one copy. The
+ * segment is laid out like a snapshot with its pointers set for the address
+ * the publisher mapped it at. Attaching maps it read-only there, or privately
+ * with the pointers moved when that address is taken in the process.
+ *
+ * An attached graph is freed with gfa_free, it can't be refreshed.
+ */
+
+/**
+ * Publish the graph to a new sealed memfd, to be passed to other processes
+ * by fork or over a unix socket. Linux only.
+ *
+ * @return the fd, to be closed by the caller, or -1 on error
+ */
+int gfa_publish_memfd(const gfa_props *gfa);
+
+/**
+ * Publish the graph to the POSIX shared memory object name, e.g. "/graph",
+ * replacing any graph published under it before. It stays until
+ * gfa_unpublish, which leaves those attached to it be.
+ */
+status_t gfa_publish(const gfa_props *gfa, const char *name);
+status_t gfa_unpublish(const char *name);
+
+/**
+ * Attach to a graph published to fd or to the object name. fd stays open.
+ *
+ * @return the graph to be freed with gfa_free or NULL on error
+ */
+gfa_props *gfa_attach(int fd);
+gfa_props *gfa_attach_shm(const char *name);
+
 gfa_props *gfa_new(const gfa_config *conf);
 
+/*
+ * Asynchronous loading
+ * --------------------
+ * gfa_new_async runs gfa_new on a thread of its own and returns at once. The
+ * workers publish how far they got and look for a cancel every few thousand
+ * lines, a cancelled load frees all it has built before it finishes.
+ */
+
+// the stages of a load in the order they run
+enum gfa_load_stage {
+	GFA_LOAD_SCAN,	 // counting the lines and the vertex id bounds
+	GFA_LOAD_INDEX,	 // collecting the line tables
+	GFA_LOAD_PARSE,	 // the S, L, P and W lines, concurrently
+	GFA_LOAD_FINISH, // the loci, the stats and the occurrence index
+	GFA_LOAD_DONE,	 // finished, cancelled or failed
+};
+
+// a snapshot of the progress of a load, the totals are 0 until known
+struct gfa_progress {
+	enum gfa_load_stage stage;
+
+	u64 file_size;
+	u64 bytes_scanned;
+
+	idx_t line_count; // of S, L, P and W lines
+	idx_t lines_indexed;
+
+	idx_t s_line_count;
+	idx_t s_lines_parsed;
+	idx_t l_line_count;
+	idx_t l_lines_parsed;
+	idx_t ref_count; // P and W lines, if inc_refs
+	idx_t refs_parsed;
+};
+
+// what of a graph can be used while gfa_new_async is still loading it
+enum gfa_phase {
+	GFA_PHASE_VERTICES, // v, with the labels if inc_vtx_labels
+	GFA_PHASE_EDGES,    // e
+	GFA_PHASE_REFS,	    // the refs, their names and walks, the ref lookup
+	GFA_PHASE_LOCI,	    // the loci and the haplotype lengths of the refs
+	GFA_PHASE_ALL,	    // the whole graph and its final status
+	GFA_PHASE_COUNT
+};
+
+struct gfa_load;
+
+/**
+ * Start loading the GFA file of conf in the background. conf is copied but
+ * the file path is not, as with gfa_new.
+ *
+ * @return the load to be finished with gfa_load_wait or NULL on error
+ */
+struct gfa_load *gfa_new_async(const gfa_config *conf);
+
+/**
+ * The graph being loaded, to be used with gfa_wait as the load goes on. It is
+ * valid until gfa_load_wait returns.
+ */
+gfa_props *gfa_load_graph(const struct gfa_load *load);
+
+/**
+ * Block until phase of the graph is loaded. The graph of gfa_new and
+ * gfa_load_snapshot has all of its phases done.
+ *
+ * @return SUCCESS or the status of the load when it failed or was cancelled
+ * before phase was done
+ */
+status_t gfa_wait(gfa_props *gfa, enum gfa_phase phase);
+
+// true once the load is done and gfa_load_wait will not block
+bool gfa_load_poll(const struct gfa_load *load);
+
+void gfa_load_progress(const struct gfa_load *load, struct gfa_progress *out);
+
+// ask the load to stop, it does so at the next check of its workers
+void gfa_load_cancel(struct gfa_load *load);
+
+/**
+ * Wait for the load to finish and release it
+ *
+ * @return the graph as gfa_new would return it or NULL when the load was
+ * cancelled before it finished
+ */
+gfa_props *gfa_load_wait(struct gfa_load **load);
+
+/*
+ * Batch loading
+ * -------------
+ */
+
+// the budget gfa_new_batch loads under
+struct gfa_batch_opts {
+	u32 thread_count; // workers for all the files, 0 for one per processor
+	u64 mem_budget;	  // bytes of GFA files loading at once, 0 for no limit
+};
+
+/**
+ * Load the count files of confs on one pool of workers in place of a thread
+ * per line type per file. Each file is indexed, then its S, L and ref lines
+ * are parsed as separate tasks, the S and L lines of large files in chunks
+ * that run side by side, then its loci and indexes are set. Files start
+ * biggest first for as long as their sizes fit in mem_budget, one is always
+ * let in. opts may be NULL for the defaults.
+ *
+ * @return SUCCESS with gfas[i] the graph of confs[i] as gfa_new would return
+ * it, or an error with no graphs
+ */
+status_t gfa_new_batch(const gfa_config *confs, idx_t count,
+		       const struct gfa_batch_opts *opts, gfa_props **gfas);
+
+/*
+ * Load metrics
+ * ------------
+ * Every load records the wall and cpu time, the bytes and lines, the threads,
+ * the allocations and the page faults of each of its phases in the metrics
+ * of its graph. It is a few clock reads per phase and a count per arena
+ * allocation, so it is always on.
+ */
+
+// a table of the phases to fp, SUCCESS unless writing fails
+status_t gfa_metrics_print(const struct gfa_metrics *m, FILE *fp);
+
+// the same as one JSON object, the phases keyed by to_string_gfa_metric
+status_t gfa_metrics_json(const struct gfa_metrics *m, FILE *fp);
+
 void gfa_free(gfa_props *c);
 
 #ifdef __cplusplus
@@ -107,11 +654,20 @@ void gfa_free(gfa_props *c);
 // initializers https://cplusplus.com/forum/general/285267/
 struct gfa_config_cpp : gfa_config {
 	gfa_config_cpp(const char *fp_, bool inc_vtx_labels_ = false,
-		       bool inc_refs_ = false)
+		       bool inc_refs_ = false, bool inc_occ_index_ = false,
+		       u32 thread_count_ = 0, bool inc_stats_ = false,
+		       bool use_line_index_ = false)
 	{
 		fp = fp_;
 		inc_vtx_labels = inc_vtx_labels_;
 		inc_refs = inc_refs_;
+		inc_occ_index = inc_occ_index_;
+		thread_count = thread_count_;
+		inc_stats = inc_stats_;
+		use_line_index = use_line_index_;
+		ref_filter = NULL;
+		v_lo = 0;
+		v_hi = 0;
 	}
 };
 
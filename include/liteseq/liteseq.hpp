@@ -0,0 +1,580 @@
+#ifndef LQ_LITESEQ_HPP
+#define LQ_LITESEQ_HPP
+
+/*
+ * C++17 layer over the C API
+ * --------------------------
+ * Graph owns a gfa_props and frees it, everything else is a view into the
+ * graph that copies nothing and lives no longer than the Graph it came from.
+ * The iterators are thin wrappers over the pointers of the C structs.
+ */
+
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "./gfa.h"
+#include "./refs.h"
+#include "./types.h"
+
+namespace liteseq
+{
+
+// a read only view of n contiguous T, a stand in for std::span
+template <typename T> class Span
+{
+    public:
+	using value_type = T;
+	using iterator = const T *;
+
+	constexpr Span() noexcept = default;
+	constexpr Span(const T *data, std::size_t size) noexcept
+	    : data_(data), size_(size)
+	{
+	}
+
+	constexpr const T *begin() const noexcept { return data_; }
+	constexpr const T *end() const noexcept { return data_ + size_; }
+	constexpr const T *data() const noexcept { return data_; }
+	constexpr std::size_t size() const noexcept { return size_; }
+	constexpr bool empty() const noexcept { return size_ == 0; }
+	constexpr const T &operator[](std::size_t i) const noexcept
+	{
+		return data_[i];
+	}
+
+    private:
+	const T *data_ = nullptr;
+	std::size_t size_ = 0;
+};
+
+inline std::string_view to_view(const char *s) noexcept
+{
+	return s ? std::string_view(s) : std::string_view();
+}
+
+/*
+ * Vertices
+ * --------
+ */
+
+struct Vertex {
+	id_t id;
+	std::string_view label; // empty without inc_vtx_labels
+};
+
+// the vertices with an S line in order of id, skipping the unused ids
+class VertexRange
+{
+    public:
+	class iterator
+	{
+	    public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = Vertex;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = Vertex;
+
+		iterator(vtx *const *p, vtx *const *end) noexcept
+		    : p_(p), end_(end)
+		{
+			skip();
+		}
+
+		Vertex operator*() const noexcept
+		{
+			return Vertex{(*p_)->id, to_view((*p_)->seq)};
+		}
+
+		iterator &operator++() noexcept
+		{
+			++p_;
+			skip();
+			return *this;
+		}
+
+		iterator operator++(int) noexcept
+		{
+			iterator it = *this;
+			++*this;
+			return it;
+		}
+
+		bool operator==(const iterator &o) const noexcept
+		{
+			return p_ == o.p_;
+		}
+		bool operator!=(const iterator &o) const noexcept
+		{
+			return p_ != o.p_;
+		}
+
+	    private:
+		void skip() noexcept
+		{
+			while (p_ != end_ && *p_ == nullptr)
+				++p_;
+		}
+
+		vtx *const *p_;
+		vtx *const *end_;
+	};
+
+	VertexRange(vtx *const *v, std::size_t size) noexcept
+	    : v_(v), size_(size)
+	{
+	}
+
+	iterator begin() const noexcept { return {v_, v_ + size_}; }
+	iterator end() const noexcept { return {v_ + size_, v_ + size_}; }
+
+    private:
+	vtx *const *v_;
+	std::size_t size_;
+};
+
+/*
+ * Walks
+ * -----
+ */
+
+struct Step {
+	id_t v_id;
+	enum strand strand;
+};
+
+// the steps of a walk, the ids and the strands are read side by side
+class WalkRange
+{
+    public:
+	class iterator
+	{
+	    public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = Step;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = Step;
+
+		iterator(const id_t *v_ids, const enum strand *strands) noexcept
+		    : v_ids_(v_ids), strands_(strands)
+		{
+		}
+
+		Step operator*() const noexcept
+		{
+			return Step{*v_ids_, *strands_};
+		}
+		Step operator[](difference_type i) const noexcept
+		{
+			return Step{v_ids_[i], strands_[i]};
+		}
+
+		iterator &operator++() noexcept
+		{
+			++v_ids_;
+			++strands_;
+			return *this;
+		}
+		iterator operator++(int) noexcept
+		{
+			iterator it = *this;
+			++*this;
+			return it;
+		}
+		iterator &operator--() noexcept
+		{
+			--v_ids_;
+			--strands_;
+			return *this;
+		}
+		iterator operator--(int) noexcept
+		{
+			iterator it = *this;
+			--*this;
+			return it;
+		}
+		iterator &operator+=(difference_type n) noexcept
+		{
+			v_ids_ += n;
+			strands_ += n;
+			return *this;
+		}
+		iterator &operator-=(difference_type n) noexcept
+		{
+			v_ids_ -= n;
+			strands_ -= n;
+			return *this;
+		}
+		iterator operator+(difference_type n) const noexcept
+		{
+			return iterator(v_ids_ + n, strands_ + n);
+		}
+		friend iterator operator+(difference_type n,
+					  const iterator &it) noexcept
+		{
+			return it + n;
+		}
+		iterator operator-(difference_type n) const noexcept
+		{
+			return iterator(v_ids_ - n, strands_ - n);
+		}
+		difference_type operator-(const iterator &o) const noexcept
+		{
+			return v_ids_ - o.v_ids_;
+		}
+
+		bool operator==(const iterator &o) const noexcept
+		{
+			return v_ids_ == o.v_ids_;
+		}
+		bool operator!=(const iterator &o) const noexcept
+		{
+			return v_ids_ != o.v_ids_;
+		}
+		bool operator<(const iterator &o) const noexcept
+		{
+			return v_ids_ < o.v_ids_;
+		}
+		bool operator>(const iterator &o) const noexcept
+		{
+			return v_ids_ > o.v_ids_;
+		}
+		bool operator<=(const iterator &o) const noexcept
+		{
+			return v_ids_ <= o.v_ids_;
+		}
+		bool operator>=(const iterator &o) const noexcept
+		{
+			return v_ids_ >= o.v_ids_;
+		}
+
+	    private:
+		const id_t *v_ids_;
+		const enum strand *strands_;
+	};
+
+	WalkRange(const id_t *v_ids, const enum strand *strands,
+		  std::size_t size) noexcept
+	    : v_ids_(v_ids), strands_(strands), size_(size)
+	{
+	}
+
+	iterator begin() const noexcept { return {v_ids_, strands_}; }
+	iterator end() const noexcept
+	{
+		return {v_ids_ + size_, strands_ + size_};
+	}
+	std::size_t size() const noexcept { return size_; }
+	Step operator[](std::size_t i) const noexcept
+	{
+		return Step{v_ids_[i], strands_[i]};
+	}
+
+    private:
+	const id_t *v_ids_;
+	const enum strand *strands_;
+	std::size_t size_;
+};
+
+/*
+ * Refs
+ * ----
+ */
+
+class Ref
+{
+    public:
+	explicit Ref(const struct ref *r) noexcept : r_(r) {}
+
+	const struct ref *get() const noexcept { return r_; }
+
+	std::string_view tag() const noexcept { return to_view(get_tag(r_)); }
+	std::string_view sample() const noexcept
+	{
+		return to_view(get_sample_name(r_));
+	}
+	std::string_view contig() const noexcept
+	{
+		return to_view(get_contig_name(r_));
+	}
+	idx_t hap_id() const noexcept { return get_hap_id(r_); }
+	enum gfa_line_prefix line_prefix() const noexcept
+	{
+		return get_line_prefix(r_);
+	}
+
+	idx_t step_count() const noexcept { return get_step_count(r_); }
+	idx_t hap_len() const noexcept { return get_hap_len(r_); }
+
+	WalkRange steps() const noexcept
+	{
+		return {get_walk_v_ids(r_), get_walk_strands(r_),
+			step_count()};
+	}
+	Span<id_t> v_ids() const noexcept
+	{
+		return {get_walk_v_ids(r_), step_count()};
+	}
+	Span<enum strand> strands() const noexcept
+	{
+		return {get_walk_strands(r_), step_count()};
+	}
+	// empty unless the loci are set
+	Span<idx_t> loci() const noexcept
+	{
+		const idx_t *loci = get_walk_loci(r_);
+		return {loci, loci ? step_count() : 0};
+	}
+
+	// see ref_locate, the step is NULL_IDX when pos is out of bounds
+	struct ref_locus locate(idx_t pos) const noexcept
+	{
+		struct ref_locus l = {NULL_IDX, NULL_ID, NULL_IDX};
+		ref_locate(r_, pos, &l);
+		return l;
+	}
+
+    private:
+	const struct ref *r_;
+};
+
+class RefRange
+{
+    public:
+	class iterator
+	{
+	    public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = Ref;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = Ref;
+
+		explicit iterator(struct ref *const *p) noexcept : p_(p) {}
+
+		Ref operator*() const noexcept { return Ref(*p_); }
+		Ref operator[](difference_type i) const noexcept
+		{
+			return Ref(p_[i]);
+		}
+
+		iterator &operator++() noexcept
+		{
+			++p_;
+			return *this;
+		}
+		iterator operator++(int) noexcept
+		{
+			iterator it = *this;
+			++p_;
+			return it;
+		}
+		iterator &operator--() noexcept
+		{
+			--p_;
+			return *this;
+		}
+		iterator operator--(int) noexcept
+		{
+			iterator it = *this;
+			--p_;
+			return it;
+		}
+		iterator &operator+=(difference_type n) noexcept
+		{
+			p_ += n;
+			return *this;
+		}
+		iterator &operator-=(difference_type n) noexcept
+		{
+			p_ -= n;
+			return *this;
+		}
+		iterator operator+(difference_type n) const noexcept
+		{
+			return iterator(p_ + n);
+		}
+		friend iterator operator+(difference_type n,
+					  const iterator &it) noexcept
+		{
+			return it + n;
+		}
+		iterator operator-(difference_type n) const noexcept
+		{
+			return iterator(p_ - n);
+		}
+		difference_type operator-(const iterator &o) const noexcept
+		{
+			return p_ - o.p_;
+		}
+
+		bool operator==(const iterator &o) const noexcept
+		{
+			return p_ == o.p_;
+		}
+		bool operator!=(const iterator &o) const noexcept
+		{
+			return p_ != o.p_;
+		}
+		bool operator<(const iterator &o) const noexcept
+		{
+			return p_ < o.p_;
+		}
+		bool operator>(const iterator &o) const noexcept
+		{
+			return p_ > o.p_;
+		}
+		bool operator<=(const iterator &o) const noexcept
+		{
+			return p_ <= o.p_;
+		}
+		bool operator>=(const iterator &o) const noexcept
+		{
+			return p_ >= o.p_;
+		}
+
+	    private:
+		struct ref *const *p_;
+	};
+
+	RefRange(struct ref *const *refs, std::size_t size) noexcept
+	    : refs_(refs), size_(size)
+	{
+	}
+
+	iterator begin() const noexcept { return iterator(refs_); }
+	iterator end() const noexcept { return iterator(refs_ + size_); }
+	std::size_t size() const noexcept { return size_; }
+	Ref operator[](std::size_t i) const noexcept { return Ref(refs_[i]); }
+
+    private:
+	struct ref *const *refs_;
+	std::size_t size_;
+};
+
+/*
+ * Graph
+ * -----
+ */
+
+class Graph
+{
+    public:
+	// parse the GFA file of conf, throws std::runtime_error on failure
+	explicit Graph(const gfa_config &conf) : g_(gfa_new(&conf))
+	{
+		check("failed to parse ", conf.fp);
+	}
+
+	// take ownership of a graph from the C API
+	explicit Graph(gfa_props *g) noexcept : g_(g) {}
+
+	// map a snapshot written by save_snapshot
+	static Graph load_snapshot(const std::string &fp)
+	{
+		Graph g(gfa_load_snapshot(fp.c_str()));
+		g.check("failed to load the snapshot ", fp.c_str());
+		return g;
+	}
+
+	Graph(const Graph &) = delete;
+	Graph &operator=(const Graph &) = delete;
+
+	Graph(Graph &&o) noexcept : g_(std::exchange(o.g_, nullptr)) {}
+	Graph &operator=(Graph &&o) noexcept
+	{
+		if (this != &o) {
+			reset();
+			g_ = std::exchange(o.g_, nullptr);
+		}
+		return *this;
+	}
+
+	~Graph() { reset(); }
+
+	gfa_props *get() const noexcept { return g_; }
+	gfa_props *release() noexcept { return std::exchange(g_, nullptr); }
+	explicit operator bool() const noexcept { return g_ != nullptr; }
+
+	VertexRange vertices() const noexcept
+	{
+		return {g_->v, g_->vtx_arr_size};
+	}
+	Span<edge> edges() const noexcept { return {g_->e, g_->l_line_count}; }
+	RefRange refs() const noexcept
+	{
+		return {g_->refs, g_->inc_refs ? g_->ref_count : 0};
+	}
+
+	// the label of v_id, empty if it has none or there is no such vertex
+	std::string_view label(id_t v_id) const noexcept
+	{
+		u32 slot = gfa_vtx_slot(g_, v_id);
+		if (slot >= g_->vtx_arr_size || !g_->v[slot])
+			return {};
+		return to_view(g_->v[slot]->seq);
+	}
+
+	// the index of the ref with the tag, NULL_IDX when there is none
+	idx_t find_ref(const std::string &tag) const noexcept
+	{
+		return find_ref_by_tag(g_, tag.c_str());
+	}
+
+	// the steps through v_id, empty without the occurrence index
+	Span<struct vtx_occ> occurrences(id_t v_id) const noexcept
+	{
+		idx_t n = 0;
+		const struct vtx_occ *o = get_vtx_occs(g_, v_id, &n);
+		return {o, n};
+	}
+
+	std::string haplotype(const Ref &r) const
+	{
+		std::string s(r.hap_len() + 1, NULL_CHAR);
+		if (ref_get_haplotype(g_, r.get(), &s[0]) != SUCCESS)
+			throw std::runtime_error("failed to get the haplotype");
+		s.pop_back();
+		return s;
+	}
+
+	void save_snapshot(const std::string &fp) const
+	{
+		if (gfa_save_snapshot(g_, fp.c_str()) != SUCCESS)
+			throw std::runtime_error("failed to save " + fp);
+	}
+
+	void write(const std::string &fp,
+		   const struct gfa_write_opts *opts = nullptr) const
+	{
+		if (gfa_write(g_, fp.c_str(), opts) != SUCCESS)
+			throw std::runtime_error("failed to write " + fp);
+	}
+
+    private:
+	void reset() noexcept
+	{
+		if (g_)
+			gfa_free(g_);
+		g_ = nullptr;
+	}
+
+	void check(const char *what, const char *fp)
+	{
+		if (g_ && g_->status == SUCCESS)
+			return;
+		reset();
+		throw std::runtime_error(std::string(what) + (fp ? fp : ""));
+	}
+
+	gfa_props *g_;
+};
+
+} // namespace liteseq
+
+#endif // LQ_LITESEQ_HPP
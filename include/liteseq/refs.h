@@ -20,9 +20,14 @@ namespace liteseq
 
 /* ref name related types */
 struct pansn {
-	char *sample_name;
+	const char *sample_name;
 	id_t hap_id;
-	char *contig_name;
+	const char *contig_name;
+
+	// handles of the names in the graph's name pool so that refs can be
+	// grouped by comparing integers. NULL_ID when names are not interned
+	id_t sample_id;
+	id_t contig_id;
 };
 
 enum ref_id_type {
@@ -50,6 +55,11 @@ struct ref_id {
 };
 
 /* ref walk related types */
+
+// every LOCI_SAMPLE_RATE-th locus is in the positional index, 16 loci fill a
+// 64 byte cache line
+#define LOCI_SAMPLE_RATE 16
+
 struct ref_walk {
 	// the actual walk
 	enum strand *strands;
@@ -58,6 +68,52 @@ struct ref_walk {
 	// walk metadata
 	idx_t step_count; // the number of steps
 	idx_t hap_len;	  // the length of the haplotype in bases
+	// the step of the whole walk that is the first step here, 0 unless a
+	// partial load cut the walk down
+	idx_t first_step;
+
+	// positional index over every LOCI_SAMPLE_RATE-th locus, stored in
+	// Eytzinger (BFS) order from index 1. NULL until the loci are set
+	idx_t *eytz;	   // sampled loci
+	idx_t *eytz_rank;  // the sample number of each entry in eytz
+	idx_t eytz_count;  // the number of samples
+};
+
+/* the step covering a position in a ref, see ref_locate */
+struct ref_locus {
+	idx_t step;   // the index of the step in the walk
+	id_t v_id;    // the vertex of that step
+	idx_t offset; // 0 based offset of the position into the step
+};
+
+/*
+ * ref filter, see ref_filter in gfa_config
+ */
+
+// the name columns of a P or W line as they are in the file
+struct ref_names {
+	enum gfa_line_prefix line_prefix;
+	const char *sample; // the whole name of a P line that is not PanSN
+	idx_t sample_len;
+	id_t hap_id;	    // NULL_ID when the name is not PanSN
+	const char *contig; // NULL when the name is not PanSN
+	idx_t contig_len;
+	const char *name;   // the whole name of a P line, NULL for a W line
+	idx_t name_len;
+};
+
+// the refs to load, a ref is loaded when all that is set holds for it
+struct ref_filter {
+	const char *sample;
+	const char *contig;
+	bool by_hap_id; // hap_id is set
+	id_t hap_id;
+	const char *tag_prefix;
+
+	// keep the refs for which keep is true, the names are not null
+	// terminated and keep may be called from any thread
+	bool (*keep)(const struct ref_names *names, void *data);
+	void *data;
 };
 
 /* ref itself */
@@ -68,6 +124,8 @@ struct ref {
 };
 struct ref *parse_ref_line(enum gfa_line_prefix line_type, const char *line,
 			   u32 len);
+// only for refs from parse_ref_line, refs owned by a gfa_props are released
+// by gfa_free
 void destroy_ref(struct ref **r);
 
 /*
@@ -81,6 +139,8 @@ const char *get_tag(const struct ref *r);
 const char *get_sample_name(const struct ref *r);
 idx_t get_hap_id(const struct ref *r);
 const char *get_contig_name(const struct ref *r);
+id_t get_sample_id(const struct ref *r);
+id_t get_contig_id(const struct ref *r);
 enum gfa_line_prefix get_line_prefix(const struct ref *r);
 enum ref_id_type get_ref_id_type(const struct ref *r);
 
@@ -90,6 +150,31 @@ status_t set_hap_len(struct ref *r, idx_t hap_len);
 idx_t get_step_count(const struct ref *r);
 const id_t *get_walk_v_ids(const struct ref *r);
 const enum strand *get_walk_strands(const struct ref *r);
+const idx_t *get_walk_loci(const struct ref *r);
+idx_t get_first_step(const struct ref *r);
+
+/*
+ * ---------------------
+ * Positional queries
+ * ---------------------
+ * Require the loci to be set i.e. a gfa_new with both inc_vtx_labels and
+ * inc_refs. Positions are 1 based like the loci.
+ */
+
+/**
+ * Find the step that covers base pos of the ref
+ *
+ * @return SUCCESS, ERROR_CODE_OUT_OF_BOUNDS when pos is not in [1, hap_len]
+ * or ERROR_CODE_INVALID_ARGUMENT when the ref has no positional index
+ */
+status_t ref_locate(const struct ref *r, idx_t pos, struct ref_locus *out);
+
+/**
+ * ref_locate for n positions at once, interleaving the searches so that their
+ * memory accesses overlap. Positions out of bounds get a step of NULL_IDX.
+ */
+status_t ref_locate_batch(const struct ref *r, const idx_t *pos, idx_t n,
+			  struct ref_locus *out);
 
 #ifdef __cplusplus
 } // namespace liteseq
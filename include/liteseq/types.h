@@ -19,6 +19,7 @@ typedef uint8_t byte;
 typedef uint32_t idx_t;
 typedef uint32_t id_t;
 typedef uint32_t u32;
+typedef uint64_t u64;
 typedef int8_t status_t;
 
 /*
@@ -55,6 +56,7 @@ typedef enum {
 	ERROR_CODE_INVALID_ARGUMENT = -7,
 	ERROR_CODE_NOT_FOUND = -10,
 	ERROR_CODE_NOT_IMPLEMENTED = -15,
+	ERROR_CODE_CANCELLED = -16,
 	ERROR_CODE_UNKNOWN = -17
 } ERROR_CODE;
 
@@ -13,12 +13,22 @@
 
 #include "../include/liteseq/gfa.h"
 #include "../include/liteseq/types.h"
+#include "../src/internal/lq_arena.h"
+#include "../src/internal/lq_intern.h"
 #include "../src/internal/lq_io.h"
 #include "../src/internal/lq_utils.h"
 
+#include "./gfa_impl.h"
 #include "./gfa_l.h"
+#include "./gfa_load.h"
+#include "./gfa_lqi.h"
+#include "./gfa_metrics.h"
+#include "./gfa_occ.h"
 #include "./gfa_s.h"
+#include "./gfa_stats.h"
 #include "./refs/ref_impl.h"
+#include "./refs/ref_lookup.h"
+#include "./refs/ref_pos.h"
 
 #include <log.h>
 
@@ -34,6 +44,11 @@
 
 #define H_LINE_VERSION_IDX 1 // the index of the version token in the H line
 
+// the columns of the vertex ids of S and L lines
+#define S_LINE_V_ID_COL 1
+#define L_LINE_V1_ID_COL 1
+#define L_LINE_V2_ID_COL 3
+
 DEFINE_ENUM_AND_STRING(gfa_version, GFA_VERSION_ITEMS)
 
 /*
@@ -126,6 +141,14 @@ status_t analyse_gfa_structure(gfa_props *g)
 
 	char *curr_char = g->start;
 	while (curr_char < g->end) {
+		if (g->load && curr_line % GFA_LOAD_CHECK_LINES == 0) {
+			__atomic_store_n(&g->load->progress.bytes_scanned,
+					 (u64)(curr_char - g->start),
+					 __ATOMIC_RELAXED);
+			if (gfa_load_cancelled(g->load))
+				return ERROR_CODE_CANCELLED;
+		}
+
 		// Find the next newline
 		char *newline = memchr(curr_char, NEWLINE, g->end - curr_char);
 		// If no newline is found, process the remainder of the file
@@ -169,11 +192,85 @@ status_t analyse_gfa_structure(gfa_props *g)
 
 	// assumes at least one vertex found
 	// TODO: [c] is that a safe assumption?
-	g->vtx_arr_size = g->max_v_id + 1;
+	g->vtx_arr_size = gfa_vtx_arr_size(g);
 
 	return 0;
 }
 
+u32 gfa_vtx_arr_size(const gfa_props *gfa)
+{
+	u64 end = (u64)gfa->max_v_id + 1;
+	if (end > gfa->v_hi)
+		end = gfa->v_hi;
+
+	return end > gfa->v_lo ? (u32)(end - gfa->v_lo) : 0;
+}
+
+static inline bool in_v_range(const gfa_props *gfa, id_t v_id)
+{
+	return gfa_vtx_slot(gfa, v_id) < gfa->v_hi - gfa->v_lo;
+}
+
+// the vertex id in column col of a line, NULL_ID if the line is shorter
+static id_t line_v_id(const line *l, idx_t col)
+{
+	const char *c = l->start;
+	const char *end = l->start + l->len;
+	for (idx_t i = 0; i < col; i++) {
+		c = memchr(c, TAB_CHAR, end - c);
+		if (!c)
+			return NULL_ID;
+		c++;
+	}
+
+	return (id_t)strtoul(c, NULL, 10);
+}
+
+static bool keeps_line(const gfa_props *gfa, const line *l)
+{
+	switch (l->start[0]) {
+	case GFA_S_LINE:
+		return in_v_range(gfa, line_v_id(l, S_LINE_V_ID_COL));
+	case GFA_L_LINE:
+		return in_v_range(gfa, line_v_id(l, L_LINE_V1_ID_COL)) ||
+		       in_v_range(gfa, line_v_id(l, L_LINE_V2_ID_COL));
+	default:
+		return true;
+	}
+}
+
+idx_t select_v_range_lines(const gfa_props *gfa, line *lines, idx_t count)
+{
+	idx_t kept = 0;
+	for (idx_t i = 0; i < count; i++)
+		if (keeps_line(gfa, &lines[i]))
+			lines[kept++] = lines[i];
+
+	return kept;
+}
+
+// shrink a line table to its first count lines, keeping it if realloc fails
+static void fit_lines(line **lines, idx_t count)
+{
+	line *l = realloc(*lines, sizeof(line) * (count ? count : 1));
+	if (l)
+		*lines = l;
+}
+
+/**
+ * Drop the S and L lines a partial load does not take from the line tables,
+ * so that the graph is allocated for the lines kept
+ */
+static void select_v_range(gfa_props *gfa)
+{
+	gfa->s_line_count =
+		select_v_range_lines(gfa, gfa->s_lines, gfa->s_line_count);
+	gfa->l_line_count =
+		select_v_range_lines(gfa, gfa->l_lines, gfa->l_line_count);
+	fit_lines(&gfa->s_lines, gfa->s_line_count);
+	fit_lines(&gfa->l_lines, gfa->l_line_count);
+}
+
 status_t index_lines(gfa_props *gfa)
 {
 	idx_t s_idx = 0;
@@ -199,6 +296,13 @@ status_t index_lines(gfa_props *gfa)
 	}
 
 	while (curr_char < gfa->end) {
+		if (gfa->load && line_count % GFA_LOAD_CHECK_LINES == 0) {
+			gfa_load_publish(&gfa->load->progress.lines_indexed,
+					 s_idx + l_idx + p_idx + w_idx);
+			if (gfa_load_cancelled(gfa->load))
+				return ERROR_CODE_CANCELLED;
+		}
+
 		// Find the next newline
 		newline = memchr(curr_char, NEWLINE, gfa->end - curr_char);
 		// If no newline is found, process the remainder of the file
@@ -241,54 +345,151 @@ status_t index_lines(gfa_props *gfa)
 	return 0;
 }
 
-status_t set_ref_loci(gfa_props *gfa)
+status_t set_ref_loci(gfa_props *gfa, idx_t first_ref)
 {
 	vtx **vs = gfa->v;
 	if (vs == NULL)
 		return ERROR_CODE_INVALID_ARGUMENT;
 
-	for (int i = 0; i < gfa->ref_count; i++) {
+	// the refs thread is done with its arena by now
+	struct lq_arena *arena = gfa->arenas[GFA_ARENA_REFS];
+
+	for (idx_t i = first_ref; i < gfa->ref_count; i++) {
 		struct ref *r = gfa->refs[i];
 		struct ref_walk *rw = r->walk;
 		idx_t pos = 1; // DNA is 1 indexed
 		for (int j = 0; j < rw->step_count; j++) {
 			rw->loci[j] = pos;
-			idx_t v_id = rw->v_ids[j];
+			u32 slot = gfa_vtx_slot(gfa, rw->v_ids[j]);
 
-			if (vs[v_id] == NULL) {
+			// no S line
+			if (slot >= gfa->vtx_arr_size || vs[slot] == NULL) {
 				continue;
 			}
-			idx_t l = pos += strlen(vs[v_id]->seq);
+			pos += strlen(vs[slot]->seq);
 		}
 		set_hap_len(r, pos - 1);
+
+		status_t res = build_ref_pos_index(r, arena);
+		if (res != SUCCESS)
+			return res;
 	}
 
 	return SUCCESS;
 }
 
+const char *get_pansn_name(const gfa_props *gfa, id_t name_id)
+{
+	return lq_intern_get(gfa->names, name_id);
+}
+
+id_t find_pansn_name(const gfa_props *gfa, const char *name)
+{
+	if (!name)
+		return NULL_ID;
+
+	return lq_intern_find(gfa->names, name, strlen(name));
+}
+
+idx_t find_ref_by_tag(const gfa_props *gfa, const char *tag)
+{
+	if (!gfa->ref_lookup || !tag)
+		return NULL_IDX;
+
+	return ref_lookup_tag(gfa->ref_lookup, gfa->refs, tag);
+}
+
+idx_t find_ref_by_pansn(const gfa_props *gfa, const char *sample_name,
+			id_t hap_id, const char *contig_name)
+{
+	if (!gfa->ref_lookup)
+		return NULL_IDX;
+
+	id_t sample_id = find_pansn_name(gfa, sample_name);
+	id_t contig_id = find_pansn_name(gfa, contig_name);
+	if (sample_id == NULL_ID || contig_id == NULL_ID)
+		return NULL_IDX;
+
+	return ref_lookup_pansn(gfa->ref_lookup, gfa->refs, sample_id, hap_id,
+				contig_id);
+}
+
+static const idx_t *get_name_refs(const gfa_props *gfa, const idx_t *offsets,
+				  const idx_t *list, id_t name_id,
+				  idx_t *count)
+{
+	*count = 0;
+	if (!gfa->ref_lookup || name_id >= gfa->ref_lookup->name_count)
+		return NULL;
+
+	*count = offsets[name_id + 1] - offsets[name_id];
+
+	return *count > 0 ? list + offsets[name_id] : NULL;
+}
+
+const idx_t *get_sample_refs(const gfa_props *gfa, id_t sample_id,
+			     idx_t *count)
+{
+	const struct ref_lookup *l = gfa->ref_lookup;
+	return get_name_refs(gfa, l ? l->sample_offsets : NULL,
+			     l ? l->sample_refs : NULL, sample_id, count);
+}
+
+const idx_t *get_contig_refs(const gfa_props *gfa, id_t contig_id,
+			     idx_t *count)
+{
+	const struct ref_lookup *l = gfa->ref_lookup;
+	return get_name_refs(gfa, l ? l->contig_offsets : NULL,
+			     l ? l->contig_refs : NULL, contig_id, count);
+}
+
 status_t populate_gfa(gfa_props *gfa)
 {
 	pthread_t thread_s, thread_l, thread_p;
 
+	// the workers fill their own accumulators as they parse
+	u32 *seg_lens = NULL;
+	struct l_stats_acc l_stats = {.side_deg = NULL};
+	if (gfa->inc_stats &&
+	    alloc_stats_acc(gfa, &seg_lens, &l_stats) != SUCCESS)
+		return ERROR_CODE_OUT_OF_MEMORY;
+
 	struct s_thread_meta s_meta = {
+		.arena = gfa->arenas[GFA_ARENA_S],
 		.vertices = gfa->v,
+		.v_lo = gfa->v_lo,
 		.s_lines = gfa->s_lines,
 		.s_line_count = gfa->s_line_count,
 		.inc_vtx_labels = gfa->inc_vtx_labels,
+		.seg_lens = seg_lens,
+		.load = gfa->load,
+		.metrics = &gfa->metrics.phases[GFA_METRIC_S],
 	};
 
 	struct l_thread_meta l_meta = {
 		.edges = gfa->e,
 		.l_lines = gfa->l_lines,
 		.l_line_count = gfa->l_line_count,
+		.stats = gfa->inc_stats ? &l_stats : NULL,
+		.load = gfa->load,
+		.metrics = &gfa->metrics.phases[GFA_METRIC_L],
 	};
 
 	struct ref_thread_data ref_meta = {
-		.refs = gfa->refs,
+		.arena = gfa->arenas[GFA_ARENA_REFS],
+		.names = gfa->names,
+		.refs = &gfa->refs,
+		.lookup = &gfa->ref_lookup,
 		.p_lines = gfa->p_lines,
 		.w_lines = gfa->w_lines,
 		.p_line_count = gfa->p_line_count,
 		.w_line_count = gfa->w_line_count,
+		.filter = gfa->ref_filter,
+		.v_lo = gfa->v_lo,
+		.v_hi = gfa->v_hi,
+		.ref_count = &gfa->ref_count,
+		.load = gfa->load,
+		.metrics = &gfa->metrics.phases[GFA_METRIC_REFS],
 	};
 
 	if (pthread_create(&thread_s, NULL, t_handle_s, (void *)&s_meta) != 0)
@@ -303,6 +504,8 @@ status_t populate_gfa(gfa_props *gfa)
 		if (pthread_create(&thread_p, NULL, t_handle_p,
 				   (void *)&ref_meta) != 0)
 			return FAILURE; // Failed to create thread for P lines
+	} else {
+		gfa_phase_done(gfa->load, GFA_PHASE_REFS);
 	}
 
 	// TODO: what if one of the threads fails and returns early
@@ -312,12 +515,77 @@ status_t populate_gfa(gfa_props *gfa)
 	if (gfa->inc_refs)
 		pthread_join(thread_p, NULL);
 
+	// the workers stopped short, what they parsed is freed with the arenas
+	if (gfa_load_cancelled(gfa->load)) {
+		free(seg_lens);
+		free(l_stats.side_deg);
+		return ERROR_CODE_CANCELLED;
+	}
+
+	return finish_gfa(gfa, &seg_lens, &l_stats);
+}
+
+status_t finish_gfa(gfa_props *gfa, u32 **seg_lens,
+		    struct l_stats_acc *l_stats)
+{
+	gfa_load_set_stage(gfa->load, GFA_LOAD_FINISH);
+
+	struct gfa_phase_metrics *phases = gfa->metrics.phases;
+	struct gfa_metrics_clock clock;
+
 	if (gfa->inc_refs && gfa->inc_vtx_labels) {
-		status_t res = set_ref_loci(gfa);
+		gfa_metrics_start(&clock, &phases[GFA_METRIC_LOCI],
+				  gfa->arenas[GFA_ARENA_REFS], 0);
+		status_t res = set_ref_loci(gfa, 0);
 		if (res != SUCCESS) {
 			log_fatal("Failed to set reference loci");
 			return res;
 		}
+		clock.lines = gfa->ref_count;
+		gfa_metrics_stop(&clock);
+	}
+	gfa_phase_done(gfa->load, GFA_PHASE_LOCI);
+
+	if (gfa->inc_stats) {
+		gfa_metrics_start(&clock, &phases[GFA_METRIC_STATS], NULL, 0);
+		status_t res = finalize_gfa_stats(gfa, seg_lens, l_stats);
+		if (res != SUCCESS) {
+			log_fatal("Failed to collect the graph statistics");
+			return res;
+		}
+		gfa_metrics_stop(&clock);
+	}
+
+	if (gfa_load_cancelled(gfa->load))
+		return ERROR_CODE_CANCELLED;
+
+	if (gfa->inc_refs && gfa->inc_occ_index) {
+		gfa_metrics_start(&clock, &phases[GFA_METRIC_OCC], NULL,
+				  gfa->thread_count);
+		status_t res = gfa_build_occ_index(gfa);
+		if (res != SUCCESS) {
+			log_fatal("Failed to build the occurrence index");
+			return res;
+		}
+		clock.lines = gfa->ref_count;
+		gfa_metrics_stop(&clock);
+	}
+	gfa_metrics_close(&gfa->metrics);
+
+	return SUCCESS;
+}
+
+// the arenas the vertices, labels and refs are allocated from
+status_t alloc_gfa_arenas(gfa_props *p)
+{
+	p->arenas = calloc(GFA_ARENA_COUNT, sizeof(struct lq_arena *));
+	if (!p->arenas)
+		return ERROR_CODE_OUT_OF_MEMORY;
+	p->arena_count = GFA_ARENA_COUNT;
+	for (idx_t i = 0; i < GFA_ARENA_COUNT; i++) {
+		p->arenas[i] = lq_arena_new(LQ_ARENA_BLOCK_SIZE);
+		if (!p->arenas[i])
+			return ERROR_CODE_OUT_OF_MEMORY;
 	}
 
 	return SUCCESS;
@@ -328,7 +596,11 @@ status_t populate_gfa(gfa_props *gfa)
  */
 status_t preallocate_gfa(gfa_props *p)
 {
-	p->v = calloc(p->vtx_arr_size, sizeof(vtx *));
+	status_t res = alloc_gfa_arenas(p);
+	if (res != SUCCESS)
+		return res;
+
+	p->v = calloc(p->vtx_arr_size ? p->vtx_arr_size : 1, sizeof(vtx *));
 	// p->v = malloc(sizeof(vtx) * p->vtx_arr_size);
 	if (!p->v)
 		return ERROR_CODE_OUT_OF_MEMORY;
@@ -337,7 +609,7 @@ status_t preallocate_gfa(gfa_props *p)
 	// memset(p->v, 0, sizeof(vtx) * p->vtx_arr_size);
 	// if (p->inc_vtx_labels) {}
 
-	p->e = malloc(p->l_line_count * sizeof(edge));
+	p->e = malloc((p->l_line_count ? p->l_line_count : 1) * sizeof(edge));
 	if (!p->e)
 		return ERROR_CODE_OUT_OF_MEMORY;
 
@@ -346,6 +618,10 @@ status_t preallocate_gfa(gfa_props *p)
 		p->refs = malloc(sizeof(struct ref *) * p->ref_count);
 		if (!p->refs)
 			return ERROR_CODE_OUT_OF_MEMORY;
+
+		p->names = lq_intern_new();
+		if (!p->names)
+			return ERROR_CODE_OUT_OF_MEMORY;
 	}
 
 	return SUCCESS;
@@ -358,6 +634,13 @@ gfa_props *init_gfa(const gfa_config *conf)
 	p->fp = conf->fp;
 	p->inc_vtx_labels = conf->inc_vtx_labels;
 	p->inc_refs = conf->inc_refs;
+	p->inc_occ_index = conf->inc_occ_index;
+	p->inc_stats = conf->inc_stats;
+	p->use_line_index = conf->use_line_index;
+	p->ref_filter = conf->ref_filter;
+	p->v_lo = conf->v_lo;
+	p->v_hi = conf->v_hi ? conf->v_hi : NULL_ID;
+	p->thread_count = lq_thread_count(conf->thread_count);
 
 	p->start = NULL;
 	p->end = NULL;
@@ -380,59 +663,197 @@ gfa_props *init_gfa(const gfa_config *conf)
 	p->e = NULL;
 	p->refs = NULL;
 
+	p->arenas = NULL;
+	p->arena_count = 0;
+	p->names = NULL;
+	p->ref_lookup = NULL;
+	p->adj_offsets = NULL;
+	p->adj_edges = NULL;
+	p->retired = NULL;
+	p->retired_count = 0;
+	pthread_mutex_init(&p->lock, NULL);
+	p->phases_done = GFA_PHASES_ALL; // gfa_new_async clears them
+	pthread_cond_init(&p->phase_cond, NULL);
+	p->stats = NULL;
+	p->occ_offsets = NULL;
+	p->occs = NULL;
+	p->snapshot = NULL;
+	p->snapshot_size = 0;
+	p->load = NULL;
+	memset(&p->metrics, 0, sizeof(p->metrics));
+
 	p->file_size = 0;
 	p->status = -1;
 
 	return p;
 }
 
-gfa_props *gfa_new(const gfa_config *conf)
+static idx_t line_total(const gfa_props *p)
 {
-	gfa_props *p = init_gfa(conf); // set up the config
-	if (p == NULL) {
-		log_fatal("init gfa failed");
-		return NULL;
-	}
+	return p->s_line_count + p->l_line_count + p->p_line_count +
+	       p->w_line_count;
+}
 
+// the totals of the progress once the lines are counted
+static void publish_line_counts(gfa_props *p)
+{
+	struct gfa_progress *pr = &p->load->progress;
+	gfa_load_publish(&pr->s_line_count, p->s_line_count);
+	gfa_load_publish(&pr->l_line_count, p->l_line_count);
+	gfa_load_publish(&pr->ref_count,
+			 p->inc_refs ? p->p_line_count + p->w_line_count : 0);
+	gfa_load_publish(&pr->line_count, line_total(p));
+}
+
+bool prepare_gfa(gfa_props *p)
+{
 	char *mapped;	      // pointer to the start of the memory mapped file
 	char *end;	      // pointer to the end of the memory mapped file
 	size_t file_size = 0; // size of the memory mapped file
 
 	p->status = -1; // status of a given operation
 
+	if (p->v_hi <= p->v_lo) {
+		log_fatal("No vertex ids in [%u, %u)", p->v_lo, p->v_hi);
+		p->status = ERROR_CODE_INVALID_ARGUMENT;
+		return false;
+	}
+
+	struct gfa_metrics *mx = &p->metrics;
+	struct gfa_metrics_clock clock;
+	mx->start_ns = gfa_metrics_now();
+	mx->thread_count = p->thread_count;
+
+	gfa_metrics_start(&clock, &mx->phases[GFA_METRIC_MAP], NULL, 0);
 	open_mmap(p->fp, &mapped, &file_size);
 	if (mapped == NULL) { // Failed to mmap file
-		return p;
+		return false;
 	}
 	end = mapped + file_size;
+	clock.bytes = file_size;
+	gfa_metrics_stop(&clock);
 
 	p->start = mapped;
 	p->end = end;
 	p->file_size = file_size;
+	mx->file_size = file_size;
+	if (p->load)
+		__atomic_store_n(&p->load->progress.file_size, (u64)file_size,
+				 __ATOMIC_RELAXED);
+
+	// a valid sidecar saves both passes over the file
+	gfa_metrics_start(&clock, &mx->phases[GFA_METRIC_SCAN], NULL, 0);
+	mx->line_index_hit = p->use_line_index && load_line_index(p) == SUCCESS;
+	if (!mx->line_index_hit) {
+		p->status = analyse_gfa_structure(p);
+		if (p->status == ERROR_CODE_CANCELLED)
+			return false;
+		if (p->status != 0) {
+			fprintf(stderr,
+				"Error: GFA file structure analysis failed\n");
+			return false;
+		}
+
+		if (p->s_line_count == 0 && p->l_line_count == 0 &&
+		    p->p_line_count == 0) {
+			fprintf(stderr,
+				"Error: GFA has no vertices edges or paths\n");
+			return false;
+		}
+		clock.bytes = file_size;
+	}
+	clock.lines = line_total(p);
+	gfa_metrics_stop(&clock);
+
+	gfa_metrics_start(&clock, &mx->phases[GFA_METRIC_INDEX], NULL, 0);
+	if (!mx->line_index_hit) {
+		if (p->load) {
+			__atomic_store_n(&p->load->progress.bytes_scanned,
+					 (u64)file_size, __ATOMIC_RELAXED);
+			publish_line_counts(p);
+			gfa_load_set_stage(p->load, GFA_LOAD_INDEX);
+		}
 
-	p->status = analyse_gfa_structure(p);
-	if (p->status != 0) {
-		fprintf(stderr, "Error: GFA file structure analysis failed\n");
-		return p;
+		if (index_lines(p) == ERROR_CODE_CANCELLED) {
+			p->status = ERROR_CODE_CANCELLED;
+			return false;
+		}
+		if (p->use_line_index)
+			save_line_index(p); // only a cache, failing is fine
+		clock.bytes = file_size;
+	} else if (p->load) {
+		__atomic_store_n(&p->load->progress.bytes_scanned,
+				 (u64)file_size, __ATOMIC_RELAXED);
+		publish_line_counts(p);
 	}
+	clock.lines = line_total(p);
 
-	if (p->s_line_count == 0 && p->l_line_count == 0 &&
-	    p->p_line_count == 0) {
-		fprintf(stderr, "Error: GFA has no vertices edges or paths\n");
-		return p;
+	// after the sidecar is saved, it holds the lines of the whole file
+	if (gfa_is_partial(p)) {
+		select_v_range(p);
+		if (p->load)
+			publish_line_counts(p);
 	}
+	gfa_metrics_stop(&clock);
+
+	if (p->load) {
+		gfa_load_publish(&p->load->progress.lines_indexed,
+				 p->load->progress.line_count);
+		gfa_load_set_stage(p->load, GFA_LOAD_PARSE);
+	}
+
+	gfa_metrics_start(&clock, &mx->phases[GFA_METRIC_ALLOC], NULL, 0);
+	p->status = preallocate_gfa(p);
+	if (p->status != SUCCESS) {
+		log_fatal("Failed to allocate memory for the graph");
+		return false;
+	}
+	gfa_metrics_stop(&clock);
+
+	return true;
+}
+
+void load_gfa(gfa_props *p)
+{
+	if (!prepare_gfa(p))
+		return;
 
-	index_lines(p);
-	preallocate_gfa(p);
 	p->status = populate_gfa(p);
-	p->status = 0;
+}
+
+gfa_props *gfa_new(const gfa_config *conf)
+{
+	gfa_props *p = init_gfa(conf); // set up the config
+	if (p == NULL) {
+		log_fatal("init gfa failed");
+		return NULL;
+	}
+
+	load_gfa(p);
 
 	return p;
 }
 
 void gfa_free(gfa_props *gfa)
 {
-	close_mmap(gfa->start, gfa->file_size);
+	if (gfa->start)
+		close_mmap(gfa->start, gfa->file_size);
+
+	// the edges and the occurrence index of a snapshot are in its mapping,
+	// so are the vertex and ref tables of a shared graph
+	if (gfa->snapshot) {
+		const byte *lo = gfa->snapshot;
+		const byte *hi = lo + gfa->snapshot_size;
+		if ((const byte *)gfa->v >= lo && (const byte *)gfa->v <= hi)
+			gfa->v = NULL;
+		if ((const byte *)gfa->refs >= lo &&
+		    (const byte *)gfa->refs <= hi)
+			gfa->refs = NULL;
+		close_mmap(gfa->snapshot, gfa->snapshot_size);
+		gfa->e = NULL;
+		gfa->occ_offsets = NULL;
+		gfa->occs = NULL;
+	}
 
 	if (gfa->s_lines)
 		free(gfa->s_lines);
@@ -449,23 +870,41 @@ void gfa_free(gfa_props *gfa)
 	if (gfa->e)
 		free(gfa->e);
 
-	if (gfa->inc_vtx_labels)
-		for (idx_t i = 0; i < (gfa->max_v_id + 1); i++)
-			if (gfa->v[i] != NULL && gfa->v[i]->seq != NULL)
-				free(gfa->v[i]->seq);
-
-	for (idx_t i = 0; i < gfa->vtx_arr_size; i++)
-		if (gfa->v[i] != NULL)
-			free(gfa->v[i]);
+	// the vertices, labels and refs themselves live in the arenas
 	if (gfa->v)
 		free(gfa->v);
 
-	if (gfa->refs) {
-		for (idx_t i = 0; i < gfa->ref_count; i++)
-			destroy_ref(&(gfa->refs[i]));
-		if (gfa->refs)
-			free(gfa->refs);
-	}
+	if (gfa->refs)
+		free(gfa->refs);
+
+	for (idx_t i = 0; i < gfa->arena_count; i++)
+		lq_arena_destroy(&gfa->arenas[i]);
+	if (gfa->arenas)
+		free(gfa->arenas);
+
+	lq_intern_destroy(&gfa->names);
+
+	if (gfa->stats)
+		free(gfa->stats);
+
+	if (gfa->occ_offsets)
+		free(gfa->occ_offsets);
+
+	if (gfa->occs)
+		free(gfa->occs);
+
+	if (gfa->adj_offsets)
+		free(gfa->adj_offsets);
+
+	if (gfa->adj_edges)
+		free(gfa->adj_edges);
+
+	for (idx_t i = 0; i < gfa->retired_count; i++)
+		free(gfa->retired[i]);
+	free(gfa->retired);
+
+	pthread_mutex_destroy(&gfa->lock);
+	pthread_cond_destroy(&gfa->phase_cond);
 
 	free(gfa);
 }
@@ -0,0 +1,97 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <log.h>
+
+#include "../include/liteseq/gfa.h"
+#include "../include/liteseq/types.h"
+#include "../src/internal/lq_utils.h"
+
+#include "./gfa_adj.h"
+
+status_t gfa_build_adj(gfa_props *gfa)
+{
+	u32 vtx_arr_size = gfa->vtx_arr_size;
+	const edge *e = gfa->e;
+
+	idx_t *offsets = calloc((size_t)vtx_arr_size + 1, sizeof(idx_t));
+	if (!offsets)
+		return ERROR_CODE_OUT_OF_MEMORY;
+
+	idx_t entry_count = 0;
+	for (idx_t i = 0; i < gfa->l_line_count; i++) {
+		u32 v1 = gfa_vtx_slot(gfa, e[i].v1_id);
+		u32 v2 = gfa_vtx_slot(gfa, e[i].v2_id);
+		if (unlikely(v1 >= vtx_arr_size || v2 >= vtx_arr_size))
+			continue;
+		offsets[v1 + 1]++;
+		entry_count++;
+		if (v2 != v1) {
+			offsets[v2 + 1]++;
+			entry_count++;
+		}
+	}
+
+	idx_t *edges = malloc(sizeof(idx_t) * (entry_count ? entry_count : 1));
+	if (!edges) {
+		free(offsets);
+		return ERROR_CODE_OUT_OF_MEMORY;
+	}
+
+	for (u32 v = 0; v < vtx_arr_size; v++)
+		offsets[v + 1] += offsets[v];
+
+	// fill using offsets[v] as the cursor of v then shift back, see
+	// fill_csr in refs/ref_lookup.c
+	for (idx_t i = 0; i < gfa->l_line_count; i++) {
+		u32 v1 = gfa_vtx_slot(gfa, e[i].v1_id);
+		u32 v2 = gfa_vtx_slot(gfa, e[i].v2_id);
+		if (unlikely(v1 >= vtx_arr_size || v2 >= vtx_arr_size))
+			continue;
+		edges[offsets[v1]++] = i;
+		if (v2 != v1)
+			edges[offsets[v2]++] = i;
+	}
+	memmove(offsets + 1, offsets, sizeof(idx_t) * vtx_arr_size);
+	offsets[0] = 0;
+
+	gfa->adj_edges = edges;
+	// publish the offsets last, readers check them without the lock
+	__atomic_store_n(&gfa->adj_offsets, offsets, __ATOMIC_RELEASE);
+
+	return SUCCESS;
+}
+
+status_t gfa_ensure_adj(gfa_props *gfa)
+{
+	if (__atomic_load_n(&gfa->adj_offsets, __ATOMIC_ACQUIRE))
+		return SUCCESS;
+
+	if (!gfa->e && gfa->l_line_count > 0)
+		return ERROR_CODE_INVALID_ARGUMENT;
+
+	pthread_mutex_lock(&gfa->lock);
+	status_t res = SUCCESS;
+	if (!gfa->adj_offsets)
+		res = gfa_build_adj(gfa);
+	pthread_mutex_unlock(&gfa->lock);
+
+	if (res != SUCCESS)
+		log_error("Could not build the vertex adjacency");
+
+	return res;
+}
+
+const idx_t *get_vtx_edges(const gfa_props *gfa, id_t v_id, idx_t *count)
+{
+	*count = 0;
+	u32 slot = gfa_vtx_slot(gfa, v_id);
+	if (slot >= gfa->vtx_arr_size)
+		return NULL;
+
+	idx_t start = gfa->adj_offsets[slot];
+	*count = gfa->adj_offsets[slot + 1] - start;
+
+	return gfa->adj_edges + start;
+}
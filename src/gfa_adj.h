@@ -0,0 +1,32 @@
+#ifndef LQ_GFA_ADJ_H
+#define LQ_GFA_ADJ_H
+
+#include "../include/liteseq/gfa.h"
+
+#ifdef __cplusplus
+extern "C" {
+namespace liteseq
+{
+#endif
+
+/**
+ * Build the vertex to edge adjacency of the graph if it is not built yet.
+ * Safe to call from several threads, the first caller builds it.
+ */
+status_t gfa_ensure_adj(gfa_props *gfa);
+
+// build the adjacency of a graph no other thread sees yet, without the lock
+status_t gfa_build_adj(gfa_props *gfa);
+
+/**
+ * The indices into gfa->e of the edges incident to v_id, a self loop is listed
+ * once. The adjacency must be built.
+ */
+const idx_t *get_vtx_edges(const gfa_props *gfa, id_t v_id, idx_t *count);
+
+#ifdef __cplusplus
+} // namespace liteseq
+} // extern "C"
+#endif
+
+#endif // LQ_GFA_ADJ_H
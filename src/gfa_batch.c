@@ -0,0 +1,440 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <log.h>
+
+#include "../include/liteseq/gfa.h"
+#include "../include/liteseq/types.h"
+#include "../src/internal/lq_arena.h"
+#include "../src/internal/lq_utils.h"
+
+#include "./gfa_impl.h"
+#include "./gfa_l.h"
+#include "./gfa_load.h"
+#include "./gfa_metrics.h"
+#include "./gfa_s.h"
+#include "./gfa_stats.h"
+#include "./refs/ref_impl.h"
+
+/*
+ * Batch loading
+ * -------------
+ * The pool runs the tasks of all the files from one queue. A file goes
+ * through a prepare task, its parse tasks in any order and a finish task
+ * once the last of them is done, which is what load_gfa does with a thread
+ * per line type.
+ */
+
+#define BATCH_CHUNK_LINES (1 << 16) // the most S or L lines in a parse task
+
+enum batch_task_kind {
+	BATCH_PREPARE, // map, index and allocate, see prepare_gfa
+	BATCH_PARSE_S,
+	BATCH_PARSE_L,
+	BATCH_PARSE_REFS,
+	BATCH_FINISH, // see finish_gfa
+};
+
+struct batch_file;
+
+struct batch_task {
+	enum batch_task_kind kind;
+	struct batch_file *file;
+	struct batch_task *next; // in the queue
+	bool ok;		 // set by the task for the pool to act on
+
+	union {
+		struct s_thread_meta s;
+		struct l_thread_meta l;
+		struct ref_thread_data refs;
+	} meta;
+};
+
+struct batch_file {
+	gfa_props *gfa;
+	idx_t conf_idx; // the index of its config
+	u64 size;
+
+	struct batch_task prepare;
+	struct batch_task finish;
+	struct batch_task *parse;
+	idx_t parse_count;
+	idx_t parse_left; // guarded by the pool lock
+
+	// the stats accumulators, the L lines are one task when there are any
+	u32 *seg_lens;
+	struct l_stats_acc l_stats;
+};
+
+struct batch_pool {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+
+	struct batch_task *head;
+	struct batch_task *tail;
+
+	struct batch_file *files; // biggest first
+	idx_t file_count;
+	idx_t next_file; // the first one not let in yet
+	idx_t files_done;
+
+	u64 mem_budget;
+	u64 mem_in_use;
+};
+
+static void push_task(struct batch_pool *pool, struct batch_task *t)
+{
+	t->next = NULL;
+	if (pool->tail)
+		pool->tail->next = t;
+	else
+		pool->head = t;
+	pool->tail = t;
+}
+
+static struct batch_task *pop_task(struct batch_pool *pool)
+{
+	struct batch_task *t = pool->head;
+	pool->head = t->next;
+	if (!pool->head)
+		pool->tail = NULL;
+
+	return t;
+}
+
+// start the files that fit in the budget, with the pool locked
+static void admit_files(struct batch_pool *pool)
+{
+	while (pool->next_file < pool->file_count) {
+		struct batch_file *f = &pool->files[pool->next_file];
+		bool loading = pool->next_file > pool->files_done;
+		if (loading && pool->mem_budget > 0 &&
+		    pool->mem_in_use + f->size > pool->mem_budget)
+			break;
+
+		pool->mem_in_use += f->size;
+		push_task(pool, &f->prepare);
+		pool->next_file++;
+	}
+}
+
+static void file_done(struct batch_pool *pool, struct batch_file *f)
+{
+	pool->files_done++;
+	pool->mem_in_use -= f->size;
+	admit_files(pool);
+}
+
+/*
+ * Planning
+ * --------
+ */
+
+static idx_t chunk_count(idx_t line_count)
+{
+	return (line_count + BATCH_CHUNK_LINES - 1) / BATCH_CHUNK_LINES;
+}
+
+// an S task beyond the first gets an arena of its own
+static status_t add_s_arenas(gfa_props *gfa, idx_t extra)
+{
+	size_t size = sizeof(struct lq_arena *) * (GFA_ARENA_COUNT + extra);
+	struct lq_arena **arenas = realloc(gfa->arenas, size);
+	if (!arenas)
+		return ERROR_CODE_OUT_OF_MEMORY;
+	gfa->arenas = arenas;
+
+	for (idx_t i = 0; i < extra; i++) {
+		arenas[gfa->arena_count] = lq_arena_new(LQ_ARENA_BLOCK_SIZE);
+		if (!arenas[gfa->arena_count])
+			return ERROR_CODE_OUT_OF_MEMORY;
+		gfa->arena_count++;
+	}
+
+	return SUCCESS;
+}
+
+/**
+ * Split the lines of a prepared file into parse tasks, the L lines stay in
+ * one when the stats are collected as the side degrees are not shared
+ */
+static status_t plan_parse(struct batch_file *f)
+{
+	gfa_props *gfa = f->gfa;
+	if (gfa->inc_stats &&
+	    alloc_stats_acc(gfa, &f->seg_lens, &f->l_stats) != SUCCESS)
+		return ERROR_CODE_OUT_OF_MEMORY;
+
+	idx_t s_tasks = chunk_count(gfa->s_line_count);
+	idx_t l_tasks = gfa->inc_stats ? gfa->l_line_count > 0
+				       : chunk_count(gfa->l_line_count);
+	idx_t ref_tasks = gfa->inc_refs ? 1 : 0;
+
+	if (s_tasks > 1 && add_s_arenas(gfa, s_tasks - 1) != SUCCESS)
+		return ERROR_CODE_OUT_OF_MEMORY;
+
+	f->parse_count = s_tasks + l_tasks + ref_tasks;
+	f->parse = calloc(f->parse_count ? f->parse_count : 1,
+			  sizeof(struct batch_task));
+	if (!f->parse)
+		return ERROR_CODE_OUT_OF_MEMORY;
+
+	struct batch_task *t = f->parse;
+	for (idx_t i = 0; i < s_tasks; i++, t++) {
+		idx_t start = i * BATCH_CHUNK_LINES;
+		idx_t n = gfa->s_line_count - start;
+		if (n > BATCH_CHUNK_LINES)
+			n = BATCH_CHUNK_LINES;
+		*t = (struct batch_task){.kind = BATCH_PARSE_S, .file = f};
+		t->meta.s = (struct s_thread_meta){
+			.arena = i == 0 ? gfa->arenas[GFA_ARENA_S]
+					: gfa->arenas[GFA_ARENA_COUNT + i - 1],
+			.vertices = gfa->v,
+			.v_lo = gfa->v_lo,
+			.s_lines = gfa->s_lines + start,
+			.s_line_count = n,
+			.inc_vtx_labels = gfa->inc_vtx_labels,
+			.seg_lens = f->seg_lens ? f->seg_lens + start : NULL,
+			.metrics = &gfa->metrics.phases[GFA_METRIC_S],
+		};
+	}
+
+	idx_t l_chunk = gfa->inc_stats ? gfa->l_line_count : BATCH_CHUNK_LINES;
+	for (idx_t i = 0; i < l_tasks; i++, t++) {
+		idx_t start = i * l_chunk;
+		idx_t n = gfa->l_line_count - start;
+		if (n > l_chunk)
+			n = l_chunk;
+		*t = (struct batch_task){.kind = BATCH_PARSE_L, .file = f};
+		t->meta.l = (struct l_thread_meta){
+			.edges = gfa->e + start,
+			.l_lines = gfa->l_lines + start,
+			.l_line_count = n,
+			.stats = gfa->inc_stats ? &f->l_stats : NULL,
+			.metrics = &gfa->metrics.phases[GFA_METRIC_L],
+		};
+	}
+
+	if (ref_tasks) {
+		*t = (struct batch_task){.kind = BATCH_PARSE_REFS, .file = f};
+		t->meta.refs = (struct ref_thread_data){
+			.arena = gfa->arenas[GFA_ARENA_REFS],
+			.names = gfa->names,
+			.refs = &gfa->refs,
+			.lookup = &gfa->ref_lookup,
+			.p_lines = gfa->p_lines,
+			.w_lines = gfa->w_lines,
+			.p_line_count = gfa->p_line_count,
+			.w_line_count = gfa->w_line_count,
+			.filter = gfa->ref_filter,
+			.v_lo = gfa->v_lo,
+			.v_hi = gfa->v_hi,
+			.ref_count = &gfa->ref_count,
+			.metrics = &gfa->metrics.phases[GFA_METRIC_REFS],
+		};
+	}
+
+	return SUCCESS;
+}
+
+/*
+ * Running
+ * -------
+ */
+
+static void run_task(struct batch_task *t)
+{
+	struct batch_file *f = t->file;
+	gfa_props *gfa = f->gfa;
+
+	switch (t->kind) {
+	case BATCH_PREPARE:
+		t->ok = prepare_gfa(gfa);
+		if (t->ok && plan_parse(f) != SUCCESS) {
+			log_error("Failed to plan the parse of %s", gfa->fp);
+			gfa->status = ERROR_CODE_OUT_OF_MEMORY;
+			t->ok = false;
+		}
+		break;
+	case BATCH_PARSE_S:
+		t_handle_s(&t->meta.s);
+		break;
+	case BATCH_PARSE_L:
+		t_handle_l(&t->meta.l);
+		break;
+	case BATCH_PARSE_REFS:
+		t_handle_p(&t->meta.refs);
+		break;
+	case BATCH_FINISH: {
+		// the pool is the thread budget, the indexes get no more
+		u32 thread_count = gfa->thread_count;
+		gfa->thread_count = 1;
+		gfa->status = finish_gfa(gfa, &f->seg_lens, &f->l_stats);
+		gfa->thread_count = thread_count;
+		break;
+	}
+	}
+}
+
+// queue what follows t, with the pool locked
+static void task_done(struct batch_pool *pool, struct batch_task *t)
+{
+	struct batch_file *f = t->file;
+
+	switch (t->kind) {
+	case BATCH_PREPARE:
+		if (!t->ok) {
+			// a failed plan leaves accumulators behind
+			free(f->seg_lens);
+			free(f->l_stats.side_deg);
+			f->seg_lens = NULL;
+			f->l_stats.side_deg = NULL;
+			file_done(pool, f);
+			break;
+		}
+		f->parse_left = f->parse_count;
+		for (idx_t i = 0; i < f->parse_count; i++)
+			push_task(pool, &f->parse[i]);
+		if (f->parse_count == 0)
+			push_task(pool, &f->finish);
+		break;
+	case BATCH_PARSE_S:
+	case BATCH_PARSE_L:
+	case BATCH_PARSE_REFS:
+		if (--f->parse_left == 0)
+			push_task(pool, &f->finish);
+		break;
+	case BATCH_FINISH:
+		free(f->parse);
+		f->parse = NULL;
+		file_done(pool, f);
+		break;
+	}
+}
+
+static void *t_batch_worker(void *arg)
+{
+	struct batch_pool *pool = *(struct batch_pool **)arg;
+
+	pthread_mutex_lock(&pool->lock);
+	for (;;) {
+		while (!pool->head && pool->files_done < pool->file_count)
+			pthread_cond_wait(&pool->cond, &pool->lock);
+		if (!pool->head)
+			break; // all the files are done
+
+		struct batch_task *t = pop_task(pool);
+		pthread_mutex_unlock(&pool->lock);
+		run_task(t);
+		pthread_mutex_lock(&pool->lock);
+
+		task_done(pool, t);
+		pthread_cond_broadcast(&pool->cond);
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	return NULL;
+}
+
+static int cmp_file_size_desc(const void *a, const void *b)
+{
+	const struct batch_file *x = a;
+	const struct batch_file *y = b;
+	if (x->size != y->size)
+		return x->size > y->size ? -1 : 1;
+
+	return x->conf_idx < y->conf_idx ? -1 : x->conf_idx > y->conf_idx;
+}
+
+static void free_files(struct batch_file *files, idx_t count)
+{
+	for (idx_t i = 0; i < count; i++) {
+		if (files[i].gfa)
+			gfa_free(files[i].gfa);
+		free(files[i].parse);
+		free(files[i].seg_lens);
+		free(files[i].l_stats.side_deg);
+	}
+	free(files);
+}
+
+status_t gfa_new_batch(const gfa_config *confs, idx_t count,
+		       const struct gfa_batch_opts *opts, gfa_props **gfas)
+{
+	if (!confs || !gfas)
+		return ERROR_CODE_INVALID_ARGUMENT;
+	if (count == 0)
+		return SUCCESS;
+
+	struct batch_file *files = calloc(count, sizeof(struct batch_file));
+	if (!files)
+		return ERROR_CODE_OUT_OF_MEMORY;
+
+	for (idx_t i = 0; i < count; i++) {
+		struct batch_file *f = &files[i];
+		f->conf_idx = i;
+		f->gfa = init_gfa(&confs[i]);
+		if (!f->gfa) {
+			free_files(files, count);
+			return ERROR_CODE_OUT_OF_MEMORY;
+		}
+
+		struct stat sb;
+		f->size = stat(confs[i].fp, &sb) == 0 ? (u64)sb.st_size : 0;
+	}
+	qsort(files, count, sizeof(struct batch_file), cmp_file_size_desc);
+
+	struct batch_pool pool = {
+		.head = NULL,
+		.tail = NULL,
+		.files = files,
+		.file_count = count,
+		.next_file = 0,
+		.files_done = 0,
+		.mem_budget = opts ? opts->mem_budget : 0,
+		.mem_in_use = 0,
+	};
+	pthread_mutex_init(&pool.lock, NULL);
+	pthread_cond_init(&pool.cond, NULL);
+
+	for (idx_t i = 0; i < count; i++) {
+		struct batch_file *f = &files[i];
+		f->prepare.kind = BATCH_PREPARE;
+		f->prepare.file = f;
+		f->finish.kind = BATCH_FINISH;
+		f->finish.file = f;
+	}
+	admit_files(&pool);
+
+	u32 thread_count = lq_thread_count(opts ? opts->thread_count : 0);
+	struct batch_pool **args =
+		malloc(sizeof(struct batch_pool *) * thread_count);
+	status_t res = args ? SUCCESS : ERROR_CODE_OUT_OF_MEMORY;
+	for (u32 i = 0; res == SUCCESS && i < thread_count; i++)
+		args[i] = &pool;
+
+	// the workers that did start drain the queue between them
+	if (res == SUCCESS)
+		lq_run_threads(thread_count, t_batch_worker, args,
+			       sizeof(struct batch_pool *));
+	if (res == SUCCESS && pool.files_done != count)
+		res = FAILURE;
+	free(args);
+
+	pthread_cond_destroy(&pool.cond);
+	pthread_mutex_destroy(&pool.lock);
+
+	if (res != SUCCESS) {
+		log_error("Failed to run the batch load");
+		free_files(files, count);
+		return res;
+	}
+
+	for (idx_t i = 0; i < count; i++)
+		gfas[files[i].conf_idx] = files[i].gfa;
+	free(files);
+
+	return SUCCESS;
+}
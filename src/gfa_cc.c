@@ -0,0 +1,206 @@
+#include <stdlib.h>
+
+#include <log.h>
+
+#include "../include/liteseq/gfa.h"
+#include "../include/liteseq/types.h"
+#include "../src/internal/lq_utils.h"
+
+/*
+ * Lock-free union-find over the vertex ids.
+ *
+ * A root is only ever linked under a smaller root, so a parent is never
+ * greater than its child and the forest stays acyclic however the CASes of
+ * the workers interleave. Path halving shortcuts a vertex to its grandparent
+ * on the way up; losing that CAS is harmless as another worker has already
+ * moved the vertex closer to its root.
+ */
+
+static id_t uf_find(id_t *parent, id_t v)
+{
+	for (;;) {
+		id_t p = __atomic_load_n(&parent[v], __ATOMIC_RELAXED);
+		if (p == v)
+			return v;
+
+		id_t gp = __atomic_load_n(&parent[p], __ATOMIC_RELAXED);
+		if (p != gp)
+			__atomic_compare_exchange_n(&parent[v], &p, gp, false,
+						    __ATOMIC_RELAXED,
+						    __ATOMIC_RELAXED);
+		v = gp;
+	}
+}
+
+static void uf_union(id_t *parent, id_t a, id_t b)
+{
+	for (;;) {
+		a = uf_find(parent, a);
+		b = uf_find(parent, b);
+		if (a == b)
+			return;
+
+		if (a < b) {
+			id_t t = a;
+			a = b;
+			b = t;
+		}
+
+		// a is the larger root, fails if a stopped being a root
+		id_t expected = a;
+		if (__atomic_compare_exchange_n(&parent[a], &expected, b, false,
+						__ATOMIC_RELAXED,
+						__ATOMIC_RELAXED))
+			return;
+	}
+}
+
+struct cc_thread_meta {
+	const gfa_props *gfa;
+	id_t *parent;
+
+	// the vertices [v_start, v_end) and edges [e_start, e_end) of the
+	// worker
+	id_t v_start;
+	id_t v_end;
+	idx_t e_start;
+	idx_t e_end;
+};
+
+static void *t_init_parents(void *meta)
+{
+	struct cc_thread_meta *m = (struct cc_thread_meta *)meta;
+	for (id_t v = m->v_start; v < m->v_end; v++)
+		m->parent[v] = v;
+
+	return NULL;
+}
+
+static void *t_union_edges(void *meta)
+{
+	struct cc_thread_meta *m = (struct cc_thread_meta *)meta;
+	const gfa_props *gfa = m->gfa;
+	const edge *e = gfa->e;
+
+	// edges to ids without an S line are ignored so that every root is a
+	// vertex of the graph
+	for (idx_t i = m->e_start; i < m->e_end; i++) {
+		u32 v1 = gfa_vtx_slot(gfa, e[i].v1_id);
+		u32 v2 = gfa_vtx_slot(gfa, e[i].v2_id);
+		if (unlikely(v1 >= gfa->vtx_arr_size ||
+			     v2 >= gfa->vtx_arr_size || !gfa->v[v1] ||
+			     !gfa->v[v2]))
+			continue;
+		uf_union(m->parent, v1, v2);
+	}
+
+	return NULL;
+}
+
+static void *t_flatten(void *meta)
+{
+	struct cc_thread_meta *m = (struct cc_thread_meta *)meta;
+	for (id_t v = m->v_start; v < m->v_end; v++) {
+		id_t root = uf_find(m->parent, v);
+		__atomic_store_n(&m->parent[v], root, __ATOMIC_RELAXED);
+	}
+
+	return NULL;
+}
+
+/**
+ * Turn the flattened forest in comp_ids into dense component ids numbered in
+ * the order of the smallest vertex of each component. A root is the smallest
+ * vertex of its tree so it is relabelled before any of its children read it.
+ */
+static status_t label_components(const gfa_props *gfa,
+				 struct gfa_components *cc)
+{
+	id_t *comp_ids = cc->comp_ids;
+	u32 vtx_arr_size = gfa->vtx_arr_size;
+
+	idx_t count = 0;
+	for (id_t v = 0; v < vtx_arr_size; v++) {
+		if (gfa->v[v] == NULL) {
+			comp_ids[v] = NULL_ID;
+			continue;
+		}
+		id_t root = comp_ids[v];
+		comp_ids[v] = root == v ? count++ : comp_ids[root];
+	}
+
+	cc->count = count;
+	cc->sizes = calloc(count ? count : 1, sizeof(idx_t));
+	if (!cc->sizes)
+		return ERROR_CODE_OUT_OF_MEMORY;
+
+	for (id_t v = 0; v < vtx_arr_size; v++)
+		if (comp_ids[v] != NULL_ID)
+			cc->sizes[comp_ids[v]]++;
+
+	return SUCCESS;
+}
+
+struct gfa_components *gfa_connected_components(const gfa_props *gfa)
+{
+	if (!gfa || !gfa->v || (!gfa->e && gfa->l_line_count > 0))
+		return NULL;
+
+	struct gfa_components *cc = calloc(1, sizeof(struct gfa_components));
+	if (!cc)
+		return NULL;
+
+	u32 vtx_arr_size = gfa->vtx_arr_size;
+	u64 edge_count = gfa->l_line_count;
+	u32 thread_count = gfa->thread_count ? gfa->thread_count : 1;
+	struct cc_thread_meta *metas =
+		malloc(sizeof(struct cc_thread_meta) * thread_count);
+	cc->comp_ids = malloc(sizeof(id_t) * vtx_arr_size);
+	if (!metas || !cc->comp_ids)
+		goto fail;
+
+	for (u32 t = 0; t < thread_count; t++) {
+		metas[t] = (struct cc_thread_meta){
+			.gfa = gfa,
+			.parent = cc->comp_ids,
+			.v_start = (u64)vtx_arr_size * t / thread_count,
+			.v_end = (u64)vtx_arr_size * (t + 1) / thread_count,
+			.e_start = edge_count * t / thread_count,
+			.e_end = edge_count * (t + 1) / thread_count,
+		};
+	}
+
+	size_t meta_size = sizeof(struct cc_thread_meta);
+	if (lq_run_threads(thread_count, t_init_parents, metas, meta_size) !=
+		    SUCCESS ||
+	    lq_run_threads(thread_count, t_union_edges, metas, meta_size) !=
+		    SUCCESS ||
+	    lq_run_threads(thread_count, t_flatten, metas, meta_size) !=
+		    SUCCESS)
+		goto fail;
+
+	if (label_components(gfa, cc) != SUCCESS)
+		goto fail;
+
+	free(metas);
+
+	return cc;
+
+fail:
+	log_error("Could not compute the connected components");
+	free(metas);
+	gfa_components_free(&cc);
+
+	return NULL;
+}
+
+void gfa_components_free(struct gfa_components **cc)
+{
+	if (cc == NULL || *cc == NULL)
+		return;
+
+	free((*cc)->comp_ids);
+	free((*cc)->sizes);
+	free(*cc);
+	*cc = NULL;
+}
@@ -0,0 +1,347 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <log.h>
+
+#include "../include/liteseq/gfa.h"
+#include "../include/liteseq/refs.h"
+#include "../include/liteseq/types.h"
+#include "../src/internal/lq_utils.h"
+
+#include "./gfa_cov.h"
+
+// per-thread histograms are used while they fit in this many bytes or in
+// the space the walks themselves take, whichever is larger
+#define COV_DENSE_MIN_BUDGET (64 * 1024 * 1024)
+
+/*
+ * Each worker claims refs one at a time. In dense mode it counts into its own
+ * histograms which are summed at the end, in sparse mode, when there are too
+ * many vertices for a histogram per worker, it adds to the shared counts
+ * atomically.
+ */
+struct cov_thread_meta {
+	const gfa_props *gfa;
+	idx_t *next_ref; // shared by the workers, the next ref to count
+
+	// dense mode, this worker's histograms and the ref that last counted
+	// each vertex, all vtx_arr_size entries
+	u32 *depth;
+	u32 *haps;
+	idx_t *stamp;
+
+	// the vertices [v_start, v_end) this worker sums in dense mode
+	id_t v_start;
+	id_t v_end;
+	u32 thread_count;
+	u32 *all_hists; // the histograms of every worker
+
+	struct gfa_coverage *cov;
+	status_t status;
+};
+
+// the runs a partial load splits a walk into are consecutive refs that share
+// its id, true when ref i is one of them after the first
+static bool continues_walk(const gfa_props *gfa, idx_t i)
+{
+	struct ref *const *refs = gfa->refs;
+	return i > 0 && refs[i] && refs[i - 1] &&
+	       refs[i]->id == refs[i - 1]->id;
+}
+
+// the end of the refs from i on that are runs of the same walk
+static idx_t walk_end(const gfa_props *gfa, idx_t i)
+{
+	idx_t end = i + 1;
+	while (end < gfa->ref_count && continues_walk(gfa, end))
+		end++;
+
+	return end;
+}
+
+// count ref_idx in as a step of the haplotype of the ref hap_idx
+static void count_dense(struct cov_thread_meta *m, idx_t ref_idx,
+			idx_t hap_idx)
+{
+	const struct ref *r = m->gfa->refs[ref_idx];
+	const id_t *v_ids = get_walk_v_ids(r);
+	idx_t step_count = get_step_count(r);
+	u32 vtx_arr_size = m->gfa->vtx_arr_size;
+
+	for (idx_t j = 0; j < step_count; j++) {
+		u32 slot = gfa_vtx_slot(m->gfa, v_ids[j]);
+		if (unlikely(slot >= vtx_arr_size))
+			continue;
+		m->depth[slot]++;
+		// stamps are hap_idx + 1 so that 0 means never seen
+		if (m->stamp[slot] != hap_idx + 1) {
+			m->stamp[slot] = hap_idx + 1;
+			m->haps[slot]++;
+		}
+	}
+}
+
+static int cmp_id(const void *a, const void *b)
+{
+	id_t x = *(const id_t *)a;
+	id_t y = *(const id_t *)b;
+	return (x > y) - (x < y);
+}
+
+/**
+ * Count the refs [first, end) of one walk into the shared counts. The
+ * distinct vertices of the walk come from sorting a copy of its steps in
+ * scratch, which has room for them.
+ */
+static void count_sparse(struct cov_thread_meta *m, idx_t first, idx_t end,
+			 id_t *scratch)
+{
+	idx_t step_count = 0;
+	for (idx_t i = first; i < end; i++) {
+		const struct ref *r = m->gfa->refs[i];
+		memcpy(scratch + step_count, get_walk_v_ids(r),
+		       sizeof(id_t) * get_step_count(r));
+		step_count += get_step_count(r);
+	}
+	u32 vtx_arr_size = m->gfa->vtx_arr_size;
+	idx_t *depth = m->cov->depth;
+	idx_t *haps = m->cov->hap_count;
+
+	qsort(scratch, step_count, sizeof(id_t), cmp_id);
+
+	for (idx_t j = 0; j < step_count; j++) {
+		id_t v_id = scratch[j];
+		u32 slot = gfa_vtx_slot(m->gfa, v_id);
+		if (unlikely(slot >= vtx_arr_size))
+			continue;
+		__atomic_fetch_add(&depth[slot], 1, __ATOMIC_RELAXED);
+		if (j == 0 || scratch[j - 1] != v_id)
+			__atomic_fetch_add(&haps[slot], 1, __ATOMIC_RELAXED);
+	}
+}
+
+static void *t_count_dense(void *meta)
+{
+	struct cov_thread_meta *m = (struct cov_thread_meta *)meta;
+	for (;;) {
+		idx_t i = __atomic_fetch_add(m->next_ref, 1, __ATOMIC_RELAXED);
+		if (i >= m->gfa->ref_count)
+			break;
+		// the worker of the first run of a walk counts all of them
+		if (!m->gfa->refs[i] || continues_walk(m->gfa, i))
+			continue;
+		for (idx_t j = i, end = walk_end(m->gfa, i); j < end; j++)
+			count_dense(m, j, i);
+	}
+
+	return NULL;
+}
+
+static void *t_count_sparse(void *meta)
+{
+	struct cov_thread_meta *m = (struct cov_thread_meta *)meta;
+	id_t *scratch = NULL;
+	idx_t scratch_cap = 0;
+
+	for (;;) {
+		idx_t i = __atomic_fetch_add(m->next_ref, 1, __ATOMIC_RELAXED);
+		if (i >= m->gfa->ref_count)
+			break;
+		if (!m->gfa->refs[i] || continues_walk(m->gfa, i))
+			continue;
+
+		idx_t end = walk_end(m->gfa, i);
+		idx_t step_count = 0;
+		for (idx_t j = i; j < end; j++)
+			step_count += get_step_count(m->gfa->refs[j]);
+		if (step_count > scratch_cap) {
+			free(scratch);
+			scratch_cap = step_count;
+			scratch = malloc(sizeof(id_t) * scratch_cap);
+			if (!scratch) {
+				m->status = ERROR_CODE_OUT_OF_MEMORY;
+				break;
+			}
+		}
+		count_sparse(m, i, end, scratch);
+	}
+	free(scratch);
+
+	return NULL;
+}
+
+static void *t_merge_dense(void *meta)
+{
+	struct cov_thread_meta *m = (struct cov_thread_meta *)meta;
+	size_t stride = (size_t)m->gfa->vtx_arr_size * 2;
+	size_t vtx_arr_size = m->gfa->vtx_arr_size;
+
+	for (id_t v = m->v_start; v < m->v_end; v++) {
+		idx_t depth = 0;
+		idx_t haps = 0;
+		for (u32 t = 0; t < m->thread_count; t++) {
+			const u32 *h = m->all_hists + t * stride;
+			depth += h[v];
+			haps += h[vtx_arr_size + v];
+		}
+		m->cov->depth[v] = depth;
+		m->cov->hap_count[v] = haps;
+	}
+
+	return NULL;
+}
+
+static struct gfa_coverage *coverage(const gfa_props *gfa, bool sparse)
+{
+	u32 vtx_arr_size = gfa->vtx_arr_size;
+	u32 thread_count = gfa->thread_count ? gfa->thread_count : 1;
+	if (thread_count > gfa->ref_count)
+		thread_count = gfa->ref_count > 0 ? gfa->ref_count : 1;
+
+	struct gfa_coverage *cov = calloc(1, sizeof(struct gfa_coverage));
+	if (!cov)
+		return NULL;
+	cov->v_lo = gfa->v_lo;
+
+	// in dense mode the histograms are summed into these so only the
+	// sparse mode needs them zeroed
+	cov->depth = calloc(vtx_arr_size, sizeof(idx_t));
+	cov->hap_count = calloc(vtx_arr_size, sizeof(idx_t));
+
+	struct cov_thread_meta *metas =
+		malloc(sizeof(struct cov_thread_meta) * thread_count);
+
+	// depth, haps and stamp of each worker
+	size_t stride = (size_t)vtx_arr_size * 2;
+	u32 *hists = NULL;
+	idx_t *stamps = NULL;
+	if (!sparse) {
+		hists = calloc(stride * thread_count, sizeof(u32));
+		stamps = calloc((size_t)vtx_arr_size * thread_count,
+				sizeof(idx_t));
+	}
+
+	status_t res = ERROR_CODE_OUT_OF_MEMORY;
+	if (!cov->depth || !cov->hap_count || !metas ||
+	    (!sparse && (!hists || !stamps)))
+		goto done;
+
+	idx_t next_ref = 0;
+	for (u32 t = 0; t < thread_count; t++) {
+		metas[t] = (struct cov_thread_meta){
+			.gfa = gfa,
+			.next_ref = &next_ref,
+			.v_start = (u64)vtx_arr_size * t / thread_count,
+			.v_end = (u64)vtx_arr_size * (t + 1) / thread_count,
+			.thread_count = thread_count,
+			.all_hists = hists,
+			.cov = cov,
+			.status = SUCCESS,
+		};
+		if (!sparse) {
+			metas[t].depth = hists + t * stride;
+			metas[t].haps = metas[t].depth + vtx_arr_size;
+			metas[t].stamp = stamps + (size_t)t * vtx_arr_size;
+		}
+	}
+
+	size_t meta_size = sizeof(struct cov_thread_meta);
+	res = lq_run_threads(thread_count,
+			     sparse ? t_count_sparse : t_count_dense, metas,
+			     meta_size);
+	for (u32 t = 0; t < thread_count && res == SUCCESS; t++)
+		res = metas[t].status;
+
+	if (res == SUCCESS && !sparse)
+		res = lq_run_threads(thread_count, t_merge_dense, metas,
+				     meta_size);
+
+done:
+	free(metas);
+	free(hists);
+	free(stamps);
+
+	if (res != SUCCESS) {
+		log_error("Could not compute the coverage");
+		gfa_coverage_free(&cov);
+	}
+
+	return cov;
+}
+
+#ifdef TESTING
+struct gfa_coverage *compute_coverage(const gfa_props *gfa, bool sparse)
+{
+	return coverage(gfa, sparse);
+}
+#endif
+
+struct gfa_coverage *gfa_compute_coverage(const gfa_props *gfa)
+{
+	if (!gfa || !gfa->inc_refs || !gfa->refs)
+		return NULL;
+
+	u64 step_total = 0;
+	for (idx_t i = 0; i < gfa->ref_count; i++)
+		if (gfa->refs[i])
+			step_total += get_step_count(gfa->refs[i]);
+
+	u64 budget = step_total * sizeof(id_t) * 2;
+	if (budget < COV_DENSE_MIN_BUDGET)
+		budget = COV_DENSE_MIN_BUDGET;
+
+	u64 threads = gfa->thread_count ? gfa->thread_count : 1;
+	u64 dense_size = threads * gfa->vtx_arr_size * 3 * sizeof(u32);
+
+	return coverage(gfa, dense_size > budget);
+}
+
+void gfa_coverage_free(struct gfa_coverage **cov)
+{
+	if (cov == NULL || *cov == NULL)
+		return;
+
+	free((*cov)->depth);
+	free((*cov)->hap_count);
+	free(*cov);
+	*cov = NULL;
+}
+
+status_t ref_depth_runs(const struct gfa_coverage *cov, const struct ref *r,
+			struct depth_run **runs, idx_t *run_count)
+{
+	// the positional index is built once the loci are set
+	if (!cov || !r || !runs || !run_count || !r->walk->eytz)
+		return ERROR_CODE_INVALID_ARGUMENT;
+
+	const id_t *v_ids = get_walk_v_ids(r);
+	const idx_t *loci = get_walk_loci(r);
+	idx_t step_count = get_step_count(r);
+	idx_t hap_len = get_hap_len(r);
+
+	// at most one run per step
+	size_t cap = step_count ? step_count : 1;
+	struct depth_run *out = malloc(sizeof(struct depth_run) * cap);
+	if (!out)
+		return ERROR_CODE_OUT_OF_MEMORY;
+
+	idx_t n = 0;
+	for (idx_t j = 0; j < step_count; j++) {
+		idx_t next = j + 1 < step_count ? loci[j + 1] : hap_len + 1;
+		idx_t len = next - loci[j];
+		if (len == 0)
+			continue;
+
+		idx_t depth = cov->depth[v_ids[j] - cov->v_lo];
+		if (n > 0 && out[n - 1].depth == depth) {
+			out[n - 1].len += len;
+			continue;
+		}
+		out[n++] = (struct depth_run){.len = len, .depth = depth};
+	}
+
+	*runs = out;
+	*run_count = n;
+
+	return SUCCESS;
+}
@@ -0,0 +1,27 @@
+#ifndef LQ_GFA_COV_H
+#define LQ_GFA_COV_H
+
+#include <stdbool.h>
+
+#include "../include/liteseq/gfa.h"
+
+#ifdef __cplusplus
+extern "C" { // Ensure the function has C linkage
+namespace liteseq
+{
+#endif
+
+#ifdef TESTING
+/**
+ * gfa_compute_coverage with the choice between per-thread histograms and
+ * shared atomic counters forced, sparse selects the latter
+ */
+struct gfa_coverage *compute_coverage(const gfa_props *gfa, bool sparse);
+#endif
+
+#ifdef __cplusplus
+} // namespace liteseq
+} // extern "C"
+#endif
+
+#endif // LQ_GFA_COV_H
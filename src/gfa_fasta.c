@@ -0,0 +1,214 @@
+#if defined(__linux__)
+#define _GNU_SOURCE // ftruncate
+#endif
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <log.h>
+
+#include "../include/liteseq/gfa.h"
+#include "../include/liteseq/refs.h"
+#include "../include/liteseq/types.h"
+#include "../src/internal/lq_io.h"
+#include "../src/internal/lq_utils.h"
+
+#include "./gfa_impl.h"
+
+#define FASTA_BUF_SIZE (4 * 1024 * 1024)
+#define FASTA_HEADER_CHAR '>'
+
+static u64 record_size(const struct ref *r, idx_t line_width)
+{
+	if (!r)
+		return 0;
+
+	u64 hap_len = get_hap_len(r);
+	u64 lines = line_width ? (hap_len + line_width - 1) / line_width
+			       : hap_len > 0;
+
+	return 1 + strlen(get_tag(r)) + 1 + hap_len + lines;
+}
+
+struct fasta_thread_meta {
+	const gfa_props *gfa;
+	const u64 *offsets; // the file offset of the record of each ref
+	idx_t line_width;
+	int fd;
+	idx_t *next_ref; // shared by the workers, the next ref to write
+	status_t status;
+};
+
+/**
+ * Write the record of one ref, the sequence is materialised chunk by chunk
+ * and the chunks are a whole number of lines so that they wrap the same way
+ */
+static status_t write_record(const gfa_props *gfa, const struct ref *r,
+			     idx_t line_width, char *seq, idx_t chunk,
+			     struct lq_out_buf *o)
+{
+	const char *tag = get_tag(r);
+	size_t tag_len = strlen(tag);
+
+	*lq_out_reserve(o, 1) = FASTA_HEADER_CHAR;
+	o->used++;
+	lq_out_append(o, tag, tag_len);
+	*lq_out_reserve(o, 1) = NEWLINE;
+	o->used++;
+
+	idx_t hap_len = get_hap_len(r);
+	for (idx_t start = 1; start <= hap_len; start += chunk) {
+		idx_t n = hap_len - start + 1 < chunk ? hap_len - start + 1
+						      : chunk;
+		status_t res = ref_get_sequence(gfa, r, start, n, seq);
+		if (res != SUCCESS)
+			return res;
+
+		if (line_width == 0) {
+			lq_out_append(o, seq, n);
+			continue;
+		}
+
+		idx_t lines = (n + line_width - 1) / line_width;
+		char *out = lq_out_reserve(o, n + lines);
+		for (idx_t k = 0; k < n; k += line_width) {
+			idx_t m = n - k < line_width ? n - k : line_width;
+			memcpy(out, seq + k, m);
+			out[m] = NEWLINE;
+			out += m + 1;
+		}
+		o->used += n + lines;
+	}
+
+	if (line_width == 0 && hap_len > 0) {
+		*lq_out_reserve(o, 1) = NEWLINE;
+		o->used++;
+	}
+
+	return o->status;
+}
+
+static void *t_write_fasta(void *meta)
+{
+	struct fasta_thread_meta *m = (struct fasta_thread_meta *)meta;
+	idx_t line_width = m->line_width;
+
+	// a whole number of lines of sequence
+	idx_t chunk = FASTA_BUF_SIZE;
+	if (line_width > 0) {
+		chunk = line_width * (FASTA_BUF_SIZE / (line_width + 1));
+		if (chunk == 0)
+			chunk = line_width;
+	}
+
+	size_t newlines = line_width ? chunk / line_width : 0;
+	struct lq_out_buf o = {
+		.fd = m->fd,
+		.used = 0,
+		.cap = (size_t)chunk + newlines + 1,
+		.status = SUCCESS,
+	};
+	char *seq = malloc((size_t)chunk + 1);
+	o.data = malloc(o.cap);
+	if (!seq || !o.data) {
+		m->status = ERROR_CODE_OUT_OF_MEMORY;
+		goto done;
+	}
+
+	const gfa_props *gfa = m->gfa;
+	for (;;) {
+		idx_t i = __atomic_fetch_add(m->next_ref, 1, __ATOMIC_RELAXED);
+		if (i >= gfa->ref_count)
+			break;
+		if (!gfa->refs[i])
+			continue;
+
+		o.offset = m->offsets[i];
+		m->status = write_record(gfa, gfa->refs[i], line_width, seq,
+					 chunk, &o);
+		lq_out_flush(&o);
+		if (m->status == SUCCESS)
+			m->status = o.status;
+		if (m->status != SUCCESS)
+			break;
+	}
+
+done:
+	free(seq);
+	free(o.data);
+
+	return NULL;
+}
+
+status_t gfa_write_fasta(const gfa_props *gfa, const char *fp,
+			 idx_t line_width)
+{
+	// the runs of a split walk would be records with the same name
+	if (!gfa || !fp || !gfa->inc_refs || !gfa->inc_vtx_labels ||
+	    gfa_is_partial(gfa))
+		return ERROR_CODE_INVALID_ARGUMENT;
+
+	u64 *offsets = malloc(sizeof(u64) * ((size_t)gfa->ref_count + 1));
+	if (!offsets)
+		return ERROR_CODE_OUT_OF_MEMORY;
+
+	// the layout of the file is known up front, each worker writes its
+	// records in place
+	offsets[0] = 0;
+	for (idx_t i = 0; i < gfa->ref_count; i++)
+		offsets[i + 1] =
+			offsets[i] + record_size(gfa->refs[i], line_width);
+
+	int fd = open(fp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd == -1) {
+		log_error("Failed to open %s for writing", fp);
+		free(offsets);
+		return FAILURE;
+	}
+
+	status_t res = SUCCESS;
+	if (ftruncate(fd, (off_t)offsets[gfa->ref_count]) == -1) {
+		log_error("Failed to size %s", fp);
+		res = FAILURE;
+	}
+
+	u32 thread_count = gfa->thread_count ? gfa->thread_count : 1;
+	if (thread_count > gfa->ref_count)
+		thread_count = gfa->ref_count > 0 ? gfa->ref_count : 1;
+
+	idx_t next_ref = 0;
+	struct fasta_thread_meta *metas =
+		malloc(sizeof(struct fasta_thread_meta) * thread_count);
+	if (res == SUCCESS && !metas)
+		res = ERROR_CODE_OUT_OF_MEMORY;
+
+	if (res == SUCCESS) {
+		for (u32 t = 0; t < thread_count; t++)
+			metas[t] = (struct fasta_thread_meta){
+				.gfa = gfa,
+				.offsets = offsets,
+				.line_width = line_width,
+				.fd = fd,
+				.next_ref = &next_ref,
+				.status = SUCCESS,
+			};
+
+		res = lq_run_threads(thread_count, t_write_fasta, metas,
+				     sizeof(struct fasta_thread_meta));
+		for (u32 t = 0; t < thread_count && res == SUCCESS; t++)
+			res = metas[t].status;
+	}
+
+	if (close(fd) == -1 && res == SUCCESS)
+		res = FAILURE;
+
+	if (res != SUCCESS)
+		log_error("Failed to write FASTA to %s", fp);
+
+	free(metas);
+	free(offsets);
+
+	return res;
+}
@@ -0,0 +1,52 @@
+#ifndef LQ_GFA_IMPL_H
+#define LQ_GFA_IMPL_H
+
+#include "../include/liteseq/gfa.h"
+
+#ifdef __cplusplus
+extern "C" {
+namespace liteseq
+{
+#endif
+
+// one arena for each thread that allocates long lived graph objects
+enum gfa_arena {
+	GFA_ARENA_S,	// vertices and labels
+	GFA_ARENA_REFS, // refs, their names and walks
+	GFA_ARENA_COUNT
+};
+
+// a gfa_props with the settings of conf and nothing loaded
+gfa_props *init_gfa(const gfa_config *conf);
+
+status_t alloc_gfa_arenas(gfa_props *gfa);
+
+// widen the vertex id bounds of gfa to take in the S line at curr_char
+void set_v_id_bounds(const char *curr_char, gfa_props *g, idx_t linum);
+
+// set the loci and the positional index of the refs from first_ref on
+status_t set_ref_loci(gfa_props *gfa, idx_t first_ref);
+
+// whether gfa loads only some of the vertex ids, see v_lo in gfa_config
+static inline bool gfa_is_partial(const gfa_props *gfa)
+{
+	return gfa->v_lo != 0 || gfa->v_hi != NULL_ID;
+}
+
+// the vertex array size that holds the loaded ids up to max_v_id
+u32 gfa_vtx_arr_size(const gfa_props *gfa);
+
+/**
+ * Keep the S lines of the vertices a partial load takes and the L lines with
+ * an end among them, in place and in order. Other lines are kept as well.
+ *
+ * @return the number of lines kept
+ */
+idx_t select_v_range_lines(const gfa_props *gfa, line *lines, idx_t count);
+
+#ifdef __cplusplus
+} // namespace liteseq
+} // extern "C"
+#endif
+
+#endif // LQ_GFA_IMPL_H
@@ -5,8 +5,11 @@
 
 #include "../include/liteseq/gfa.h"
 #include "../include/liteseq/types.h"
+#include "../src/internal/lq_arena.h"
 #include "../src/internal/lq_utils.h"
 #include "./gfa_l.h"
+#include "./gfa_load.h"
+#include "./gfa_metrics.h"
 
 #define L_LINE_TYPE_IDX 0      // the index of the line type token in the L line
 #define L_LINE_V1_ID_IDX 1     //  first vertex ID token in the L line
@@ -29,12 +32,12 @@
  * @param [in] line_length the length of the line
  * @param [in] idx the index of the line
  * @param [in] tokens the tokens to parse
- * @param [in] c the config
+ * @param [in] scratch arena the tokens are allocated from, reset before return
  * @param [out] e the edges to populate
  * @return 0 on success, -1 on failure
  */
 status_t handle_l(const char *l_line, u32 line_len, size_t idx, char **tokens,
-		  edge *edges)
+		  struct lq_arena *scratch, edge *edges)
 {
 	struct split_str_params p = {
 		.str = l_line,
@@ -47,6 +50,7 @@ status_t handle_l(const char *l_line, u32 line_len, size_t idx, char **tokens,
 		.tokens_found = 0,
 		.tokens = tokens,
 		.end = NULL,
+		.arena = scratch,
 	};
 
 	status_t res = split_str(&p);
@@ -67,6 +71,7 @@ status_t handle_l(const char *l_line, u32 line_len, size_t idx, char **tokens,
 				"Error: Invalid self loop: %ld %c and %ld %c\n",
 				v1_id, v1_strand_symbol, v2_id,
 				v2_strand_symbol);
+			lq_arena_reset(scratch);
 			return -1;
 		} else if (v1_strand_symbol == v2_strand_symbol) {
 			v1_side = LEFT;
@@ -83,7 +88,7 @@ status_t handle_l(const char *l_line, u32 line_len, size_t idx, char **tokens,
 			    .v2_id = v2_id,
 			    .v2_side = v2_side};
 
-	tokens_free(tokens, EXPECTED_L_LINE_TOKENS);
+	lq_arena_reset(scratch);
 
 	return 0;
 }
@@ -98,11 +103,41 @@ void *t_handle_l(void *l_meta)
 	line *ll = meta->l_lines;
 	idx_t line_count = meta->l_line_count;
 
+	struct gfa_metrics_clock clock;
+	gfa_metrics_start(&clock, meta->metrics, NULL, 0);
+
 	// temporary storage for the tokens extracted from a given line
 	char *tokens[EXPECTED_L_LINE_TOKENS] = {NULL};
+	struct lq_arena *scratch = lq_arena_new(LQ_ARENA_BLOCK_SIZE);
+	if (scratch == NULL) {
+		log_fatal("Could not allocate scratch arena for L lines");
+		return NULL;
+	}
+
+	struct l_stats_acc *stats = meta->stats;
+	struct gfa_load_state *load = meta->load;
+	for (idx_t i = 0; i < line_count; i++) {
+		if (load && i % GFA_LOAD_CHECK_LINES == 0) {
+			gfa_load_publish(&load->progress.l_lines_parsed, i);
+			if (gfa_load_cancelled(load))
+				break;
+		}
 
-	for (idx_t i = 0; i < line_count; i++)
-		handle_l(ll[i].start, ll[i].len, i, tokens, edges);
+		status_t res = handle_l(ll[i].start, ll[i].len, i, tokens,
+					scratch, edges);
+		if (stats == NULL || res != SUCCESS)
+			continue;
+
+		stats_acc_edge(stats, &edges[i]);
+	}
+
+	lq_arena_destroy(&scratch);
+	gfa_metrics_lines(&clock, ll, line_count);
+	gfa_metrics_stop(&clock);
+	if (load && !gfa_load_cancelled(load)) {
+		gfa_load_publish(&load->progress.l_lines_parsed, line_count);
+		gfa_phase_done(load, GFA_PHASE_EDGES);
+	}
 
 	return NULL;
 }
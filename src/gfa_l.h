@@ -2,12 +2,28 @@
 #define LQ_GFA_L_H
 
 #include "../include/liteseq/gfa.h"
+#include "./gfa_stats.h"
+
+#ifdef __cplusplus
+extern "C" {
+namespace liteseq
+{
+#endif
 
 struct l_thread_meta {
 	edge *edges;
 	line *l_lines;
 	idx_t l_line_count;
+	struct l_stats_acc *stats; // NULL unless stats are collected
+	struct gfa_load_state *load; // NULL unless run by gfa_new_async
+	struct gfa_phase_metrics *metrics; // NULL unless recorded
 };
 
 void *t_handle_l(void *l_meta);
+
+#ifdef __cplusplus
+} // namespace liteseq
+} // extern "C"
+#endif
+
 #endif // LQ_GFA_L_H
@@ -0,0 +1,151 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <log.h>
+
+#include "../include/liteseq/gfa.h"
+#include "../include/liteseq/types.h"
+
+#include "./gfa_impl.h"
+#include "./gfa_load.h"
+
+struct gfa_load {
+	pthread_t thread;
+	gfa_props *gfa;
+	struct gfa_load_state state;
+};
+
+void gfa_phase_done(struct gfa_load_state *load, enum gfa_phase phase)
+{
+	if (!load)
+		return;
+
+	gfa_props *gfa = load->gfa;
+	pthread_mutex_lock(&gfa->lock);
+	gfa->phases_done |= 1u << phase;
+	pthread_cond_broadcast(&gfa->phase_cond);
+	pthread_mutex_unlock(&gfa->lock);
+}
+
+status_t gfa_wait(gfa_props *gfa, enum gfa_phase phase)
+{
+	if (!gfa || phase >= GFA_PHASE_COUNT)
+		return ERROR_CODE_INVALID_ARGUMENT;
+
+	pthread_mutex_lock(&gfa->lock);
+	while (!(gfa->phases_done & (1u << phase)))
+		pthread_cond_wait(&gfa->phase_cond, &gfa->lock);
+	// the status is final once the load failed, see t_load
+	status_t res = SUCCESS;
+	if (gfa->phases_done & GFA_PHASES_FAILED)
+		res = gfa->status != SUCCESS ? gfa->status : FAILURE;
+	pthread_mutex_unlock(&gfa->lock);
+
+	return res;
+}
+
+static void *t_load(void *arg)
+{
+	struct gfa_load *load = (struct gfa_load *)arg;
+	gfa_props *gfa = load->gfa;
+	load_gfa(gfa);
+	gfa->load = NULL;
+
+	// the status is final, wake those waiting on the phases left
+	pthread_mutex_lock(&gfa->lock);
+	gfa->phases_done |= GFA_PHASES_ALL;
+	if (gfa->status != SUCCESS)
+		gfa->phases_done |= GFA_PHASES_FAILED;
+	pthread_cond_broadcast(&gfa->phase_cond);
+	pthread_mutex_unlock(&gfa->lock);
+
+	// publishes the graph to whoever sees the stage
+	gfa_load_set_stage(&load->state, GFA_LOAD_DONE);
+
+	return NULL;
+}
+
+struct gfa_load *gfa_new_async(const gfa_config *conf)
+{
+	struct gfa_load *load = malloc(sizeof(struct gfa_load));
+	if (!load)
+		return NULL;
+	memset(&load->state, 0, sizeof(load->state));
+	load->state.progress.stage = GFA_LOAD_SCAN;
+
+	load->gfa = init_gfa(conf);
+	if (!load->gfa) {
+		free(load);
+		return NULL;
+	}
+	load->gfa->load = &load->state;
+	load->gfa->phases_done = 0;
+	load->state.gfa = load->gfa;
+
+	if (pthread_create(&load->thread, NULL, t_load, load) != 0) {
+		log_error("Failed to start loading %s", conf->fp);
+		gfa_free(load->gfa);
+		free(load);
+		return NULL;
+	}
+
+	return load;
+}
+
+gfa_props *gfa_load_graph(const struct gfa_load *load)
+{
+	return load->gfa;
+}
+
+bool gfa_load_poll(const struct gfa_load *load)
+{
+	return __atomic_load_n(&load->state.progress.stage,
+			       __ATOMIC_ACQUIRE) == GFA_LOAD_DONE;
+}
+
+void gfa_load_progress(const struct gfa_load *load, struct gfa_progress *out)
+{
+	const struct gfa_progress *p = &load->state.progress;
+
+	out->stage = __atomic_load_n(&p->stage, __ATOMIC_ACQUIRE);
+	out->file_size = __atomic_load_n(&p->file_size, __ATOMIC_RELAXED);
+	out->bytes_scanned =
+		__atomic_load_n(&p->bytes_scanned, __ATOMIC_RELAXED);
+	out->line_count = __atomic_load_n(&p->line_count, __ATOMIC_RELAXED);
+	out->lines_indexed =
+		__atomic_load_n(&p->lines_indexed, __ATOMIC_RELAXED);
+	out->s_line_count =
+		__atomic_load_n(&p->s_line_count, __ATOMIC_RELAXED);
+	out->s_lines_parsed =
+		__atomic_load_n(&p->s_lines_parsed, __ATOMIC_RELAXED);
+	out->l_line_count =
+		__atomic_load_n(&p->l_line_count, __ATOMIC_RELAXED);
+	out->l_lines_parsed =
+		__atomic_load_n(&p->l_lines_parsed, __ATOMIC_RELAXED);
+	out->ref_count = __atomic_load_n(&p->ref_count, __ATOMIC_RELAXED);
+	out->refs_parsed = __atomic_load_n(&p->refs_parsed, __ATOMIC_RELAXED);
+}
+
+void gfa_load_cancel(struct gfa_load *load)
+{
+	__atomic_store_n(&load->state.cancelled, true, __ATOMIC_RELAXED);
+}
+
+gfa_props *gfa_load_wait(struct gfa_load **load)
+{
+	if (!load || !*load)
+		return NULL;
+
+	pthread_join((*load)->thread, NULL);
+	gfa_props *gfa = (*load)->gfa;
+	free(*load);
+	*load = NULL;
+
+	if (gfa->status == ERROR_CODE_CANCELLED) {
+		gfa_free(gfa);
+		return NULL;
+	}
+
+	return gfa;
+}
@@ -0,0 +1,81 @@
+#ifndef LQ_GFA_LOAD_H
+#define LQ_GFA_LOAD_H
+
+#include "../include/liteseq/gfa.h"
+#include "./gfa_stats.h"
+
+#ifdef __cplusplus
+extern "C" {
+namespace liteseq
+{
+#endif
+
+/*
+ * The state of a load
+ * -------------------
+ * Shared by the thread of gfa_new_async, its workers and the caller. The
+ * workers write the progress and read the cancel flag with relaxed atomics,
+ * nothing is ordered by them but the end of the load, see gfa_load_poll.
+ */
+
+// how many lines a worker handles between looks at its load
+#define GFA_LOAD_CHECK_LINES 4096
+
+struct gfa_load_state {
+	gfa_props *gfa; // the graph being loaded
+	struct gfa_progress progress;
+	bool cancelled;
+};
+
+#define GFA_PHASES_ALL ((1u << GFA_PHASE_COUNT) - 1)
+#define GFA_PHASES_FAILED (1u << 31) // the load ended short of the rest
+
+static inline bool gfa_load_cancelled(const struct gfa_load_state *load)
+{
+	return load && __atomic_load_n(&load->cancelled, __ATOMIC_RELAXED);
+}
+
+static inline void gfa_load_publish(idx_t *counter, idx_t value)
+{
+	__atomic_store_n(counter, value, __ATOMIC_RELAXED);
+}
+
+static inline void gfa_load_set_stage(struct gfa_load_state *load,
+				      enum gfa_load_stage stage)
+{
+	if (load)
+		__atomic_store_n(&load->progress.stage, stage,
+				 __ATOMIC_RELEASE);
+}
+
+// mark phase of the graph of load done and wake its waiters, if there is a load
+void gfa_phase_done(struct gfa_load_state *load, enum gfa_phase phase);
+
+/**
+ * Map the file of a gfa fresh from init_gfa, index its lines and allocate the
+ * graph, the first half of load_gfa
+ *
+ * @return true when the lines are ready to be parsed, otherwise gfa->status
+ * says why not
+ */
+bool prepare_gfa(gfa_props *gfa);
+
+/**
+ * Set the loci, the stats and the occurrence index of a parsed gfa, the last
+ * of load_gfa. Releases the stats accumulators of the workers.
+ */
+status_t finish_gfa(gfa_props *gfa, u32 **seg_lens,
+		    struct l_stats_acc *l_stats);
+
+/**
+ * Map and parse the file of a gfa fresh from init_gfa, i.e. all of gfa_new.
+ * gfa->status is ERROR_CODE_CANCELLED when gfa->load was cancelled.
+ */
+void load_gfa(gfa_props *gfa);
+
+#ifdef __cplusplus
+} // namespace liteseq
+} // extern "C"
+#endif
+
+#endif // LQ_GFA_LOAD_H
@@ -0,0 +1,318 @@
+#if defined(__linux__)
+#define _GNU_SOURCE // st_mtim
+#endif
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <log.h>
+
+#include "../include/liteseq/gfa.h"
+#include "../include/liteseq/types.h"
+#include "../src/internal/lq_io.h"
+#include "../src/internal/lq_utils.h"
+
+#include "./gfa_impl.h"
+#include "./gfa_lqi.h"
+
+#define LQI_MAGIC "LQLQI\0\0\0"
+#define LQI_FORMAT_VERSION 1
+#define LQI_BYTE_ORDER 0x01020304
+#define LQI_SUFFIX ".lqi"
+
+struct lqi_header {
+	char magic[8];
+	u32 format_version;
+	u32 byte_order;
+
+	// the key, the size and the mtime of the GFA file
+	u64 gfa_size;
+	int64_t mtime_sec;
+	int64_t mtime_nsec;
+
+	u64 checksum; // of the header with this set to 0 and of the lines
+
+	u32 version;
+	u32 min_v_id;
+	u32 max_v_id;
+	idx_t s_line_count;
+	idx_t l_line_count;
+	idx_t p_line_count;
+	idx_t w_line_count;
+	u32 unused; // keeps the header free of padding
+};
+
+// a line with the offset of its start in the GFA file
+struct lqi_line {
+	u64 offset;
+	idx_t line_idx;
+	idx_t len;
+};
+
+static char *lqi_path(const char *fp)
+{
+	size_t n = strlen(fp) + sizeof(LQI_SUFFIX);
+	char *p = malloc(n);
+	if (p)
+		snprintf(p, n, "%s%s", fp, LQI_SUFFIX);
+
+	return p;
+}
+
+static u64 lqi_checksum(const struct lqi_header *h,
+			const struct lqi_line *lines, size_t line_count)
+{
+	struct lqi_header c = *h;
+	c.checksum = 0;
+
+	return lq_checksum(&c, sizeof(c)) ^
+	       lq_checksum(lines, sizeof(struct lqi_line) * line_count);
+}
+
+static size_t lqi_line_count(const struct lqi_header *h)
+{
+	return (size_t)h->s_line_count + h->l_line_count + h->p_line_count +
+	       h->w_line_count;
+}
+
+/*
+ * Loading
+ * -------
+ */
+
+static status_t unpack_lines(const gfa_props *gfa, const struct lqi_line *src,
+			     idx_t count, char prefix, line **dst)
+{
+	line *lines = malloc(sizeof(line) * (count ? count : 1));
+	if (!lines)
+		return ERROR_CODE_OUT_OF_MEMORY;
+
+	for (idx_t i = 0; i < count; i++) {
+		const struct lqi_line *l = &src[i];
+		// a cheap guard against a file rewritten within the same mtime
+		if (l->offset + l->len > gfa->file_size ||
+		    gfa->start[l->offset] != prefix) {
+			free(lines);
+			return FAILURE;
+		}
+
+		lines[i] = (line){.start = gfa->start + l->offset,
+				  .line_idx = l->line_idx,
+				  .len = l->len};
+	}
+	*dst = lines;
+
+	return SUCCESS;
+}
+
+static status_t unpack_line_index(gfa_props *gfa, const struct lqi_header *h,
+				  const struct lqi_line *lines)
+{
+	const struct lqi_line *s = lines;
+	const struct lqi_line *l = s + h->s_line_count;
+	const struct lqi_line *p = l + h->l_line_count;
+	const struct lqi_line *w = p + h->p_line_count;
+
+	line *s_lines = NULL, *l_lines = NULL, *p_lines = NULL, *w_lines = NULL;
+	status_t res = unpack_lines(gfa, s, h->s_line_count, GFA_S_LINE,
+				    &s_lines);
+	if (res == SUCCESS)
+		res = unpack_lines(gfa, l, h->l_line_count, GFA_L_LINE,
+				   &l_lines);
+	if (res == SUCCESS)
+		res = unpack_lines(gfa, p, h->p_line_count, GFA_P_LINE,
+				   &p_lines);
+	if (res == SUCCESS)
+		res = unpack_lines(gfa, w, h->w_line_count, GFA_W_LINE,
+				   &w_lines);
+	if (res != SUCCESS) {
+		free(s_lines);
+		free(l_lines);
+		free(p_lines);
+		free(w_lines);
+		return res;
+	}
+
+	gfa->s_lines = s_lines;
+	gfa->l_lines = l_lines;
+	gfa->p_lines = p_lines;
+	gfa->w_lines = w_lines;
+
+	gfa->version = h->version;
+	gfa->min_v_id = h->min_v_id;
+	gfa->max_v_id = h->max_v_id;
+	gfa->vtx_arr_size = gfa_vtx_arr_size(gfa);
+	gfa->s_line_count = h->s_line_count;
+	gfa->l_line_count = h->l_line_count;
+	gfa->p_line_count = h->p_line_count;
+	gfa->w_line_count = h->w_line_count;
+
+	return SUCCESS;
+}
+
+// the mtime of sb, macOS has it as st_mtimespec
+static void stat_mtime(const struct stat *sb, int64_t *sec, int64_t *nsec)
+{
+#if defined(__APPLE__)
+	*sec = sb->st_mtimespec.tv_sec;
+	*nsec = sb->st_mtimespec.tv_nsec;
+#else
+	*sec = sb->st_mtim.tv_sec;
+	*nsec = sb->st_mtim.tv_nsec;
+#endif
+}
+
+static bool lqi_valid(const gfa_props *gfa, const struct stat *gfa_sb,
+		      const struct lqi_header *h, size_t lqi_size)
+{
+	if (lqi_size < sizeof(struct lqi_header) ||
+	    memcmp(h->magic, LQI_MAGIC, sizeof(h->magic)) != 0 ||
+	    h->format_version != LQI_FORMAT_VERSION ||
+	    h->byte_order != LQI_BYTE_ORDER)
+		return false;
+
+	int64_t mtime_sec, mtime_nsec;
+	stat_mtime(gfa_sb, &mtime_sec, &mtime_nsec);
+	if (h->gfa_size != gfa->file_size ||
+	    h->gfa_size != (u64)gfa_sb->st_size || h->mtime_sec != mtime_sec ||
+	    h->mtime_nsec != mtime_nsec)
+		return false;
+
+	size_t line_count = lqi_line_count(h);
+	if (lqi_size != sizeof(struct lqi_header) +
+				sizeof(struct lqi_line) * line_count)
+		return false;
+
+	const struct lqi_line *lines = (const struct lqi_line *)(h + 1);
+	return h->checksum == lqi_checksum(h, lines, line_count);
+}
+
+status_t load_line_index(gfa_props *gfa)
+{
+	struct stat gfa_sb;
+	if (!gfa->start || stat(gfa->fp, &gfa_sb) != 0)
+		return FAILURE;
+
+	char *path = lqi_path(gfa->fp);
+	if (!path)
+		return ERROR_CODE_OUT_OF_MEMORY;
+	int fd = open(path, O_RDONLY);
+	free(path);
+	if (fd == -1)
+		return FAILURE;
+
+	struct stat sb;
+	void *base = MAP_FAILED;
+	if (fstat(fd, &sb) == 0 && sb.st_size > 0)
+		base = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED)
+		return FAILURE;
+
+	const struct lqi_header *h = base;
+	const struct lqi_line *lines = (const struct lqi_line *)(h + 1);
+	status_t res = FAILURE;
+	if (lqi_valid(gfa, &gfa_sb, h, sb.st_size))
+		res = unpack_line_index(gfa, h, lines);
+	munmap(base, sb.st_size);
+
+	return res;
+}
+
+/*
+ * Saving
+ * ------
+ */
+
+static struct lqi_line *pack_lines(const gfa_props *gfa, const line *src,
+				   idx_t count, struct lqi_line *dst)
+{
+	for (idx_t i = 0; i < count; i++)
+		dst[i] = (struct lqi_line){
+			.offset = (u64)(src[i].start - gfa->start),
+			.line_idx = src[i].line_idx,
+			.len = src[i].len,
+		};
+
+	return dst + count;
+}
+
+status_t save_line_index(const gfa_props *gfa)
+{
+	struct stat gfa_sb;
+	// not while a line at the end of the file is left unparsed
+	if (!gfa->start || gfa->end != gfa->start + gfa->file_size ||
+	    stat(gfa->fp, &gfa_sb) != 0 ||
+	    (size_t)gfa_sb.st_size != gfa->file_size)
+		return FAILURE;
+
+	struct lqi_header h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, LQI_MAGIC, sizeof(h.magic));
+	h.format_version = LQI_FORMAT_VERSION;
+	h.byte_order = LQI_BYTE_ORDER;
+	h.gfa_size = gfa->file_size;
+	stat_mtime(&gfa_sb, &h.mtime_sec, &h.mtime_nsec);
+	h.version = gfa->version;
+	h.min_v_id = gfa->min_v_id;
+	h.max_v_id = gfa->max_v_id;
+	h.s_line_count = gfa->s_line_count;
+	h.l_line_count = gfa->l_line_count;
+	h.p_line_count = gfa->p_line_count;
+	h.w_line_count = gfa->w_line_count;
+
+	size_t line_count = lqi_line_count(&h);
+	struct lqi_line *lines =
+		malloc(sizeof(struct lqi_line) * (line_count ? line_count : 1));
+	if (!lines)
+		return ERROR_CODE_OUT_OF_MEMORY;
+
+	struct lqi_line *l = lines;
+	l = pack_lines(gfa, gfa->s_lines, gfa->s_line_count, l);
+	l = pack_lines(gfa, gfa->l_lines, gfa->l_line_count, l);
+	l = pack_lines(gfa, gfa->p_lines, gfa->p_line_count, l);
+	pack_lines(gfa, gfa->w_lines, gfa->w_line_count, l);
+	h.checksum = lqi_checksum(&h, lines, line_count);
+
+	// written next to the sidecar and renamed over it so that concurrent
+	// readers never see half of one
+	char *path = lqi_path(gfa->fp);
+	size_t tmp_len = path ? strlen(path) + sizeof(".tmp") : 0;
+	char *tmp = path ? malloc(tmp_len) : NULL;
+	if (!tmp) {
+		free(path);
+		free(lines);
+		return ERROR_CODE_OUT_OF_MEMORY;
+	}
+	snprintf(tmp, tmp_len, "%s.tmp", path);
+
+	status_t res = FAILURE;
+	int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd != -1) {
+		res = lq_pwrite_all(fd, &h, sizeof(h), 0);
+		size_t lines_size = sizeof(struct lqi_line) * line_count;
+		if (res == SUCCESS)
+			res = lq_pwrite_all(fd, lines, lines_size, sizeof(h));
+		if (close(fd) != 0)
+			res = FAILURE;
+	}
+
+	if (res == SUCCESS && rename(tmp, path) != 0)
+		res = FAILURE;
+	if (res != SUCCESS) {
+		log_error("Failed to write the line index %s", path);
+		unlink(tmp);
+	}
+
+	free(tmp);
+	free(path);
+	free(lines);
+
+	return res;
+}
@@ -0,0 +1,39 @@
+#ifndef LQ_GFA_LQI_H
+#define LQ_GFA_LQI_H
+
+#include "../include/liteseq/gfa.h"
+
+#ifdef __cplusplus
+extern "C" {
+namespace liteseq
+{
+#endif
+
+/*
+ * The line index sidecar
+ * ----------------------
+ * <fp>.lqi holds what analyse_gfa_structure and index_lines compute, i.e.
+ * the version, the line counts, the vertex id bounds and the line tables with
+ * offsets into the file in place of pointers. It is keyed by the size and the
+ * mtime of the GFA file and is ignored once either changes.
+ */
+
+/**
+ * Fill the counts, bounds and line tables of a mapped gfa from its sidecar.
+ *
+ * @return SUCCESS or FAILURE when there is no valid sidecar, in which case gfa
+ * is left as it was
+ */
+status_t load_line_index(gfa_props *gfa);
+
+/**
+ * Write the sidecar of an indexed gfa, replacing any previous one
+ */
+status_t save_line_index(const gfa_props *gfa);
+
+#ifdef __cplusplus
+} // namespace liteseq
+} // extern "C"
+#endif
+
+#endif // LQ_GFA_LQI_H
@@ -0,0 +1,241 @@
+#if defined(__linux__)
+#define _GNU_SOURCE // RUSAGE_THREAD
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include "../include/liteseq/gfa.h"
+#include "../include/liteseq/types.h"
+#include "../src/internal/lq_arena.h"
+
+#include "./gfa_metrics.h"
+
+#define NS_PER_S 1000000000ull
+
+DEFINE_ENUM_AND_STRING(gfa_metric, GFA_METRIC_ITEMS)
+
+static u64 clock_ns(clockid_t id)
+{
+	struct timespec ts;
+	if (clock_gettime(id, &ts) != 0)
+		return 0;
+
+	return (u64)ts.tv_sec * NS_PER_S + (u64)ts.tv_nsec;
+}
+
+u64 gfa_metrics_now(void)
+{
+	return clock_ns(CLOCK_MONOTONIC);
+}
+
+// the page faults of the calling thread, or of the process if it has workers
+static void read_faults(u32 workers, u64 *minor, u64 *major)
+{
+	int who = RUSAGE_SELF;
+#ifdef RUSAGE_THREAD
+	if (!workers)
+		who = RUSAGE_THREAD;
+#endif
+
+	struct rusage ru;
+	if (getrusage(who, &ru) != 0) {
+		*minor = *major = 0;
+		return;
+	}
+	*minor = (u64)ru.ru_minflt;
+	*major = (u64)ru.ru_majflt;
+}
+
+static clockid_t cpu_clock(u32 workers)
+{
+	return workers ? CLOCK_PROCESS_CPUTIME_ID : CLOCK_THREAD_CPUTIME_ID;
+}
+
+void gfa_metrics_start(struct gfa_metrics_clock *c, struct gfa_phase_metrics *m,
+		       const struct lq_arena *arena, u32 workers)
+{
+	*c = (struct gfa_metrics_clock){
+		.m = m,
+		.arena = arena,
+		.workers = workers,
+	};
+	if (!m)
+		return;
+
+	c->start_ns = gfa_metrics_now();
+	c->cpu_ns = clock_ns(cpu_clock(workers));
+	read_faults(workers, &c->minor_faults, &c->major_faults);
+	if (arena) {
+		c->allocs = arena->alloc_count;
+		c->heap_allocs = arena->block_allocs;
+	}
+}
+
+void gfa_metrics_lines(struct gfa_metrics_clock *c, const line *lines,
+		       idx_t count)
+{
+	if (!c->m)
+		return;
+
+	u64 bytes = 0;
+	for (idx_t i = 0; i < count; i++)
+		bytes += lines[i].len + 1; // and the newline
+
+	c->bytes += bytes;
+	c->lines += count;
+}
+
+static inline void add_u64(u64 *to, u64 v)
+{
+	__atomic_fetch_add(to, v, __ATOMIC_RELAXED);
+}
+
+// lower *to to v, 0 being unset
+static void min_u64(u64 *to, u64 v)
+{
+	u64 cur = __atomic_load_n(to, __ATOMIC_RELAXED);
+	while ((cur == 0 || v < cur) &&
+	       !__atomic_compare_exchange_n(to, &cur, v, true, __ATOMIC_RELAXED,
+					    __ATOMIC_RELAXED))
+		;
+}
+
+static void max_u64(u64 *to, u64 v)
+{
+	u64 cur = __atomic_load_n(to, __ATOMIC_RELAXED);
+	while (v > cur &&
+	       !__atomic_compare_exchange_n(to, &cur, v, true, __ATOMIC_RELAXED,
+					    __ATOMIC_RELAXED))
+		;
+}
+
+void gfa_metrics_stop(struct gfa_metrics_clock *c)
+{
+	struct gfa_phase_metrics *m = c->m;
+	if (!m)
+		return;
+
+	u64 end_ns = gfa_metrics_now();
+	u64 cpu_ns = clock_ns(cpu_clock(c->workers));
+	u64 minor, major;
+	read_faults(c->workers, &minor, &major);
+
+	min_u64(&m->start_ns, c->start_ns);
+	max_u64(&m->end_ns, end_ns);
+	add_u64(&m->cpu_ns, cpu_ns - c->cpu_ns);
+	add_u64(&m->bytes, c->bytes);
+	__atomic_fetch_add(&m->lines, c->lines, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&m->threads, c->workers ? c->workers : 1,
+			   __ATOMIC_RELAXED);
+	add_u64(&m->minor_faults, minor - c->minor_faults);
+	add_u64(&m->major_faults, major - c->major_faults);
+	if (c->arena) {
+		add_u64(&m->allocs, c->arena->alloc_count - c->allocs);
+		add_u64(&m->heap_allocs,
+			c->arena->block_allocs - c->heap_allocs);
+	}
+}
+
+void gfa_metrics_close(struct gfa_metrics *m)
+{
+	for (idx_t i = 0; i < GFA_METRIC_COUNT; i++) {
+		struct gfa_phase_metrics *p = &m->phases[i];
+		p->wall_ns = p->threads ? p->end_ns - p->start_ns : 0;
+	}
+	m->wall_ns = gfa_metrics_now() - m->start_ns;
+}
+
+/*
+ * Output
+ * ------
+ */
+
+static inline double ms(u64 ns)
+{
+	return (double)ns / 1e6;
+}
+
+// MB/s of bytes over ns, 0 for a phase too short to tell
+static double mb_per_s(u64 bytes, u64 ns)
+{
+	return ns ? (double)bytes / 1e6 / ((double)ns / 1e9) : 0.0;
+}
+
+static status_t flush_status(FILE *fp)
+{
+	return fflush(fp) == 0 && !ferror(fp) ? SUCCESS : FAILURE;
+}
+
+status_t gfa_metrics_print(const struct gfa_metrics *m, FILE *fp)
+{
+	if (!m || !fp)
+		return ERROR_CODE_INVALID_ARGUMENT;
+
+	fprintf(fp, "%-10s %10s %10s %9s %10s %7s %10s %6s %9s %6s\n",
+		"phase", "wall_ms", "cpu_ms", "MB/s", "lines", "threads",
+		"allocs", "blocks", "min_flt", "maj_flt");
+
+	for (idx_t i = 0; i < GFA_METRIC_COUNT; i++) {
+		const struct gfa_phase_metrics *p = &m->phases[i];
+		if (!p->threads)
+			continue;
+		// a rate only for the phases that go through the lines
+		double rate = p->lines ? mb_per_s(p->bytes, p->wall_ns) : 0.0;
+		fprintf(fp,
+			"%-10s %10.3f %10.3f %9.1f %10u %7u %10llu %6llu %9llu "
+			"%6llu\n",
+			to_string_gfa_metric((enum gfa_metric)i),
+			ms(p->wall_ns), ms(p->cpu_ns), rate, p->lines,
+			p->threads,
+			(unsigned long long)p->allocs,
+			(unsigned long long)p->heap_allocs,
+			(unsigned long long)p->minor_faults,
+			(unsigned long long)p->major_faults);
+	}
+
+	fprintf(fp, "%-10s %10.3f %10s %9.1f  %llu bytes, %u threads%s\n",
+		"total", ms(m->wall_ns), "", mb_per_s(m->file_size, m->wall_ns),
+		(unsigned long long)m->file_size, m->thread_count,
+		m->line_index_hit ? ", lines from the .lqi" : "");
+
+	return flush_status(fp);
+}
+
+status_t gfa_metrics_json(const struct gfa_metrics *m, FILE *fp)
+{
+	if (!m || !fp)
+		return ERROR_CODE_INVALID_ARGUMENT;
+
+	fprintf(fp,
+		"{\"wall_ns\":%llu,\"file_size\":%llu,\"thread_count\":%u,"
+		"\"line_index_hit\":%s,\"phases\":{",
+		(unsigned long long)m->wall_ns,
+		(unsigned long long)m->file_size, m->thread_count,
+		m->line_index_hit ? "true" : "false");
+
+	for (idx_t i = 0; i < GFA_METRIC_COUNT; i++) {
+		const struct gfa_phase_metrics *p = &m->phases[i];
+		// from the start of the load, to line the phases up
+		u64 offset_ns = p->threads ? p->start_ns - m->start_ns : 0;
+		fprintf(fp,
+			"%s\"%s\":{\"offset_ns\":%llu,\"wall_ns\":%llu,"
+			"\"cpu_ns\":%llu,\"bytes\":%llu,\"lines\":%u,"
+			"\"threads\":%u,\"allocs\":%llu,\"heap_allocs\":%llu,"
+			"\"minor_faults\":%llu,\"major_faults\":%llu}",
+			i ? "," : "", to_string_gfa_metric((enum gfa_metric)i),
+			(unsigned long long)offset_ns,
+			(unsigned long long)p->wall_ns,
+			(unsigned long long)p->cpu_ns,
+			(unsigned long long)p->bytes, p->lines, p->threads,
+			(unsigned long long)p->allocs,
+			(unsigned long long)p->heap_allocs,
+			(unsigned long long)p->minor_faults,
+			(unsigned long long)p->major_faults);
+	}
+	fprintf(fp, "}}\n");
+
+	return flush_status(fp);
+}
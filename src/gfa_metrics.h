@@ -0,0 +1,60 @@
+#ifndef LQ_GFA_METRICS_H
+#define LQ_GFA_METRICS_H
+
+#include "../include/liteseq/gfa.h"
+#include "../include/liteseq/types.h"
+#include "../src/internal/lq_arena.h"
+
+#ifdef __cplusplus
+extern "C" {
+namespace liteseq
+{
+#endif
+
+/*
+ * Recording the metrics of a load
+ * -------------------------------
+ * A thread starts a clock as it takes up a phase and stops it when it is done,
+ * which adds what it did to the phase. Threads that share a phase, such as
+ * the chunks of gfa_new_batch, add to it with atomics.
+ */
+
+struct gfa_metrics_clock {
+	struct gfa_phase_metrics *m;  // NULL when the phase is not recorded
+	const struct lq_arena *arena; // of the graph it allocates from or NULL
+	u32 workers;		      // the threads it starts, 0 for none
+	u64 start_ns;
+	u64 cpu_ns;
+	u64 allocs;
+	u64 heap_allocs;
+	u64 minor_faults;
+	u64 major_faults;
+	u64 bytes;
+	idx_t lines;
+};
+
+u64 gfa_metrics_now(void);
+
+/**
+ * Start timing phase m on the calling thread, m may be NULL. A phase that
+ * starts workers of its own is timed on the cpu clock and the page faults of
+ * the process, otherwise on those of the thread.
+ */
+void gfa_metrics_start(struct gfa_metrics_clock *c, struct gfa_phase_metrics *m,
+		       const struct lq_arena *arena, u32 workers);
+
+// count the count lines of lines as handled by the phase
+void gfa_metrics_lines(struct gfa_metrics_clock *c, const line *lines,
+		       idx_t count);
+
+void gfa_metrics_stop(struct gfa_metrics_clock *c);
+
+// set the wall times once the load is done
+void gfa_metrics_close(struct gfa_metrics *m);
+
+#ifdef __cplusplus
+} // namespace liteseq
+} // extern "C"
+#endif
+
+#endif // LQ_GFA_METRICS_H
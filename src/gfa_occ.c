@@ -0,0 +1,196 @@
+#include <stdlib.h>
+
+#include <log.h>
+
+#include "../include/liteseq/gfa.h"
+#include "../include/liteseq/refs.h"
+#include "../include/liteseq/types.h"
+#include "../src/internal/lq_utils.h"
+
+#include "./gfa_occ.h"
+
+static inline u32 *thread_counts(const struct occ_thread_meta *m)
+{
+	return m->counts + (size_t)m->thread_idx * m->gfa->vtx_arr_size;
+}
+
+void *t_count_occs(void *meta)
+{
+	struct occ_thread_meta *m = (struct occ_thread_meta *)meta;
+	u32 *counts = thread_counts(m);
+	u32 vtx_arr_size = m->gfa->vtx_arr_size;
+
+	for (idx_t i = m->ref_start; i < m->ref_end; i++) {
+		const struct ref *r = m->gfa->refs[i];
+		const id_t *v_ids = get_walk_v_ids(r);
+		idx_t step_count = get_step_count(r);
+		for (idx_t j = 0; j < step_count; j++) {
+			u32 slot = gfa_vtx_slot(m->gfa, v_ids[j]);
+			if (likely(slot < vtx_arr_size))
+				counts[slot]++;
+		}
+	}
+
+	return NULL;
+}
+
+void *t_sum_occs(void *meta)
+{
+	struct occ_thread_meta *m = (struct occ_thread_meta *)meta;
+	size_t stride = m->gfa->vtx_arr_size;
+
+	// turn the counts of each vertex into exclusive offsets of the workers
+	// within its bucket, offsets[v + 1] holds the size of the bucket until
+	// the serial prefix sum
+	for (id_t v = m->v_start; v < m->v_end; v++) {
+		u32 sum = 0;
+		for (u32 t = 0; t < m->thread_count; t++) {
+			u32 *c = &m->counts[t * stride + v];
+			u32 n = *c;
+			*c = sum;
+			sum += n;
+		}
+		m->offsets[v + 1] = sum;
+	}
+
+	return NULL;
+}
+
+void *t_fill_occs(void *meta)
+{
+	struct occ_thread_meta *m = (struct occ_thread_meta *)meta;
+	u32 *cursors = thread_counts(m);
+	const u64 *offsets = m->offsets;
+	u32 vtx_arr_size = m->gfa->vtx_arr_size;
+
+	for (idx_t i = m->ref_start; i < m->ref_end; i++) {
+		const struct ref *r = m->gfa->refs[i];
+		const id_t *v_ids = get_walk_v_ids(r);
+		idx_t step_count = get_step_count(r);
+		for (idx_t j = 0; j < step_count; j++) {
+			u32 slot = gfa_vtx_slot(m->gfa, v_ids[j]);
+			if (unlikely(slot >= vtx_arr_size))
+				continue;
+			u64 k = offsets[slot] + cursors[slot]++;
+			m->occs[k] = (struct vtx_occ){.ref_idx = i, .step = j};
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Split the refs into contiguous ranges with about the same number of steps
+ * and the vertices into equal ranges, one of each per worker
+ */
+static void partition(gfa_props *gfa, u64 step_total,
+		      struct occ_thread_meta *metas, u32 thread_count)
+{
+	idx_t ref_idx = 0;
+	u64 seen = 0;
+	u32 vtx_arr_size = gfa->vtx_arr_size;
+
+	for (u32 t = 0; t < thread_count; t++) {
+		struct occ_thread_meta *m = &metas[t];
+		u64 target = step_total * (t + 1) / thread_count;
+
+		m->ref_start = ref_idx;
+		while (ref_idx < gfa->ref_count &&
+		       (seen < target || t + 1 == thread_count))
+			seen += get_step_count(gfa->refs[ref_idx++]);
+		m->ref_end = ref_idx;
+
+		m->v_start = (u64)vtx_arr_size * t / thread_count;
+		m->v_end = (u64)vtx_arr_size * (t + 1) / thread_count;
+	}
+}
+
+status_t gfa_build_occ_index(gfa_props *gfa)
+{
+	if (!gfa || !gfa->inc_refs || !gfa->refs)
+		return ERROR_CODE_INVALID_ARGUMENT;
+
+	if (gfa->occ_offsets)
+		return SUCCESS; // already built
+
+	u64 step_total = 0;
+	for (idx_t i = 0; i < gfa->ref_count; i++)
+		step_total += get_step_count(gfa->refs[i]);
+
+	// every worker has a count for each vertex, don't let those outgrow
+	// the index itself on graphs with few steps per vertex
+	u32 thread_count = gfa->thread_count ? gfa->thread_count : 1;
+	u64 max_threads = gfa->vtx_arr_size > 0
+				  ? step_total * 2 / gfa->vtx_arr_size
+				  : 0;
+	if (thread_count > max_threads)
+		thread_count = max_threads > 0 ? (u32)max_threads : 1;
+
+	status_t res = ERROR_CODE_OUT_OF_MEMORY;
+	u64 *offsets = malloc(sizeof(u64) * ((size_t)gfa->vtx_arr_size + 1));
+	struct vtx_occ *occs = malloc(sizeof(struct vtx_occ) * step_total);
+	u32 *counts =
+		calloc((size_t)thread_count * gfa->vtx_arr_size, sizeof(u32));
+	struct occ_thread_meta *metas =
+		malloc(sizeof(struct occ_thread_meta) * thread_count);
+	if (!offsets || (!occs && step_total > 0) || !counts || !metas)
+		goto cleanup;
+
+	for (u32 t = 0; t < thread_count; t++) {
+		metas[t] = (struct occ_thread_meta){
+			.gfa = gfa,
+			.thread_idx = t,
+			.thread_count = thread_count,
+			.counts = counts,
+			.offsets = offsets,
+			.occs = occs,
+		};
+	}
+	partition(gfa, step_total, metas, thread_count);
+
+	size_t meta_size = sizeof(struct occ_thread_meta);
+	res = lq_run_threads(thread_count, t_count_occs, metas, meta_size);
+	if (res != SUCCESS)
+		goto cleanup;
+
+	res = lq_run_threads(thread_count, t_sum_occs, metas, meta_size);
+	if (res != SUCCESS)
+		goto cleanup;
+
+	offsets[0] = 0;
+	for (u32 v = 0; v < gfa->vtx_arr_size; v++)
+		offsets[v + 1] += offsets[v];
+
+	res = lq_run_threads(thread_count, t_fill_occs, metas, meta_size);
+	if (res != SUCCESS)
+		goto cleanup;
+
+	gfa->occ_offsets = offsets;
+	gfa->occs = occs;
+	offsets = NULL;
+	occs = NULL;
+
+cleanup:
+	if (res != SUCCESS)
+		log_error("Failed to build the occurrence index");
+	free(offsets);
+	free(occs);
+	free(counts);
+	free(metas);
+
+	return res;
+}
+
+const struct vtx_occ *get_vtx_occs(const gfa_props *gfa, id_t v_id,
+				   idx_t *count)
+{
+	*count = 0;
+	u32 slot = gfa_vtx_slot(gfa, v_id);
+	if (!gfa->occ_offsets || slot >= gfa->vtx_arr_size)
+		return NULL;
+
+	u64 start = gfa->occ_offsets[slot];
+	*count = (idx_t)(gfa->occ_offsets[slot + 1] - start);
+
+	return *count > 0 ? gfa->occs + start : NULL;
+}
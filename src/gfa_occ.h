@@ -0,0 +1,35 @@
+#ifndef LQ_GFA_OCC_H
+#define LQ_GFA_OCC_H
+
+#include "../include/liteseq/gfa.h"
+
+/*
+ * The occurrence index is built in three parallel passes over contiguous
+ * ranges of refs, each worker owning one of these
+ */
+struct occ_thread_meta {
+	const gfa_props *gfa;
+
+	// the refs [ref_start, ref_end) this worker reads
+	idx_t ref_start;
+	idx_t ref_end;
+
+	// the vertices [v_start, v_end) this worker sums in the second pass
+	id_t v_start;
+	id_t v_end;
+
+	u32 thread_idx;
+	u32 thread_count;
+
+	// counts[t * vtx_arr_size + v] is the number of steps of worker t
+	// through v, later the offset of worker t within the bucket of v
+	u32 *counts;
+	u64 *offsets;
+	struct vtx_occ *occs;
+};
+
+void *t_count_occs(void *meta);
+void *t_sum_occs(void *meta);
+void *t_fill_occs(void *meta);
+
+#endif // LQ_GFA_OCC_H
@@ -0,0 +1,482 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <log.h>
+
+#include "../include/liteseq/gfa.h"
+#include "../include/liteseq/types.h"
+#include "../src/internal/lq_io.h"
+#include "../src/internal/lq_utils.h"
+
+#include "./gfa_adj.h"
+#include "./gfa_impl.h"
+#include "./gfa_l.h"
+#include "./gfa_lqi.h"
+#include "./gfa_s.h"
+#include "./gfa_stats.h"
+#include "./refs/ref_impl.h"
+#include "./refs/ref_lookup.h"
+
+/*
+ * Refreshing
+ * ----------
+ * The vertices, labels and refs live in the arenas and not in the mapping, so
+ * the file can be mapped again at its new size with only the line tables
+ * rebased onto the new mapping. The lines of the tail are then parsed into a
+ * copy of the graph, with new arrays that hold the existing entries and room
+ * for the new ones, and new indexes over them. The copy is swapped in at the
+ * end and the arrays it replaces are kept until gfa_free, so that readers
+ * holding them are not disturbed.
+ */
+
+// the lines of the tail, in the order they are in the file
+struct tail {
+	line *lines[4]; // S, L, P, W
+	idx_t counts[4];
+};
+
+enum { TAIL_S, TAIL_L, TAIL_P, TAIL_W };
+
+static int tail_kind(char prefix)
+{
+	switch (prefix) {
+	case GFA_S_LINE:
+		return TAIL_S;
+	case GFA_L_LINE:
+		return TAIL_L;
+	case GFA_P_LINE:
+		return TAIL_P;
+	case GFA_W_LINE:
+		return TAIL_W;
+	case GFA_H_LINE:
+		return -1;
+	default:
+		return -2;
+	}
+}
+
+// one past the last line index in the tables, the tables are in file order
+static idx_t next_line_idx(const gfa_props *gfa)
+{
+	const line *tables[] = {gfa->s_lines, gfa->l_lines, gfa->p_lines,
+				gfa->w_lines};
+	const idx_t counts[] = {gfa->s_line_count, gfa->l_line_count,
+				gfa->p_line_count, gfa->w_line_count};
+
+	idx_t next = 0;
+	for (int k = 0; k < 4; k++)
+		if (counts[k] > 0 && tables[k][counts[k] - 1].line_idx >= next)
+			next = tables[k][counts[k] - 1].line_idx + 1;
+
+	return next;
+}
+
+/**
+ * Count then collect the complete lines in [from, gfa->end), updating the
+ * vertex id bounds
+ */
+static status_t index_tail(gfa_props *gfa, char *from, struct tail *t)
+{
+	idx_t linum = next_line_idx(gfa);
+	for (char *c = from; c < gfa->end;) {
+		char *newline = memchr(c, NEWLINE, gfa->end - c);
+		int kind = tail_kind(c[0]);
+		if (kind == -2) {
+			log_error("Unsupported line type: [%c] on line: [%u]",
+				  c[0], linum);
+			return ERROR_CODE_INVALID_ARGUMENT;
+		}
+		if (kind == TAIL_S)
+			set_v_id_bounds(c, gfa, linum);
+		if (kind >= 0)
+			t->counts[kind]++;
+		c = newline + 1;
+		linum++;
+	}
+
+	for (int k = 0; k < 4; k++) {
+		t->lines[k] = malloc(sizeof(line) * (t->counts[k] + 1));
+		if (!t->lines[k])
+			return ERROR_CODE_OUT_OF_MEMORY;
+	}
+
+	idx_t filled[4] = {0};
+	linum = next_line_idx(gfa);
+	for (char *c = from; c < gfa->end;) {
+		char *newline = memchr(c, NEWLINE, gfa->end - c);
+		int kind = tail_kind(c[0]);
+		if (kind >= 0)
+			t->lines[kind][filled[kind]++] =
+				(line){.start = c,
+				       .line_idx = linum,
+				       .len = (idx_t)(newline - c)};
+		c = newline + 1;
+		linum++;
+	}
+
+	return SUCCESS;
+}
+
+static void tail_free(struct tail *t)
+{
+	for (int k = 0; k < 4; k++)
+		free(t->lines[k]);
+}
+
+/**
+ * Map the file again up to its last newline and rebase the line tables
+ *
+ * @return SUCCESS with *from at the start of the new lines, which is gfa->end
+ * when there are none
+ */
+static status_t remap(gfa_props *gfa, char **from)
+{
+	size_t old_size = gfa->end - gfa->start;
+	*from = gfa->end;
+
+	struct stat sb;
+	if (stat(gfa->fp, &sb) != 0) {
+		log_error("Failed to stat %s", gfa->fp);
+		return FAILURE;
+	}
+	size_t size = sb.st_size;
+	if (size < old_size) {
+		log_error("%s shrank from %zu to %zu bytes", gfa->fp, old_size,
+			  size);
+		return ERROR_CODE_INVALID_ARGUMENT;
+	}
+	if (size == old_size)
+		return SUCCESS;
+	if (old_size > 0 && gfa->end[-1] != NEWLINE) {
+		log_error("%s did not end in a newline", gfa->fp);
+		return ERROR_CODE_INVALID_ARGUMENT;
+	}
+
+	char *mapped = NULL;
+	size_t mapped_size = 0;
+	open_mmap(gfa->fp, &mapped, &mapped_size);
+	if (mapped == NULL || mapped == MAP_FAILED)
+		return FAILURE;
+
+	// a line still being written is left for the next refresh
+	char *last =
+		lq_memrchr(mapped + old_size, NEWLINE, mapped_size - old_size);
+	if (!last) {
+		close_mmap(mapped, mapped_size);
+		return SUCCESS;
+	}
+
+	line *tables[] = {gfa->s_lines, gfa->l_lines, gfa->p_lines,
+			  gfa->w_lines};
+	idx_t counts[] = {gfa->s_line_count, gfa->l_line_count,
+			  gfa->p_line_count, gfa->w_line_count};
+	for (int k = 0; k < 4; k++)
+		for (idx_t i = 0; i < counts[k]; i++)
+			tables[k][i].start = mapped + (tables[k][i].start -
+						       gfa->start);
+
+	close_mmap(gfa->start, gfa->file_size);
+	gfa->start = mapped;
+	gfa->end = last + 1;
+	gfa->file_size = mapped_size;
+	*from = mapped + old_size;
+
+	return SUCCESS;
+}
+
+// a copy of the count elements of arr with room for new_count of them
+static void *copy_grown(const void *arr, size_t elem_size, size_t count,
+			size_t new_count)
+{
+	void *p = malloc(elem_size * (new_count ? new_count : 1));
+	if (p && count)
+		memcpy(p, arr, elem_size * count);
+
+	return p;
+}
+
+// the line tables are only read by the loader, they grow in place
+static status_t append_lines(line **table, idx_t count, const line *tail,
+			     idx_t tail_count)
+{
+	idx_t n = count + tail_count;
+	line *p = realloc(*table, sizeof(line) * (n ? n : 1));
+	if (!p)
+		return ERROR_CODE_OUT_OF_MEMORY;
+	memcpy(p + count, tail, sizeof(line) * tail_count);
+	*table = p;
+
+	return SUCCESS;
+}
+
+/**
+ * Give next new arrays for what the tail adds to, holding the entries of gfa
+ * with room for those of the tail. The others are shared with gfa.
+ */
+static status_t grow_graph(gfa_props *gfa, gfa_props *next,
+			   const struct tail *t)
+{
+	// the bounds of next already take in the ids of the tail
+	next->vtx_arr_size = gfa_vtx_arr_size(next);
+	if (next->vtx_arr_size < gfa->vtx_arr_size)
+		next->vtx_arr_size = gfa->vtx_arr_size;
+	u32 added = next->vtx_arr_size - gfa->vtx_arr_size;
+	if (t->counts[TAIL_S] > 0 || added > 0) {
+		next->v = copy_grown(gfa->v, sizeof(vtx *), gfa->vtx_arr_size,
+				     next->vtx_arr_size);
+		if (!next->v)
+			return ERROR_CODE_OUT_OF_MEMORY;
+		memset(next->v + gfa->vtx_arr_size, 0, sizeof(vtx *) * added);
+	}
+
+	if (t->counts[TAIL_L] > 0) {
+		next->e = copy_grown(gfa->e, sizeof(edge), gfa->l_line_count,
+				     gfa->l_line_count + t->counts[TAIL_L]);
+		if (!next->e)
+			return ERROR_CODE_OUT_OF_MEMORY;
+	}
+
+	// one ref per line, t_handle_p grows it for the runs of a partial load
+	idx_t ref_lines = t->counts[TAIL_P] + t->counts[TAIL_W];
+	if (gfa->inc_refs && ref_lines > 0) {
+		next->refs = copy_grown(gfa->refs, sizeof(struct ref *),
+					gfa->ref_count,
+					gfa->ref_count + ref_lines);
+		if (!next->refs)
+			return ERROR_CODE_OUT_OF_MEMORY;
+	}
+
+	line **tables[] = {&gfa->s_lines, &gfa->l_lines, &gfa->p_lines,
+			   &gfa->w_lines};
+	line **next_tables[] = {&next->s_lines, &next->l_lines, &next->p_lines,
+				&next->w_lines};
+	idx_t *counts[] = {&next->s_line_count, &next->l_line_count,
+			   &next->p_line_count, &next->w_line_count};
+	for (int k = 0; k < 4; k++) {
+		status_t res = append_lines(tables[k], *counts[k], t->lines[k],
+					    t->counts[k]);
+		*next_tables[k] = *tables[k];
+		if (res != SUCCESS)
+			return res;
+		*counts[k] += t->counts[k];
+	}
+
+	return SUCCESS;
+}
+
+// the number of refs parsed, which the ref filter may make fewer than lines
+static idx_t parse_tail(gfa_props *gfa, const struct tail *t)
+{
+	struct s_thread_meta s_meta = {
+		.arena = gfa->arenas[GFA_ARENA_S],
+		.vertices = gfa->v,
+		.v_lo = gfa->v_lo,
+		.s_lines = t->lines[TAIL_S],
+		.s_line_count = t->counts[TAIL_S],
+		.inc_vtx_labels = gfa->inc_vtx_labels,
+		.seg_lens = NULL,
+	};
+	t_handle_s(&s_meta);
+
+	struct l_thread_meta l_meta = {
+		.edges = gfa->e + gfa->l_line_count - t->counts[TAIL_L],
+		.l_lines = t->lines[TAIL_L],
+		.l_line_count = t->counts[TAIL_L],
+		.stats = NULL,
+	};
+	t_handle_l(&l_meta);
+
+	if (!gfa->inc_refs)
+		return 0;
+
+	// the refs of the tail go after the existing ones, P lines first
+	idx_t ref_count = 0;
+	struct ref_thread_data ref_meta = {
+		.arena = gfa->arenas[GFA_ARENA_REFS],
+		.names = gfa->names,
+		.refs = &gfa->refs,
+		.first_ref = gfa->ref_count,
+		.lookup = NULL,
+		.p_lines = t->lines[TAIL_P],
+		.w_lines = t->lines[TAIL_W],
+		.p_line_count = t->counts[TAIL_P],
+		.w_line_count = t->counts[TAIL_W],
+		.filter = gfa->ref_filter,
+		.v_lo = gfa->v_lo,
+		.v_hi = gfa->v_hi,
+		.ref_count = &ref_count,
+	};
+	t_handle_p(&ref_meta);
+
+	return ref_count;
+}
+
+/**
+ * Bring the indexes of next up to date once the tail is in. Those built over
+ * arrays of gfa that next replaced are built anew for next.
+ */
+static status_t reindex(gfa_props *next, const gfa_props *gfa,
+			idx_t first_new_ref)
+{
+	bool new_refs = next->ref_count > first_new_ref;
+	bool grown = next->vtx_arr_size > gfa->vtx_arr_size;
+
+	if (next->inc_refs && next->inc_vtx_labels) {
+		status_t res = set_ref_loci(next, first_new_ref);
+		if (res != SUCCESS)
+			return res;
+	}
+
+	if (next->inc_refs && new_refs) {
+		// the old lookup stays in the arena until gfa_free
+		struct ref_lookup *lookup = build_ref_lookup(
+			next->refs, next->ref_count, next->names->count,
+			next->arenas[GFA_ARENA_REFS]);
+		if (!lookup)
+			return ERROR_CODE_OUT_OF_MEMORY;
+		next->ref_lookup = lookup;
+	}
+
+	// the adjacency is left to its first use if it was never built
+	if (gfa->adj_offsets && (next->e != gfa->e || grown)) {
+		next->adj_offsets = NULL;
+		next->adj_edges = NULL;
+		status_t res = gfa_build_adj(next);
+		if (res != SUCCESS)
+			return res;
+	}
+
+	if (gfa->occ_offsets && (new_refs || grown)) {
+		next->occ_offsets = NULL;
+		next->occs = NULL;
+		status_t res = gfa_build_occ_index(next);
+		if (res != SUCCESS)
+			return res;
+	}
+
+	if (gfa->stats) {
+		next->stats = NULL;
+		return collect_gfa_stats(next);
+	}
+
+	return SUCCESS;
+}
+
+// free the arrays of next that it does not share with gfa
+static void drop_next(const gfa_props *gfa, gfa_props *next)
+{
+	const void *olds[] = {gfa->v,	      gfa->e,	 gfa->refs,
+			      gfa->occ_offsets, gfa->occs, gfa->adj_offsets,
+			      gfa->adj_edges,   gfa->stats};
+	void *news[] = {next->v,	   next->e,    next->refs,
+			next->occ_offsets, next->occs, next->adj_offsets,
+			next->adj_edges,   next->stats};
+	for (size_t k = 0; k < sizeof(news) / sizeof(news[0]); k++)
+		if (news[k] != olds[k])
+			free(news[k]);
+}
+
+/**
+ * Swap the arrays and then the counts of next into gfa, so that a reader
+ * that sees a count sees an array it bounds. The arrays swapped out may
+ * still be held by readers and are kept until gfa_free.
+ */
+static status_t publish(gfa_props *gfa, const gfa_props *next)
+{
+	// in the order they are swapped, each index after what it points into
+	void **slots[] = {(void **)&gfa->v,	    (void **)&gfa->e,
+			  (void **)&gfa->refs,	    (void **)&gfa->occs,
+			  (void **)&gfa->occ_offsets, (void **)&gfa->adj_edges,
+			  (void **)&gfa->adj_offsets, (void **)&gfa->stats};
+	void *news[] = {next->v,	  next->e,	     next->refs,
+			next->occs,	  next->occ_offsets, next->adj_edges,
+			next->adj_offsets, next->stats};
+	const size_t n = sizeof(news) / sizeof(news[0]);
+
+	idx_t swapped = 0;
+	for (size_t k = 0; k < n; k++)
+		swapped += *slots[k] != news[k];
+	void **retired = realloc(gfa->retired, sizeof(void *) *
+						       (gfa->retired_count +
+							swapped + 1));
+	if (!retired)
+		return ERROR_CODE_OUT_OF_MEMORY;
+	gfa->retired = retired;
+
+	for (size_t k = 0; k < n; k++) {
+		if (*slots[k] == news[k])
+			continue;
+		if (*slots[k])
+			gfa->retired[gfa->retired_count++] = *slots[k];
+		__atomic_store_n(slots[k], news[k], __ATOMIC_RELEASE);
+	}
+
+	gfa->min_v_id = next->min_v_id;
+	gfa->max_v_id = next->max_v_id;
+	__atomic_store_n(&gfa->vtx_arr_size, next->vtx_arr_size,
+			 __ATOMIC_RELEASE);
+	__atomic_store_n(&gfa->s_line_count, next->s_line_count,
+			 __ATOMIC_RELEASE);
+	__atomic_store_n(&gfa->l_line_count, next->l_line_count,
+			 __ATOMIC_RELEASE);
+	__atomic_store_n(&gfa->p_line_count, next->p_line_count,
+			 __ATOMIC_RELEASE);
+	__atomic_store_n(&gfa->w_line_count, next->w_line_count,
+			 __ATOMIC_RELEASE);
+	__atomic_store_n(&gfa->ref_count, next->ref_count, __ATOMIC_RELEASE);
+	// after the refs it may point at
+	__atomic_store_n(&gfa->ref_lookup, next->ref_lookup, __ATOMIC_RELEASE);
+
+	return SUCCESS;
+}
+
+status_t gfa_refresh(gfa_props *gfa)
+{
+	if (!gfa || gfa->status != SUCCESS || !gfa->start || gfa->snapshot)
+		return ERROR_CODE_INVALID_ARGUMENT;
+
+	pthread_mutex_lock(&gfa->lock);
+
+	char *from = NULL;
+	status_t res = remap(gfa, &from);
+	if (res != SUCCESS || from == gfa->end) {
+		pthread_mutex_unlock(&gfa->lock);
+		return res;
+	}
+
+	// the tail goes into a copy of the graph that no reader sees
+	gfa_props next = *gfa;
+	struct tail t = {{NULL}, {0}};
+	res = index_tail(&next, from, &t);
+	if (res == SUCCESS && gfa_is_partial(gfa)) {
+		t.counts[TAIL_S] = select_v_range_lines(gfa, t.lines[TAIL_S],
+							t.counts[TAIL_S]);
+		t.counts[TAIL_L] = select_v_range_lines(gfa, t.lines[TAIL_L],
+							t.counts[TAIL_L]);
+	}
+	if (res == SUCCESS)
+		res = grow_graph(gfa, &next, &t);
+	if (res == SUCCESS)
+		next.ref_count += parse_tail(&next, &t);
+	else
+		log_error("Failed to index the lines appended to %s", gfa->fp);
+	tail_free(&t);
+
+	if (res == SUCCESS)
+		res = reindex(&next, gfa, gfa->ref_count);
+	if (res == SUCCESS)
+		res = publish(gfa, &next);
+	if (res != SUCCESS)
+		drop_next(gfa, &next);
+
+	// the line tables of a partial load lack the lines it left out
+	if (res == SUCCESS && gfa->use_line_index && !gfa_is_partial(gfa))
+		save_line_index(gfa); // only a cache, failing is fine
+
+	pthread_mutex_unlock(&gfa->lock);
+
+	return res;
+}
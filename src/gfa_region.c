@@ -0,0 +1,367 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <log.h>
+
+#include "../include/liteseq/gfa.h"
+#include "../include/liteseq/refs.h"
+#include "../include/liteseq/types.h"
+#include "../src/internal/lq_utils.h"
+
+#include "./gfa_adj.h"
+
+#define ID_SET_INIT_CAP 64
+#define REGION_ARR_INIT_CAP 16
+
+/*
+ * A set of vertex ids sized to the region rather than to the graph so that
+ * extracting a region never touches memory in proportion to the graph
+ */
+struct id_set {
+	id_t *slots; // open addressing, NULL_ID is empty
+	idx_t cap;   // always a power of two
+	idx_t count;
+};
+
+static inline idx_t id_slot(id_t v_id, idx_t cap)
+{
+	// Fibonacci hashing, the ids of a region tend to be consecutive
+	return (idx_t)(((u64)v_id * 0x9E3779B97F4A7C15ULL) >> 32) & (cap - 1);
+}
+
+static status_t id_set_init(struct id_set *s)
+{
+	s->cap = ID_SET_INIT_CAP;
+	s->count = 0;
+	s->slots = malloc(sizeof(id_t) * s->cap);
+	if (!s->slots)
+		return ERROR_CODE_OUT_OF_MEMORY;
+	memset(s->slots, 0xff, sizeof(id_t) * s->cap);
+
+	return SUCCESS;
+}
+
+static bool id_set_has(const struct id_set *s, id_t v_id)
+{
+	for (idx_t i = id_slot(v_id, s->cap);; i = (i + 1) & (s->cap - 1)) {
+		if (s->slots[i] == v_id)
+			return true;
+		if (s->slots[i] == NULL_ID)
+			return false;
+	}
+}
+
+static void id_set_put(id_t *slots, idx_t cap, id_t v_id)
+{
+	idx_t i = id_slot(v_id, cap);
+	while (slots[i] != NULL_ID)
+		i = (i + 1) & (cap - 1);
+	slots[i] = v_id;
+}
+
+/**
+ * @param [out] added whether v_id was not in the set before
+ */
+static status_t id_set_add(struct id_set *s, id_t v_id, bool *added)
+{
+	*added = false;
+	if (id_set_has(s, v_id))
+		return SUCCESS;
+
+	// keep the load factor at or below a half
+	if ((s->count + 1) * 2 > s->cap) {
+		idx_t cap = s->cap * 2;
+		id_t *slots = malloc(sizeof(id_t) * cap);
+		if (!slots)
+			return ERROR_CODE_OUT_OF_MEMORY;
+		memset(slots, 0xff, sizeof(id_t) * cap);
+		for (idx_t i = 0; i < s->cap; i++)
+			if (s->slots[i] != NULL_ID)
+				id_set_put(slots, cap, s->slots[i]);
+		free(s->slots);
+		s->slots = slots;
+		s->cap = cap;
+	}
+
+	id_set_put(s->slots, s->cap, v_id);
+	s->count++;
+	*added = true;
+
+	return SUCCESS;
+}
+
+/**
+ * Make room for one more element of size elem_size in the array *arr that
+ * holds count elements out of *cap
+ */
+static status_t reserve_one(void **arr, idx_t *cap, idx_t count,
+			    size_t elem_size)
+{
+	if (count < *cap)
+		return SUCCESS;
+
+	idx_t new_cap = *cap ? *cap * 2 : REGION_ARR_INIT_CAP;
+	void *a = realloc(*arr, elem_size * new_cap);
+	if (!a)
+		return ERROR_CODE_OUT_OF_MEMORY;
+	*arr = a;
+	*cap = new_cap;
+
+	return SUCCESS;
+}
+
+static int cmp_id(const void *a, const void *b)
+{
+	id_t x = *(const id_t *)a;
+	id_t y = *(const id_t *)b;
+	return (x > y) - (x < y);
+}
+
+static int cmp_occ(const void *a, const void *b)
+{
+	const struct vtx_occ *x = a;
+	const struct vtx_occ *y = b;
+	if (x->ref_idx != y->ref_idx)
+		return (x->ref_idx > y->ref_idx) - (x->ref_idx < y->ref_idx);
+	return (x->step > y->step) - (x->step < y->step);
+}
+
+/**
+ * Add the step to the fragments, extending the last fragment if the step
+ * follows it
+ */
+static status_t add_step(struct gfa_region *rg, idx_t *cap, idx_t ref_idx,
+			 idx_t step)
+{
+	if (rg->walk_count > 0) {
+		struct region_walk *w = &rg->walks[rg->walk_count - 1];
+		if (w->ref_idx == ref_idx &&
+		    w->step_start + w->step_count == step) {
+			w->step_count++;
+			return SUCCESS;
+		}
+	}
+
+	status_t res = reserve_one((void **)&rg->walks, cap, rg->walk_count,
+				   sizeof(struct region_walk));
+	if (res != SUCCESS)
+		return res;
+
+	rg->walks[rg->walk_count++] = (struct region_walk){
+		.ref_idx = ref_idx,
+		.step_start = step,
+		.step_count = 1,
+	};
+
+	return SUCCESS;
+}
+
+static status_t collect_walks(const gfa_props *gfa, const struct id_set *set,
+			      struct gfa_region *rg)
+{
+	idx_t cap = 0;
+
+	if (!gfa->occ_offsets) {
+		// no occurrence index, scan the walks of every ref
+		for (idx_t i = 0; i < gfa->ref_count; i++) {
+			const struct ref *r = gfa->refs[i];
+			const id_t *v_ids = get_walk_v_ids(r);
+			for (idx_t j = 0; j < get_step_count(r); j++) {
+				if (!id_set_has(set, v_ids[j]))
+					continue;
+				status_t res = add_step(rg, &cap, i, j);
+				if (res != SUCCESS)
+					return res;
+			}
+		}
+		return SUCCESS;
+	}
+
+	size_t occ_count = 0;
+	for (idx_t i = 0; i < rg->v_count; i++) {
+		idx_t n;
+		get_vtx_occs(gfa, rg->v_ids[i], &n);
+		occ_count += n;
+	}
+
+	struct vtx_occ *occs = malloc(sizeof(struct vtx_occ) * occ_count + 1);
+	if (!occs)
+		return ERROR_CODE_OUT_OF_MEMORY;
+
+	size_t k = 0;
+	for (idx_t i = 0; i < rg->v_count; i++) {
+		idx_t n;
+		const struct vtx_occ *o = get_vtx_occs(gfa, rg->v_ids[i], &n);
+		memcpy(occs + k, o, sizeof(struct vtx_occ) * n);
+		k += n;
+	}
+	qsort(occs, occ_count, sizeof(struct vtx_occ), cmp_occ);
+
+	status_t res = SUCCESS;
+	for (size_t i = 0; i < occ_count && res == SUCCESS; i++)
+		res = add_step(rg, &cap, occs[i].ref_idx, occs[i].step);
+
+	free(occs);
+
+	return res;
+}
+
+/**
+ * Grow the vertices in rg->v_ids, which are also in set, by hops along the
+ * edges
+ */
+static status_t expand(const gfa_props *gfa, struct id_set *set,
+		       struct gfa_region *rg, idx_t *v_cap, idx_t hops)
+{
+	idx_t level_start = 0;
+	for (idx_t h = 0; h < hops; h++) {
+		idx_t level_end = rg->v_count;
+		if (level_start == level_end)
+			break; // nothing new to grow from
+
+		for (idx_t i = level_start; i < level_end; i++) {
+			id_t v_id = rg->v_ids[i];
+			idx_t n;
+			const idx_t *es = get_vtx_edges(gfa, v_id, &n);
+			for (idx_t k = 0; k < n; k++) {
+				const edge *e = &gfa->e[es[k]];
+				id_t other =
+					e->v1_id == v_id ? e->v2_id : e->v1_id;
+
+				bool added;
+				status_t res = id_set_add(set, other, &added);
+				if (res == SUCCESS && added)
+					res = reserve_one((void **)&rg->v_ids,
+							  v_cap, rg->v_count,
+							  sizeof(id_t));
+				if (res != SUCCESS)
+					return res;
+				if (added)
+					rg->v_ids[rg->v_count++] = other;
+			}
+		}
+		level_start = level_end;
+	}
+
+	return SUCCESS;
+}
+
+static status_t collect_edges(const gfa_props *gfa, const struct id_set *set,
+			      struct gfa_region *rg)
+{
+	idx_t *idxs = NULL;
+	idx_t cap = 0;
+	idx_t count = 0;
+
+	// take each edge from its first vertex so it is only seen once
+	for (idx_t i = 0; i < rg->v_count; i++) {
+		id_t v_id = rg->v_ids[i];
+		idx_t n;
+		const idx_t *es = get_vtx_edges(gfa, v_id, &n);
+		for (idx_t k = 0; k < n; k++) {
+			const edge *e = &gfa->e[es[k]];
+			if (e->v1_id != v_id || !id_set_has(set, e->v2_id))
+				continue;
+			if (reserve_one((void **)&idxs, &cap, count,
+					sizeof(idx_t)) != SUCCESS) {
+				free(idxs);
+				return ERROR_CODE_OUT_OF_MEMORY;
+			}
+			idxs[count++] = es[k];
+		}
+	}
+
+	// in the order of the L lines
+	qsort(idxs, count, sizeof(idx_t), cmp_id);
+
+	rg->e = malloc(sizeof(edge) * count + 1);
+	if (!rg->e) {
+		free(idxs);
+		return ERROR_CODE_OUT_OF_MEMORY;
+	}
+	for (idx_t i = 0; i < count; i++)
+		rg->e[i] = gfa->e[idxs[i]];
+	rg->e_count = count;
+
+	free(idxs);
+
+	return SUCCESS;
+}
+
+struct gfa_region *gfa_extract_region(gfa_props *gfa, const struct ref *r,
+				      idx_t start, idx_t end,
+				      idx_t context_steps)
+{
+	if (!gfa || !r)
+		return NULL;
+
+	idx_t hap_len = get_hap_len(r);
+	if (end > hap_len)
+		end = hap_len;
+
+	struct ref_locus first, last;
+	if (start > end || ref_locate(r, start, &first) != SUCCESS ||
+	    ref_locate(r, end, &last) != SUCCESS) {
+		log_error("Invalid region %u-%u of ref %s", start, end,
+			  get_tag(r));
+		return NULL;
+	}
+
+	if (gfa_ensure_adj(gfa) != SUCCESS)
+		return NULL;
+
+	struct gfa_region *rg = calloc(1, sizeof(struct gfa_region));
+	struct id_set set = {.slots = NULL};
+	if (!rg || id_set_init(&set) != SUCCESS)
+		goto fail;
+
+	// the vertices under the interval of the ref itself
+	idx_t v_cap = 0;
+	const id_t *v_ids = get_walk_v_ids(r);
+	for (idx_t j = first.step; j <= last.step; j++) {
+		bool added;
+		if (id_set_add(&set, v_ids[j], &added) != SUCCESS)
+			goto fail;
+		if (!added)
+			continue;
+		if (reserve_one((void **)&rg->v_ids, &v_cap, rg->v_count,
+				sizeof(id_t)) != SUCCESS)
+			goto fail;
+		rg->v_ids[rg->v_count++] = v_ids[j];
+	}
+
+	if (expand(gfa, &set, rg, &v_cap, context_steps) != SUCCESS)
+		goto fail;
+
+	qsort(rg->v_ids, rg->v_count, sizeof(id_t), cmp_id);
+
+	if (collect_edges(gfa, &set, rg) != SUCCESS)
+		goto fail;
+
+	if (gfa->inc_refs && collect_walks(gfa, &set, rg) != SUCCESS)
+		goto fail;
+
+	free(set.slots);
+
+	return rg;
+
+fail:
+	log_error("Could not extract region %u-%u of ref %s", start, end,
+		  get_tag(r));
+	free(set.slots);
+	gfa_region_free(&rg);
+
+	return NULL;
+}
+
+void gfa_region_free(struct gfa_region **region)
+{
+	if (region == NULL || *region == NULL)
+		return;
+
+	free((*region)->v_ids);
+	free((*region)->e);
+	free((*region)->walks);
+	free(*region);
+	*region = NULL;
+}
@@ -2,11 +2,15 @@
 
 #include <log.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "./gfa_load.h"
+#include "./gfa_metrics.h"
 #include "./gfa_s.h"
 
 #include "../include/liteseq/gfa.h"
 #include "../include/liteseq/types.h"
+#include "../src/internal/lq_arena.h"
 #include "../src/internal/lq_utils.h"
 
 #define EXPECTED_S_LINE_TOKENS 3 // the number of tokens expected in a S line
@@ -16,11 +20,14 @@
 
 vtx *get_vtx(gfa_props *gfa, id_t v_id)
 {
-	return gfa->v[v_id];
+	u32 slot = gfa_vtx_slot(gfa, v_id);
+	return slot < gfa->vtx_arr_size ? gfa->v[slot] : NULL;
 }
 
+// vertices[0] is the vertex v_lo
 status_t handle_s(const char *s_line, u32 line_len, char **tokens,
-		  bool inc_vtx_labels, vtx **vertices)
+		  bool inc_vtx_labels, vtx **vertices, id_t v_lo,
+		  struct lq_arena *arena, struct lq_arena *scratch)
 {
 	struct split_str_params p = {
 		.str = s_line,
@@ -28,11 +35,14 @@ status_t handle_s(const char *s_line, u32 line_len, char **tokens,
 		.delimiter = TAB_CHAR,
 		.fallbacks = "",
 		.fallback_chars_count = 0,
-		.max_splits = 3,
+		// don't copy the label if we are going to throw it away
+		.max_splits = inc_vtx_labels ? EXPECTED_S_LINE_TOKENS
+					     : S_LINE_SEQ_IDX,
 
 		.tokens_found = 0,
 		.tokens = tokens,
 		.end = NULL,
+		.arena = scratch,
 	};
 
 	status_t res = split_str(&p);
@@ -41,27 +51,44 @@ status_t handle_s(const char *s_line, u32 line_len, char **tokens,
 		return res;
 	}
 
-	vtx *v = malloc(sizeof(vtx));
+	vtx *v = lq_arena_alloc(arena, sizeof(vtx));
 	if (v == NULL) {
 		log_fatal("Could not allocate memory for vertex");
 		return FAILURE;
 	}
 	v->id = strtoul(tokens[S_LINE_V_ID_IDX], NULL, 10);
-	v->seq = inc_vtx_labels ? tokens[S_LINE_SEQ_IDX] : NULL;
-	/* vtx v = {.id = strtoul(tokens[S_LINE_V_ID_IDX], NULL, 10), */
-	/*	 .seq = inc_vtx_labels ? tokens[S_LINE_SEQ_IDX] : NULL}; */
-	vertices[v->id] = v;
-
-	free(tokens[S_LINE_TYPE_IDX]); // free the line type token
-	free(tokens[S_LINE_V_ID_IDX]); // free the vertex ID token
+	v->seq = NULL;
+	if (inc_vtx_labels) {
+		const char *label = tokens[S_LINE_SEQ_IDX];
+		v->seq = lq_arena_strndup(arena, label, strlen(label));
+		if (v->seq == NULL) {
+			log_fatal("Could not allocate memory for vertex label");
+			return FAILURE;
+		}
+	}
+	vertices[v->id - v_lo] = v;
 
-	// free the sequence token only if vertex labels are not included
-	if (!inc_vtx_labels)
-		free(tokens[S_LINE_SEQ_IDX]);
+	// the tokens live in the scratch arena
+	lq_arena_reset(scratch);
 
 	return SUCCESS;
 }
 
+u32 s_line_label_len(const char *s_line, u32 line_len)
+{
+	const char *end = s_line + line_len;
+	const char *label = s_line;
+	for (int field = 0; field < S_LINE_SEQ_IDX; field++) {
+		label = memchr(label, TAB_CHAR, end - label);
+		if (label == NULL)
+			return 0;
+		label++;
+	}
+
+	const char *label_end = memchr(label, TAB_CHAR, end - label);
+	return (u32)((label_end ? label_end : end) - label);
+}
+
 /**
  * @brief a wrapper function for handle_s_lines
  */
@@ -72,12 +99,41 @@ void *t_handle_s(void *s_meta)
 	line *sl = meta->s_lines;
 	idx_t line_count = meta->s_line_count;
 	bool inc_vtx_labels = meta->inc_vtx_labels;
+	struct lq_arena *arena = meta->arena;
+
+	struct gfa_metrics_clock clock;
+	gfa_metrics_start(&clock, meta->metrics, arena, 0);
 
 	// temporary storage for the tokens extracted from a given line
 	char *tokens[EXPECTED_S_LINE_TOKENS] = {NULL};
+	struct lq_arena *scratch = lq_arena_new(LQ_ARENA_BLOCK_SIZE);
+	if (scratch == NULL) {
+		log_fatal("Could not allocate scratch arena for S lines");
+		return NULL;
+	}
 
-	for (idx_t i = 0; i < line_count; i++)
-		handle_s(sl[i].start, sl[i].len, tokens, inc_vtx_labels, vtxs);
+	struct gfa_load_state *load = meta->load;
+	for (idx_t i = 0; i < line_count; i++) {
+		if (load && i % GFA_LOAD_CHECK_LINES == 0) {
+			gfa_load_publish(&load->progress.s_lines_parsed, i);
+			if (gfa_load_cancelled(load))
+				break;
+		}
+
+		handle_s(sl[i].start, sl[i].len, tokens, inc_vtx_labels, vtxs,
+			 meta->v_lo, arena, scratch);
+		if (meta->seg_lens)
+			meta->seg_lens[i] =
+				s_line_label_len(sl[i].start, sl[i].len);
+	}
+
+	lq_arena_destroy(&scratch);
+	gfa_metrics_lines(&clock, sl, line_count);
+	gfa_metrics_stop(&clock);
+	if (load && !gfa_load_cancelled(load)) {
+		gfa_load_publish(&load->progress.s_lines_parsed, line_count);
+		gfa_phase_done(load, GFA_PHASE_VERTICES);
+	}
 
 	return NULL;
 }
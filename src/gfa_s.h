@@ -2,13 +2,37 @@
 #define LQ_GFA_S_H
 
 #include "../include/liteseq/gfa.h"
+#include "./internal/lq_arena.h"
+
+#ifdef __cplusplus
+extern "C" {
+namespace liteseq
+{
+#endif
 
 struct s_thread_meta {
+	struct lq_arena *arena; // backs the vertices and their labels
 	vtx **vertices;
+	id_t v_lo; // the id of vertices[0], see gfa_vtx_slot
 	line *s_lines;
 	idx_t s_line_count;
 	bool inc_vtx_labels;
+	u32 *seg_lens; // if not NULL gets the label length of each S line
+	struct gfa_load_state *load; // NULL unless run by gfa_new_async
+	struct gfa_phase_metrics *metrics; // NULL unless recorded
 };
 
 void *t_handle_s(void *s_meta);
+
+/**
+ * The length of the label of an S line without splitting it, the label is
+ * the third field
+ */
+u32 s_line_label_len(const char *s_line, u32 line_len);
+
+#ifdef __cplusplus
+} // namespace liteseq
+} // extern "C"
+#endif
+
 #endif // LQ_GFA_S_H
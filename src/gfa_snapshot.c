@@ -0,0 +1,755 @@
+#if defined(__linux__)
+#define _GNU_SOURCE // ftruncate, memfd_create
+#endif
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <log.h>
+
+#include "../include/liteseq/gfa.h"
+#include "../include/liteseq/refs.h"
+#include "../include/liteseq/types.h"
+#include "../src/internal/lq_arena.h"
+#include "../src/internal/lq_intern.h"
+#include "../src/internal/lq_utils.h"
+
+#include "./gfa_impl.h"
+#include "./refs/ref_lookup.h"
+
+/*
+ * Snapshot layout
+ * ---------------
+ * A snap_header followed by sections at the offsets it records. The
+ * structs of the graph are stored as they are in memory except that every
+ * pointer holds the offset of its target from the start of the file, 0
+ * standing for NULL. Loading maps the file privately and swizzles the
+ * offsets back into pointers, arrays without pointers are used in place.
+ *
+ * Snapshots are only read on machines with the byte order and pointer size
+ * they were written with.
+ *
+ * A graph published to shared memory has the same layout plus a table of
+ * vertex pointers, but its offsets are swizzled once by the publisher for
+ * the address in map_addr. Other processes map it read-only at that address
+ * and use it as it is; one that finds the address taken maps it privately
+ * and moves the pointers by the difference, like a snapshot file.
+ */
+
+#define SNAP_MAGIC "LQSNAP\0\0"
+#define SNAP_FORMAT_VERSION 4
+#define SNAP_BYTE_ORDER 0x01020304
+#define SNAP_ALIGN 16
+
+enum snap_flags {
+	SNAP_HAS_LABELS = 1 << 0,
+	SNAP_HAS_REFS = 1 << 1,
+	SNAP_HAS_OCC_INDEX = 1 << 2,
+	SNAP_HAS_STATS = 1 << 3,
+	SNAP_SHARED = 1 << 4, // published to shared memory, has vtx_ptrs
+};
+
+struct snap_header {
+	char magic[8];
+	u32 format_version;
+	u32 byte_order;
+	u32 ptr_size;
+	u32 flags;
+	u64 file_size;
+	u64 checksum; // of everything after the header, 0 when shared
+	u64 map_addr; // where the pointers of a shared graph point into
+
+	u32 gfa_version;
+	u32 min_v_id;
+	u32 max_v_id;
+	u32 vtx_arr_size;
+	u32 v_lo; // the vertex ids of a partial load
+	u32 v_hi;
+	idx_t s_line_count;
+	idx_t l_line_count;
+	idx_t p_line_count;
+	idx_t w_line_count;
+	idx_t ref_count;
+	idx_t vtx_count; // the vertices that have an S line
+	idx_t name_count;
+
+	// section offsets
+	u64 vtxs_off;	     // vtx_count vtx
+	u64 vtx_ptrs_off;    // vtx_arr_size offsets of vtx, when shared
+	u64 edges_off;	     // l_line_count edge
+	u64 refs_off;	     // ref_count offsets of struct ref
+	u64 names_off;	     // name_count offsets of strings
+	u64 occ_offsets_off; // vtx_arr_size + 1 u64
+	u64 occs_off;
+	u64 stats_off; // a struct gfa_stats
+};
+
+#define SNAP_OFF(off) ((void *)(uintptr_t)(off))
+// move p by delta, the base of the mapping for an offset
+#define SNAP_PTR(delta, p) ((p) ? (void *)((uintptr_t)(p) + (delta)) : NULL)
+// the space snap_put gives an item of n bytes in an array of them
+#define SNAP_STRIDE(n) (((n) + SNAP_ALIGN - 1) & ~(size_t)(SNAP_ALIGN - 1))
+
+/*
+ * Saving
+ * ------
+ * The layout is produced by running the writer twice, first with no buffer
+ * to size the file then into the mapped file.
+ */
+
+struct snap_writer {
+	byte *base; // NULL while sizing
+	u64 size;
+};
+
+// append n bytes of src, or reserve them when src is NULL
+static u64 snap_put(struct snap_writer *w, const void *src, size_t n)
+{
+	u64 off = (w->size + SNAP_ALIGN - 1) & ~(u64)(SNAP_ALIGN - 1);
+	if (w->base && src && n > 0)
+		memcpy(w->base + off, src, n);
+	w->size = off + n;
+
+	return off;
+}
+
+static u64 snap_put_str(struct snap_writer *w, const char *s)
+{
+	return s ? snap_put(w, s, strlen(s) + 1) : 0;
+}
+
+static u64 put_pansn(struct snap_writer *w, const struct pansn *pn,
+		     const u64 *names)
+{
+	struct pansn c = *pn;
+	u64 sn = pn->sample_id != NULL_ID ? names[pn->sample_id]
+					  : snap_put_str(w, pn->sample_name);
+	u64 cn = pn->contig_id != NULL_ID ? names[pn->contig_id]
+					  : snap_put_str(w, pn->contig_name);
+	c.sample_name = SNAP_OFF(sn);
+	c.contig_name = SNAP_OFF(cn);
+
+	return snap_put(w, &c, sizeof(c));
+}
+
+// *id_off is the offset of the id of r, 0 to write it out and set it
+static u64 put_ref(struct snap_writer *w, const struct ref *r,
+		   const u64 *names, u64 *id_off)
+{
+	const struct ref_walk *rw = r->walk;
+	idx_t n = rw->step_count;
+	struct ref_walk cw = *rw;
+	size_t strands_size = sizeof(enum strand) * n;
+	cw.strands = SNAP_OFF(snap_put(w, rw->strands, strands_size));
+	cw.v_ids = SNAP_OFF(snap_put(w, rw->v_ids, sizeof(id_t) * n));
+	cw.loci = SNAP_OFF(snap_put(w, rw->loci, sizeof(idx_t) * n));
+	if (rw->eytz) {
+		size_t sz = sizeof(idx_t) * (rw->eytz_count + 1);
+		cw.eytz = SNAP_OFF(snap_put(w, rw->eytz, sz));
+		cw.eytz_rank = SNAP_OFF(snap_put(w, rw->eytz_rank, sz));
+	}
+
+	const struct ref_id *id = r->id;
+	if (!*id_off) {
+		struct ref_id cid = *id;
+		u64 tag = snap_put_str(w, id->tag);
+		cid.tag = SNAP_OFF(tag);
+		if (id->type == REF_ID_PANSN)
+			cid.value.id_value = SNAP_OFF(
+				put_pansn(w, id->value.id_value, names));
+		else // a raw id is its own tag
+			cid.value.raw = SNAP_OFF(tag);
+		*id_off = snap_put(w, &cid, sizeof(cid));
+	}
+
+	struct ref cr = *r;
+	cr.walk = SNAP_OFF(snap_put(w, &cw, sizeof(cw)));
+	cr.id = SNAP_OFF(*id_off);
+
+	return snap_put(w, &cr, sizeof(cr));
+}
+
+static status_t emit_snapshot(const gfa_props *gfa, struct snap_writer *w,
+			      struct snap_header *h)
+{
+	snap_put(w, NULL, sizeof(struct snap_header));
+
+	// vertices and their labels
+	idx_t vtx_count = 0;
+	for (id_t v = 0; v < gfa->vtx_arr_size; v++)
+		vtx_count += gfa->v[v] != NULL;
+
+	u64 *label_offs = malloc(sizeof(u64) * (vtx_count ? vtx_count : 1));
+	if (!label_offs)
+		return ERROR_CODE_OUT_OF_MEMORY;
+	idx_t k = 0;
+	for (id_t v = 0; v < gfa->vtx_arr_size; v++)
+		if (gfa->v[v])
+			label_offs[k++] = snap_put_str(w, gfa->v[v]->seq);
+
+	h->vtxs_off = snap_put(w, NULL, 0);
+	k = 0;
+	for (id_t v = 0; v < gfa->vtx_arr_size; v++) {
+		if (!gfa->v[v])
+			continue;
+		vtx c = {.seq = SNAP_OFF(label_offs[k++]), .id = gfa->v[v]->id};
+		snap_put(w, &c, sizeof(c));
+	}
+	free(label_offs);
+	h->vtx_count = vtx_count;
+
+	if (h->flags & SNAP_SHARED) {
+		size_t n = (size_t)gfa->vtx_arr_size;
+		h->vtx_ptrs_off = snap_put(w, NULL, sizeof(u64) * n);
+		u64 *ptrs = w->base ? (u64 *)(w->base + h->vtx_ptrs_off) : NULL;
+		u64 stride = SNAP_STRIDE(sizeof(vtx));
+		k = 0;
+		for (id_t v = 0; ptrs && v < gfa->vtx_arr_size; v++)
+			ptrs[v] = gfa->v[v] ? h->vtxs_off + stride * k++ : 0;
+	}
+
+	h->edges_off = snap_put(w, gfa->e, sizeof(edge) * gfa->l_line_count);
+
+	// the names before the refs which point at them
+	idx_t name_count = gfa->names ? gfa->names->count : 0;
+	u64 *names = malloc(sizeof(u64) * (name_count ? name_count : 1));
+	u64 *refs = malloc(sizeof(u64) * (gfa->ref_count ? gfa->ref_count : 1));
+	if (!names || !refs) {
+		free(names);
+		free(refs);
+		return ERROR_CODE_OUT_OF_MEMORY;
+	}
+
+	for (idx_t i = 0; i < name_count; i++)
+		names[i] = snap_put_str(w, lq_intern_get(gfa->names, i));
+	h->names_off = snap_put(w, names, sizeof(u64) * name_count);
+	h->name_count = name_count;
+
+	// the runs a partial load splits a walk into share its id, and so
+	// they do in the snapshot
+	u64 id_off = 0;
+	for (idx_t i = 0; i < gfa->ref_count; i++) {
+		struct ref *r = gfa->refs[i];
+		if (!r || i == 0 || !gfa->refs[i - 1] ||
+		    r->id != gfa->refs[i - 1]->id)
+			id_off = 0;
+		refs[i] = r ? put_ref(w, r, names, &id_off) : 0;
+	}
+	h->refs_off = snap_put(w, refs, sizeof(u64) * gfa->ref_count);
+
+	free(names);
+	free(refs);
+
+	if (gfa->occ_offsets) {
+		size_t n = (size_t)gfa->vtx_arr_size + 1;
+		h->occ_offsets_off =
+			snap_put(w, gfa->occ_offsets, sizeof(u64) * n);
+		u64 occ_count = gfa->occ_offsets[gfa->vtx_arr_size];
+		h->occs_off = snap_put(w, gfa->occs,
+				       sizeof(struct vtx_occ) * occ_count);
+	}
+
+	if (gfa->stats)
+		h->stats_off =
+			snap_put(w, gfa->stats, sizeof(struct gfa_stats));
+
+	return SUCCESS;
+}
+
+static void fill_header(const gfa_props *gfa, struct snap_header *h)
+{
+	memcpy(h->magic, SNAP_MAGIC, sizeof(h->magic));
+	h->format_version = SNAP_FORMAT_VERSION;
+	h->byte_order = SNAP_BYTE_ORDER;
+	h->ptr_size = sizeof(void *);
+	h->flags = (gfa->inc_vtx_labels ? SNAP_HAS_LABELS : 0) |
+		   (gfa->inc_refs ? SNAP_HAS_REFS : 0) |
+		   (gfa->occ_offsets ? SNAP_HAS_OCC_INDEX : 0) |
+		   (gfa->stats ? SNAP_HAS_STATS : 0);
+
+	h->gfa_version = gfa->version;
+	h->min_v_id = gfa->min_v_id;
+	h->max_v_id = gfa->max_v_id;
+	h->vtx_arr_size = gfa->vtx_arr_size;
+	h->v_lo = gfa->v_lo;
+	h->v_hi = gfa->v_hi;
+	h->s_line_count = gfa->s_line_count;
+	h->l_line_count = gfa->l_line_count;
+	h->p_line_count = gfa->p_line_count;
+	h->w_line_count = gfa->w_line_count;
+	h->ref_count = gfa->inc_refs ? gfa->ref_count : 0;
+}
+
+status_t gfa_save_snapshot(const gfa_props *gfa, const char *fp)
+{
+	if (!gfa || !fp || gfa->status != SUCCESS || !gfa->v)
+		return ERROR_CODE_INVALID_ARGUMENT;
+
+	struct snap_header h;
+	memset(&h, 0, sizeof(h));
+	fill_header(gfa, &h);
+
+	struct snap_writer sizing = {.base = NULL, .size = 0};
+	status_t res = emit_snapshot(gfa, &sizing, &h);
+	if (res != SUCCESS)
+		return res;
+	h.file_size = sizing.size;
+
+	// written next to the destination and renamed over it so that readers
+	// never see half a snapshot
+	size_t tmp_len = strlen(fp) + sizeof(".tmp");
+	char *tmp = malloc(tmp_len);
+	if (!tmp)
+		return ERROR_CODE_OUT_OF_MEMORY;
+	snprintf(tmp, tmp_len, "%s.tmp", fp);
+
+	int fd = open(tmp, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd == -1) {
+		log_error("Failed to open %s for writing", tmp);
+		free(tmp);
+		return FAILURE;
+	}
+
+	byte *base = MAP_FAILED;
+	if (ftruncate(fd, (off_t)h.file_size) == 0)
+		base = mmap(NULL, h.file_size, PROT_READ | PROT_WRITE,
+			    MAP_SHARED, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED) {
+		log_error("Failed to map %s", tmp);
+		unlink(tmp);
+		free(tmp);
+		return FAILURE;
+	}
+
+	struct snap_writer writer = {.base = base, .size = 0};
+	res = emit_snapshot(gfa, &writer, &h);
+	if (res == SUCCESS) {
+		h.checksum = lq_checksum(base + sizeof(h),
+					 h.file_size - sizeof(h));
+		memcpy(base, &h, sizeof(h));
+		if (msync(base, h.file_size, MS_SYNC) != 0)
+			res = FAILURE;
+	}
+	munmap(base, h.file_size);
+
+	if (res == SUCCESS && rename(tmp, fp) != 0)
+		res = FAILURE;
+	if (res != SUCCESS) {
+		log_error("Failed to write snapshot %s", fp);
+		unlink(tmp);
+	}
+	free(tmp);
+
+	return res;
+}
+
+/*
+ * Loading
+ * -------
+ */
+
+static status_t check_header(const struct snap_header *h, size_t file_size,
+			     const byte *base)
+{
+	if (file_size < sizeof(struct snap_header) ||
+	    memcmp(h->magic, SNAP_MAGIC, sizeof(h->magic)) != 0)
+		return ERROR_CODE_INVALID_ARGUMENT;
+
+	if (h->format_version != SNAP_FORMAT_VERSION ||
+	    h->byte_order != SNAP_BYTE_ORDER || h->ptr_size != sizeof(void *))
+		return ERROR_CODE_NOT_IMPLEMENTED;
+
+	if (h->file_size != file_size ||
+	    h->checksum != lq_checksum(base + sizeof(struct snap_header),
+				       file_size - sizeof(struct snap_header)))
+		return ERROR_CODE_INVALID_ARGUMENT;
+
+	return SUCCESS;
+}
+
+// id is the id of r when it was already moved for the ref before, or NULL
+static void swizzle_ref(uintptr_t delta, struct ref *r, struct ref_id *id)
+{
+	r->walk = SNAP_PTR(delta, r->walk);
+
+	struct ref_walk *w = r->walk;
+	w->strands = SNAP_PTR(delta, w->strands);
+	w->v_ids = SNAP_PTR(delta, w->v_ids);
+	w->loci = SNAP_PTR(delta, w->loci);
+	w->eytz = SNAP_PTR(delta, w->eytz);
+	w->eytz_rank = SNAP_PTR(delta, w->eytz_rank);
+
+	if (id) {
+		r->id = id;
+		return;
+	}
+	r->id = SNAP_PTR(delta, r->id);
+	id = r->id;
+	id->tag = SNAP_PTR(delta, id->tag);
+	if (id->type == REF_ID_RAW) {
+		id->value.raw = SNAP_PTR(delta, id->value.raw);
+		return;
+	}
+
+	struct pansn *pn = SNAP_PTR(delta, id->value.id_value);
+	pn->sample_name = SNAP_PTR(delta, pn->sample_name);
+	pn->contig_name = SNAP_PTR(delta, pn->contig_name);
+	id->value.id_value = pn;
+}
+
+/**
+ * Move every pointer of the snapshot mapped at base by delta, which turns
+ * the offsets of a snapshot file into pointers when delta is base. The table
+ * of the refs holds their pointers afterwards.
+ */
+static void relocate(byte *base, uintptr_t delta, const struct snap_header *h)
+{
+	vtx *vtxs = (vtx *)(base + h->vtxs_off);
+	for (idx_t i = 0; i < h->vtx_count; i++)
+		vtxs[i].seq = SNAP_PTR(delta, vtxs[i].seq);
+
+	if (h->flags & SNAP_SHARED) {
+		u64 *ptrs = (u64 *)(base + h->vtx_ptrs_off);
+		for (id_t v = 0; v < h->vtx_arr_size; v++)
+			if (ptrs[v])
+				ptrs[v] += delta;
+	}
+
+	if (!(h->flags & SNAP_HAS_REFS))
+		return;
+
+	// the runs of a walk share an id, which is moved once
+	u64 *refs = (u64 *)(base + h->refs_off);
+	uintptr_t last_off = 0;
+	struct ref_id *last = NULL;
+	for (idx_t i = 0; i < h->ref_count; i++) {
+		if (!refs[i])
+			continue;
+		refs[i] += delta;
+		struct ref *r = (struct ref *)(uintptr_t)refs[i];
+		uintptr_t id_off = (uintptr_t)r->id;
+		swizzle_ref(delta, r, last && id_off == last_off ? last : NULL);
+		last_off = id_off;
+		last = r->id;
+	}
+}
+
+static status_t attach_snapshot(gfa_props *gfa, byte *base,
+				const struct snap_header *h)
+{
+	// a shared graph brings the pointers to its vertices and refs along
+	bool shared = (h->flags & SNAP_SHARED) != 0;
+
+	if (shared) {
+		gfa->v = (vtx **)(base + h->vtx_ptrs_off);
+	} else {
+		size_t n = h->vtx_arr_size ? h->vtx_arr_size : 1;
+		gfa->v = calloc(n, sizeof(vtx *));
+		if (!gfa->v)
+			return ERROR_CODE_OUT_OF_MEMORY;
+
+		vtx *vtxs = (vtx *)(base + h->vtxs_off);
+		for (idx_t i = 0; i < h->vtx_count; i++)
+			gfa->v[gfa_vtx_slot(gfa, vtxs[i].id)] = &vtxs[i];
+	}
+
+	gfa->e = (edge *)(base + h->edges_off);
+
+	if (h->flags & SNAP_HAS_REFS) {
+		const u64 *refs = (const u64 *)(base + h->refs_off);
+		gfa->ref_count = h->ref_count;
+		if (shared)
+			gfa->refs = (struct ref **)(base + h->refs_off);
+		else
+			gfa->refs = malloc(sizeof(struct ref *) *
+					   (h->ref_count ? h->ref_count : 1));
+		gfa->names = lq_intern_new();
+		if (!gfa->refs || !gfa->names)
+			return ERROR_CODE_OUT_OF_MEMORY;
+
+		for (idx_t i = 0; i < h->ref_count && !shared; i++)
+			gfa->refs[i] = (struct ref *)(uintptr_t)refs[i];
+
+		// interning in order gives the names their old handles
+		const u64 *names = (const u64 *)(base + h->names_off);
+		for (idx_t i = 0; i < h->name_count; i++) {
+			const char *s = (const char *)(base + names[i]);
+			if (lq_intern_str(gfa->names, s, strlen(s), NULL) != i)
+				return ERROR_CODE_OUT_OF_MEMORY;
+		}
+
+		gfa->ref_lookup =
+			build_ref_lookup(gfa->refs, gfa->ref_count,
+					 h->name_count,
+					 gfa->arenas[GFA_ARENA_REFS]);
+		if (!gfa->ref_lookup)
+			return ERROR_CODE_OUT_OF_MEMORY;
+	}
+
+	if (h->flags & SNAP_HAS_OCC_INDEX) {
+		gfa->occ_offsets = (u64 *)(base + h->occ_offsets_off);
+		gfa->occs = (struct vtx_occ *)(base + h->occs_off);
+	}
+
+	if (h->flags & SNAP_HAS_STATS) {
+		gfa->stats = malloc(sizeof(struct gfa_stats));
+		if (!gfa->stats)
+			return ERROR_CODE_OUT_OF_MEMORY;
+		memcpy(gfa->stats, base + h->stats_off,
+		       sizeof(struct gfa_stats));
+	}
+
+	return SUCCESS;
+}
+
+// the graph of the relocated snapshot at base, which it takes ownership of
+static gfa_props *open_snapshot(byte *base, size_t size,
+				const struct snap_header *h)
+{
+	gfa_config conf = {
+		.fp = NULL,
+		.inc_vtx_labels = (h->flags & SNAP_HAS_LABELS) != 0,
+		.inc_refs = (h->flags & SNAP_HAS_REFS) != 0,
+		.inc_occ_index = (h->flags & SNAP_HAS_OCC_INDEX) != 0,
+		.thread_count = 0,
+		.inc_stats = (h->flags & SNAP_HAS_STATS) != 0,
+	};
+	gfa_props *gfa = init_gfa(&conf);
+	if (!gfa) {
+		munmap(base, size);
+		return NULL;
+	}
+
+	gfa->snapshot = base;
+	gfa->snapshot_size = size;
+	gfa->version = h->gfa_version;
+	gfa->min_v_id = h->min_v_id;
+	gfa->max_v_id = h->max_v_id;
+	gfa->vtx_arr_size = h->vtx_arr_size;
+	gfa->v_lo = h->v_lo;
+	gfa->v_hi = h->v_hi;
+	gfa->s_line_count = h->s_line_count;
+	gfa->l_line_count = h->l_line_count;
+	gfa->p_line_count = h->p_line_count;
+	gfa->w_line_count = h->w_line_count;
+
+	status_t res = alloc_gfa_arenas(gfa);
+	if (res == SUCCESS)
+		res = attach_snapshot(gfa, base, h);
+	if (res != SUCCESS) {
+		gfa_free(gfa);
+		return NULL;
+	}
+	gfa->status = SUCCESS;
+
+	return gfa;
+}
+
+gfa_props *gfa_load_snapshot(const char *fp)
+{
+	int fd = open(fp, O_RDONLY);
+	if (fd == -1) {
+		log_error("Failed to open snapshot %s", fp);
+		return NULL;
+	}
+
+	struct stat sb;
+	byte *base = MAP_FAILED;
+	if (fstat(fd, &sb) == 0 && sb.st_size > 0)
+		// private and writable so that the pointers can be swizzled in
+		// place, only the pages that hold pointers get copied
+		base = mmap(NULL, sb.st_size, PROT_READ | PROT_WRITE,
+			    MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED) {
+		log_error("Failed to map snapshot %s", fp);
+		return NULL;
+	}
+
+	size_t file_size = sb.st_size;
+	const struct snap_header *h = (const struct snap_header *)base;
+	status_t res = check_header(h, file_size, base);
+	if (res == SUCCESS && (h->flags & SNAP_SHARED))
+		res = ERROR_CODE_INVALID_ARGUMENT;
+	if (res != SUCCESS) {
+		log_error("%s is not a valid liteseq snapshot", fp);
+		munmap(base, file_size);
+		return NULL;
+	}
+
+	relocate(base, (uintptr_t)base, h);
+	gfa_props *gfa = open_snapshot(base, file_size, h);
+	if (!gfa)
+		log_error("Failed to load snapshot %s", fp);
+
+	return gfa;
+}
+
+/*
+ * Sharing
+ * -------
+ * The segment is written in place through a shared mapping and swizzled for
+ * the address it was written at, the header goes in last. It is never
+ * checksummed, reading all of it would undo the point of attaching.
+ */
+
+static status_t publish_to(const gfa_props *gfa, int fd)
+{
+	// the tables of vertex and ref pointers are u64 arrays in the segment
+	if (sizeof(void *) != sizeof(u64))
+		return ERROR_CODE_NOT_IMPLEMENTED;
+
+	struct snap_header h;
+	memset(&h, 0, sizeof(h));
+	fill_header(gfa, &h);
+	h.flags |= SNAP_SHARED;
+
+	struct snap_writer sizing = {.base = NULL, .size = 0};
+	status_t res = emit_snapshot(gfa, &sizing, &h);
+	if (res != SUCCESS)
+		return res;
+	h.file_size = sizing.size;
+
+	byte *base = MAP_FAILED;
+	if (ftruncate(fd, (off_t)h.file_size) == 0)
+		base = mmap(NULL, h.file_size, PROT_READ | PROT_WRITE,
+			    MAP_SHARED, fd, 0);
+	if (base == MAP_FAILED) {
+		log_error("Failed to map a segment of %zu bytes",
+			  (size_t)h.file_size);
+		return FAILURE;
+	}
+
+	struct snap_writer writer = {.base = base, .size = 0};
+	res = emit_snapshot(gfa, &writer, &h);
+	if (res == SUCCESS) {
+		h.map_addr = (uintptr_t)base;
+		relocate(base, (uintptr_t)base, &h);
+		// the magic is only seen after the rest
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+		memcpy(base, &h, sizeof(h));
+	}
+	munmap(base, h.file_size);
+
+	return res;
+}
+
+static bool valid_param(const gfa_props *gfa)
+{
+	return gfa && gfa->status == SUCCESS && gfa->v;
+}
+
+int gfa_publish_memfd(const gfa_props *gfa)
+{
+	if (!valid_param(gfa))
+		return -1;
+
+#if defined(__linux__)
+	int fd = memfd_create("liteseq", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (fd == -1) {
+		log_error("Failed to create a memfd");
+		return -1;
+	}
+
+	if (publish_to(gfa, fd) != SUCCESS) {
+		close(fd);
+		return -1;
+	}
+
+	// the graph can't change under those that attach to it
+	int seals = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL;
+	if (fcntl(fd, F_ADD_SEALS, seals) != 0)
+		log_warn("Failed to seal the memfd of a published graph");
+
+	return fd;
+#else
+	log_error("memfd is not supported on this platform");
+	return -1;
+#endif
+}
+
+status_t gfa_publish(const gfa_props *gfa, const char *name)
+{
+	if (!valid_param(gfa) || !name)
+		return ERROR_CODE_INVALID_ARGUMENT;
+
+	// a fresh object, those attached to an older one keep it
+	shm_unlink(name);
+	int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (fd == -1) {
+		log_error("Failed to create the shared memory object %s", name);
+		return FAILURE;
+	}
+
+	status_t res = publish_to(gfa, fd);
+	close(fd);
+	if (res != SUCCESS) {
+		log_error("Failed to publish the graph to %s", name);
+		shm_unlink(name);
+	}
+
+	return res;
+}
+
+status_t gfa_unpublish(const char *name)
+{
+	if (!name)
+		return ERROR_CODE_INVALID_ARGUMENT;
+
+	return shm_unlink(name) == 0 ? SUCCESS : FAILURE;
+}
+
+gfa_props *gfa_attach(int fd)
+{
+	struct snap_header h;
+	struct stat sb;
+	if (fstat(fd, &sb) != 0 || (size_t)sb.st_size < sizeof(h) ||
+	    pread(fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h) ||
+	    memcmp(h.magic, SNAP_MAGIC, sizeof(h.magic)) != 0 ||
+	    h.format_version != SNAP_FORMAT_VERSION ||
+	    h.byte_order != SNAP_BYTE_ORDER || h.ptr_size != sizeof(void *) ||
+	    !(h.flags & SNAP_SHARED) || h.file_size != (u64)sb.st_size) {
+		log_error("fd %d does not hold a published graph", fd);
+		return NULL;
+	}
+	size_t size = sb.st_size;
+
+	void *want = (void *)(uintptr_t)h.map_addr;
+	byte *base = mmap(want, size, PROT_READ, MAP_SHARED, fd, 0);
+	if (base != MAP_FAILED && base != want) {
+		// the address is taken here, copy the pages with pointers
+		munmap(base, size);
+		base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+			    fd, 0);
+		if (base != MAP_FAILED)
+			relocate(base, (uintptr_t)base - (uintptr_t)want, &h);
+	}
+	if (base == MAP_FAILED) {
+		log_error("Failed to map the published graph of fd %d", fd);
+		return NULL;
+	}
+
+	return open_snapshot(base, size, &h);
+}
+
+gfa_props *gfa_attach_shm(const char *name)
+{
+	int fd = name ? shm_open(name, O_RDONLY, 0) : -1;
+	if (fd == -1) {
+		log_error("Failed to open the shared memory object %s",
+			  name ? name : "(null)");
+		return NULL;
+	}
+
+	gfa_props *gfa = gfa_attach(fd);
+	close(fd);
+
+	return gfa;
+}
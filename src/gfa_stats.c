@@ -0,0 +1,165 @@
+#include <stdlib.h>
+
+#include "../include/liteseq/gfa.h"
+#include "../include/liteseq/refs.h"
+#include "../include/liteseq/types.h"
+
+#include "./gfa_s.h"
+#include "./gfa_stats.h"
+
+status_t alloc_stats_acc(const gfa_props *gfa, u32 **seg_lens,
+			 struct l_stats_acc *l_acc)
+{
+	*seg_lens = calloc(gfa->s_line_count ? gfa->s_line_count : 1,
+			   sizeof(u32));
+	l_acc->side_deg = calloc((size_t)gfa->vtx_arr_size * 2, sizeof(u32));
+	l_acc->vtx_arr_size = gfa->vtx_arr_size;
+	l_acc->v_lo = gfa->v_lo;
+	l_acc->self_loops = 0;
+	if (!*seg_lens || !l_acc->side_deg) {
+		free(*seg_lens);
+		free(l_acc->side_deg);
+		*seg_lens = NULL;
+		l_acc->side_deg = NULL;
+		return ERROR_CODE_OUT_OF_MEMORY;
+	}
+
+	return SUCCESS;
+}
+
+static int cmp_len_desc(const void *a, const void *b)
+{
+	u32 x = *(const u32 *)a;
+	u32 y = *(const u32 *)b;
+	return (x < y) - (x > y);
+}
+
+static void segment_stats(struct gfa_stats *st, u32 *lens, idx_t count)
+{
+	st->seg_count = count;
+	if (count == 0)
+		return;
+
+	qsort(lens, count, sizeof(u32), cmp_len_desc);
+	st->seg_max_len = lens[0];
+	st->seg_min_len = lens[count - 1];
+
+	st->seg_total_len = 0;
+	for (idx_t i = 0; i < count; i++)
+		st->seg_total_len += lens[i];
+
+	// the length of the shortest of the longest segments that make up
+	// half of the total
+	u64 sum = 0;
+	for (idx_t i = 0; i < count; i++) {
+		sum += lens[i];
+		if (sum * 2 >= st->seg_total_len) {
+			st->seg_n50 = lens[i];
+			break;
+		}
+	}
+}
+
+static void link_stats(struct gfa_stats *st, const gfa_props *gfa,
+		       const struct l_stats_acc *l_acc)
+{
+	st->edge_count = gfa->l_line_count;
+	st->self_loops = l_acc->self_loops;
+
+	for (id_t v = 0; v < gfa->vtx_arr_size; v++) {
+		if (gfa->v[v] == NULL)
+			continue;
+
+		u32 left = l_acc->side_deg[2 * v + LEFT];
+		u32 right = l_acc->side_deg[2 * v + RIGHT];
+		u32 deg = left + right;
+		if (deg == 0)
+			st->isolated++;
+		else if (left == 0 || right == 0)
+			st->tips++;
+
+		if (deg >= GFA_STATS_DEGREE_BUCKETS)
+			deg = GFA_STATS_DEGREE_BUCKETS - 1;
+		st->degree_hist[deg]++;
+	}
+}
+
+static inline idx_t log2_bucket(idx_t n)
+{
+	return n == 0 ? 0 : 31 - __builtin_clz(n);
+}
+
+static void ref_stats(struct gfa_stats *st, const gfa_props *gfa)
+{
+	st->ref_count = gfa->ref_count;
+	if (!gfa->inc_refs || gfa->ref_count == 0)
+		return;
+
+	// hap_len is only known once the loci are set
+	bool have_len = gfa->inc_vtx_labels;
+	st->ref_min_steps = NULL_IDX;
+	st->ref_min_len = have_len ? NULL_IDX : 0;
+
+	for (idx_t i = 0; i < gfa->ref_count; i++) {
+		const struct ref *r = gfa->refs[i];
+		if (!r)
+			continue;
+
+		idx_t steps = get_step_count(r);
+		st->ref_total_steps += steps;
+		if (steps < st->ref_min_steps)
+			st->ref_min_steps = steps;
+		if (steps > st->ref_max_steps)
+			st->ref_max_steps = steps;
+
+		if (!have_len)
+			continue;
+
+		idx_t len = get_hap_len(r);
+		st->ref_total_len += len;
+		if (len < st->ref_min_len)
+			st->ref_min_len = len;
+		if (len > st->ref_max_len)
+			st->ref_max_len = len;
+		st->ref_len_hist[log2_bucket(len)]++;
+	}
+}
+
+status_t finalize_gfa_stats(gfa_props *gfa, u32 **seg_lens,
+			    struct l_stats_acc *l_acc)
+{
+	struct gfa_stats *st = calloc(1, sizeof(struct gfa_stats));
+	if (st) {
+		segment_stats(st, *seg_lens, gfa->s_line_count);
+		link_stats(st, gfa, l_acc);
+		ref_stats(st, gfa);
+	}
+
+	free(*seg_lens);
+	free(l_acc->side_deg);
+	*seg_lens = NULL;
+	l_acc->side_deg = NULL;
+
+	gfa->stats = st;
+
+	return st ? SUCCESS : ERROR_CODE_OUT_OF_MEMORY;
+}
+
+status_t collect_gfa_stats(gfa_props *gfa)
+{
+	u32 *seg_lens = NULL;
+	struct l_stats_acc l_acc = {.side_deg = NULL};
+	if (alloc_stats_acc(gfa, &seg_lens, &l_acc) != SUCCESS)
+		return ERROR_CODE_OUT_OF_MEMORY;
+
+	for (idx_t i = 0; i < gfa->s_line_count; i++)
+		seg_lens[i] = s_line_label_len(gfa->s_lines[i].start,
+					       gfa->s_lines[i].len);
+	for (idx_t i = 0; i < gfa->l_line_count; i++)
+		stats_acc_edge(&l_acc, &gfa->e[i]);
+
+	free(gfa->stats);
+	gfa->stats = NULL;
+
+	return finalize_gfa_stats(gfa, &seg_lens, &l_acc);
+}
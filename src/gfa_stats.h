@@ -0,0 +1,62 @@
+#ifndef LQ_GFA_STATS_H
+#define LQ_GFA_STATS_H
+
+#include "../include/liteseq/gfa.h"
+
+#ifdef __cplusplus
+extern "C" {
+namespace liteseq
+{
+#endif
+
+/*
+ * Accumulators filled by the parsing workers as they go, each worker owns its
+ * own so none of them is shared while parsing
+ */
+
+// filled by the L line worker
+struct l_stats_acc {
+	u32 *side_deg; // the edges on each side of a vertex, [2 * slot + side]
+	u32 vtx_arr_size;
+	id_t v_lo; // see gfa_vtx_slot
+	idx_t self_loops;
+};
+
+static inline void stats_acc_edge(struct l_stats_acc *acc, const edge *e)
+{
+	u32 s1 = e->v1_id - acc->v_lo;
+	u32 s2 = e->v2_id - acc->v_lo;
+	if (s1 >= acc->vtx_arr_size || s2 >= acc->vtx_arr_size)
+		return;
+	acc->side_deg[2 * s1 + e->v1_side]++;
+	acc->side_deg[2 * s2 + e->v2_side]++;
+	if (e->v1_id == e->v2_id)
+		acc->self_loops++;
+}
+
+/**
+ * Allocate the accumulators of a gfa whose line counts and vertex ids are
+ * known. seg_lens gets the label length of each S line.
+ */
+status_t alloc_stats_acc(const gfa_props *gfa, u32 **seg_lens,
+			 struct l_stats_acc *l_acc);
+
+/**
+ * Merge the accumulators of the workers and what the refs hold into
+ * gfa->stats, releasing the accumulators
+ */
+status_t finalize_gfa_stats(gfa_props *gfa, u32 **seg_lens,
+			    struct l_stats_acc *l_acc);
+
+/**
+ * Collect gfa->stats from the line tables and the parsed graph, replacing any
+ * previous stats
+ */
+status_t collect_gfa_stats(gfa_props *gfa);
+
+#ifdef __cplusplus
+} // namespace liteseq
+} // extern "C"
+#endif
+
+#endif // LQ_GFA_STATS_H
@@ -0,0 +1,522 @@
+#if defined(__linux__)
+#define _GNU_SOURCE // ftruncate
+#endif
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <log.h>
+
+#include "../include/liteseq/gfa.h"
+#include "../include/liteseq/refs.h"
+#include "../include/liteseq/types.h"
+#include "../src/internal/lq_io.h"
+#include "../src/internal/lq_utils.h"
+
+#include "./gfa_impl.h"
+
+#define GFA_WRITE_BUF_SIZE (1024 * 1024)
+
+// the vertices or edges in one unit of work
+#define GFA_WRITE_BLOCK 8192
+
+#define L_LINE_OVERLAP "0M"
+#define NO_VALUE '*'
+
+/*
+ * The output is cut into items: the header, blocks of vertices, blocks of
+ * edges and one item per ref. The workers first size every item so that the
+ * offset of each in the file is known, then format them straight to those
+ * offsets.
+ */
+enum item_kind {
+	ITEM_H,
+	ITEM_S,
+	ITEM_L,
+	ITEM_REF,
+};
+
+struct write_item {
+	enum item_kind kind;
+	idx_t first; // the first vertex id, edge or ref
+	idx_t count;
+};
+
+struct write_thread_meta {
+	const gfa_props *gfa;
+	const struct write_item *items;
+	idx_t item_count;
+	u64 *offsets; // the size of each item, then its offset
+	idx_t *next_item;
+	int fd;
+	status_t status;
+};
+
+static inline char strand_symbol(enum strand s)
+{
+	return s == STRAND_FWD ? P_LINE_FORWARD_SYMBOL : P_LINE_REVERSE_SYMBOL;
+}
+
+static inline char walk_symbol(enum strand s)
+{
+	return s == STRAND_FWD ? W_LINE_FORWARD_SYMBOL : W_LINE_REVERSE_SYMBOL;
+}
+
+/**
+ * The orientations an L line of e is written with. Same strand self loops
+ * are stored as LEFT to RIGHT and written forward.
+ */
+static inline void edge_symbols(const edge *e, char *s1, char *s2)
+{
+	if (e->v1_id == e->v2_id && e->v1_side == LEFT && e->v2_side == RIGHT) {
+		*s1 = P_LINE_FORWARD_SYMBOL;
+		*s2 = P_LINE_FORWARD_SYMBOL;
+		return;
+	}
+	*s1 = e->v1_side == RIGHT ? P_LINE_FORWARD_SYMBOL
+				  : P_LINE_REVERSE_SYMBOL;
+	*s2 = e->v2_side == LEFT ? P_LINE_FORWARD_SYMBOL
+				 : P_LINE_REVERSE_SYMBOL;
+}
+
+/*
+ * Sizing
+ * ------
+ */
+
+static u64 size_s(const gfa_props *gfa, const struct write_item *it)
+{
+	u64 size = 0;
+	for (id_t v = it->first; v < it->first + it->count; v++) {
+		const vtx *x = gfa->v[v];
+		if (!x)
+			continue;
+		// S\t<id>\t<label>\n
+		size += 2 + count_digits(x->id) + 1 +
+			(x->seq ? strlen(x->seq) : 1) + 1;
+	}
+
+	return size;
+}
+
+static u64 size_l(const gfa_props *gfa, const struct write_item *it)
+{
+	u64 size = 0;
+	for (idx_t i = it->first; i < it->first + it->count; i++) {
+		const edge *e = &gfa->e[i];
+		// L\t<v1>\t<s1>\t<v2>\t<s2>\t<overlap>\n
+		size += 2 + count_digits(e->v1_id) + 3 +
+			count_digits(e->v2_id) + 3 + strlen(L_LINE_OVERLAP) + 1;
+	}
+
+	return size;
+}
+
+static u64 size_steps(const struct ref *r)
+{
+	idx_t n = get_step_count(r);
+	const id_t *v_ids = get_walk_v_ids(r);
+
+	u64 size = 0;
+	for (idx_t i = 0; i < n; i++)
+		size += count_digits(v_ids[i]) + 1; // the id and its strand
+
+	// the commas between the steps of a P line
+	if (get_line_prefix(r) == P_LINE && n > 0)
+		size += n - 1;
+
+	return size;
+}
+
+static u64 size_ref(const gfa_props *gfa, const struct ref *r)
+{
+	if (!r)
+		return 0;
+
+	if (get_line_prefix(r) == P_LINE) // P\t<name>\t<steps>\t*\n
+		return 2 + strlen(get_tag(r)) + 1 + size_steps(r) + 3;
+
+	// W\t<sample>\t<hap>\t<contig>\t<start>\t<end>\t<steps>\n
+	u64 size = 2 + strlen(get_sample_name(r)) + 1 +
+		   count_digits(get_hap_id(r)) + 1 +
+		   strlen(get_contig_name(r)) + 1;
+	size += gfa->inc_vtx_labels ? 2 + count_digits(get_hap_len(r)) + 1
+				    : 4;
+
+	return size + size_steps(r) + 1;
+}
+
+static u64 size_item(const gfa_props *gfa, const struct write_item *it)
+{
+	switch (it->kind) {
+	case ITEM_H: // H\t<version>\n
+		return 2 + strlen(to_string_gfa_version(gfa->version)) + 1;
+	case ITEM_S:
+		return size_s(gfa, it);
+	case ITEM_L:
+		return size_l(gfa, it);
+	case ITEM_REF:
+		return size_ref(gfa, gfa->refs[it->first]);
+	}
+
+	return 0;
+}
+
+/*
+ * Formatting
+ * ----------
+ */
+
+static inline void put_char(struct lq_out_buf *o, char c)
+{
+	*lq_out_reserve(o, 1) = c;
+	o->used++;
+}
+
+static inline void put_str(struct lq_out_buf *o, const char *s)
+{
+	lq_out_append(o, s, strlen(s));
+}
+
+static inline void put_u32(struct lq_out_buf *o, u32 v)
+{
+	char *p = lq_out_reserve(o, LQ_U32_DEC_MAX);
+	o->used += lq_u32_to_dec(p, v) - p;
+}
+
+static void write_s(const gfa_props *gfa, const struct write_item *it,
+		    struct lq_out_buf *o)
+{
+	for (id_t v = it->first; v < it->first + it->count; v++) {
+		const vtx *x = gfa->v[v];
+		if (!x)
+			continue;
+
+		char *p = lq_out_reserve(o, 3 + LQ_U32_DEC_MAX);
+		char *q = p;
+		*q++ = GFA_S_LINE;
+		*q++ = TAB_CHAR;
+		q = lq_u32_to_dec(q, x->id);
+		*q++ = TAB_CHAR;
+		o->used += q - p;
+
+		if (x->seq)
+			put_str(o, x->seq);
+		else
+			put_char(o, NO_VALUE);
+		put_char(o, NEWLINE);
+	}
+}
+
+static void write_l(const gfa_props *gfa, const struct write_item *it,
+		    struct lq_out_buf *o)
+{
+	// room for everything but the numbers
+	const size_t fixed = 9 + sizeof(L_LINE_OVERLAP);
+
+	for (idx_t i = it->first; i < it->first + it->count; i++) {
+		const edge *e = &gfa->e[i];
+		char s1, s2;
+		edge_symbols(e, &s1, &s2);
+
+		char *p = lq_out_reserve(o, fixed + 2 * LQ_U32_DEC_MAX);
+		char *q = p;
+		*q++ = GFA_L_LINE;
+		*q++ = TAB_CHAR;
+		q = lq_u32_to_dec(q, e->v1_id);
+		*q++ = TAB_CHAR;
+		*q++ = s1;
+		*q++ = TAB_CHAR;
+		q = lq_u32_to_dec(q, e->v2_id);
+		*q++ = TAB_CHAR;
+		*q++ = s2;
+		*q++ = TAB_CHAR;
+		memcpy(q, L_LINE_OVERLAP, sizeof(L_LINE_OVERLAP) - 1);
+		q += sizeof(L_LINE_OVERLAP) - 1;
+		*q++ = NEWLINE;
+		o->used += q - p;
+	}
+}
+
+static void write_steps(const struct ref *r, struct lq_out_buf *o)
+{
+	idx_t n = get_step_count(r);
+	const id_t *v_ids = get_walk_v_ids(r);
+	const enum strand *strands = get_walk_strands(r);
+
+	if (get_line_prefix(r) == P_LINE) {
+		for (idx_t i = 0; i < n; i++) {
+			char *p = lq_out_reserve(o, LQ_U32_DEC_MAX + 2);
+			char *q = lq_u32_to_dec(p, v_ids[i]);
+			*q++ = strand_symbol(strands[i]);
+			if (i + 1 < n)
+				*q++ = COMMA_CHAR;
+			o->used += q - p;
+		}
+		return;
+	}
+
+	for (idx_t i = 0; i < n; i++) {
+		char *p = lq_out_reserve(o, LQ_U32_DEC_MAX + 1);
+		*p = walk_symbol(strands[i]);
+		o->used += lq_u32_to_dec(p + 1, v_ids[i]) - p;
+	}
+}
+
+static void write_ref(const gfa_props *gfa, const struct ref *r,
+		      struct lq_out_buf *o)
+{
+	if (!r)
+		return;
+
+	if (get_line_prefix(r) == P_LINE) {
+		put_char(o, GFA_P_LINE);
+		put_char(o, TAB_CHAR);
+		put_str(o, get_tag(r));
+		put_char(o, TAB_CHAR);
+		write_steps(r, o);
+		put_char(o, TAB_CHAR);
+		put_char(o, NO_VALUE);
+		put_char(o, NEWLINE);
+		return;
+	}
+
+	put_char(o, GFA_W_LINE);
+	put_char(o, TAB_CHAR);
+	put_str(o, get_sample_name(r));
+	put_char(o, TAB_CHAR);
+	put_u32(o, get_hap_id(r));
+	put_char(o, TAB_CHAR);
+	put_str(o, get_contig_name(r));
+	put_char(o, TAB_CHAR);
+	if (gfa->inc_vtx_labels) { // the whole sequence
+		put_char(o, '0');
+		put_char(o, TAB_CHAR);
+		put_u32(o, get_hap_len(r));
+	} else {
+		put_char(o, NO_VALUE);
+		put_char(o, TAB_CHAR);
+		put_char(o, NO_VALUE);
+	}
+	put_char(o, TAB_CHAR);
+	write_steps(r, o);
+	put_char(o, NEWLINE);
+}
+
+static void write_item(const gfa_props *gfa, const struct write_item *it,
+		       struct lq_out_buf *o)
+{
+	switch (it->kind) {
+	case ITEM_H:
+		put_char(o, GFA_H_LINE);
+		put_char(o, TAB_CHAR);
+		put_str(o, to_string_gfa_version(gfa->version));
+		put_char(o, NEWLINE);
+		break;
+	case ITEM_S:
+		write_s(gfa, it, o);
+		break;
+	case ITEM_L:
+		write_l(gfa, it, o);
+		break;
+	case ITEM_REF:
+		write_ref(gfa, gfa->refs[it->first], o);
+		break;
+	}
+}
+
+static void *t_size_items(void *meta)
+{
+	struct write_thread_meta *m = (struct write_thread_meta *)meta;
+	for (;;) {
+		idx_t i = __atomic_fetch_add(m->next_item, 1, __ATOMIC_RELAXED);
+		if (i >= m->item_count)
+			break;
+		m->offsets[i] = size_item(m->gfa, &m->items[i]);
+	}
+
+	return NULL;
+}
+
+static void *t_write_items(void *meta)
+{
+	struct write_thread_meta *m = (struct write_thread_meta *)meta;
+	struct lq_out_buf o = {
+		.fd = m->fd,
+		.data = malloc(GFA_WRITE_BUF_SIZE),
+		.used = 0,
+		.cap = GFA_WRITE_BUF_SIZE,
+		.status = SUCCESS,
+	};
+	if (!o.data) {
+		m->status = ERROR_CODE_OUT_OF_MEMORY;
+		return NULL;
+	}
+
+	for (;;) {
+		idx_t i = __atomic_fetch_add(m->next_item, 1, __ATOMIC_RELAXED);
+		if (i >= m->item_count)
+			break;
+
+		o.offset = m->offsets[i];
+		write_item(m->gfa, &m->items[i], &o);
+		lq_out_flush(&o);
+		if (o.status != SUCCESS ||
+		    o.offset != m->offsets[i + 1]) { // sized wrongly
+			m->status = FAILURE;
+			break;
+		}
+	}
+	free(o.data);
+
+	return NULL;
+}
+
+// the b-th block of GFA_WRITE_BLOCK of total vertex ids or edges
+static struct write_item block(enum item_kind kind, idx_t b, idx_t total)
+{
+	idx_t first = b * GFA_WRITE_BLOCK;
+	idx_t left = total - first;
+
+	return (struct write_item){
+		.kind = kind,
+		.first = first,
+		.count = left < GFA_WRITE_BLOCK ? left : GFA_WRITE_BLOCK,
+	};
+}
+
+/**
+ * Cut the output of gfa into items
+ *
+ * @return the items to be freed by the caller, NULL when out of memory
+ */
+static struct write_item *plan_items(const gfa_props *gfa,
+				     const struct gfa_write_opts *opts,
+				     idx_t *count)
+{
+	bool inc_edges = opts ? opts->inc_edges : true;
+	bool inc_refs = (opts ? opts->inc_refs : true) && gfa->inc_refs;
+
+	idx_t l_count = inc_edges ? gfa->l_line_count : 0;
+	idx_t ref_count = inc_refs ? gfa->ref_count : 0;
+	idx_t s_blocks = (gfa->vtx_arr_size + GFA_WRITE_BLOCK - 1) /
+			 GFA_WRITE_BLOCK;
+	idx_t l_blocks = (l_count + GFA_WRITE_BLOCK - 1) / GFA_WRITE_BLOCK;
+
+	size_t item_count = 1 + (size_t)s_blocks + l_blocks + ref_count;
+	struct write_item *items =
+		malloc(sizeof(struct write_item) * item_count);
+	if (!items)
+		return NULL;
+
+	idx_t n = 0;
+	items[n++] = (struct write_item){.kind = ITEM_H};
+	for (idx_t b = 0; b < s_blocks; b++)
+		items[n++] = block(ITEM_S, b, gfa->vtx_arr_size);
+	for (idx_t b = 0; b < l_blocks; b++)
+		items[n++] = block(ITEM_L, b, l_count);
+	for (idx_t i = 0; i < ref_count; i++)
+		items[n++] = (struct write_item){
+			.kind = ITEM_REF, .first = i, .count = 1};
+
+	*count = n;
+
+	return items;
+}
+
+static status_t run_pass(struct write_thread_meta *metas, u32 thread_count,
+			 void *(*fn)(void *))
+{
+	idx_t *next_item = metas[0].next_item;
+	*next_item = 0;
+
+	status_t res = lq_run_threads(thread_count, fn, metas,
+				      sizeof(struct write_thread_meta));
+	for (u32 t = 0; t < thread_count && res == SUCCESS; t++)
+		res = metas[t].status;
+
+	return res;
+}
+
+status_t gfa_write(const gfa_props *gfa, const char *fp,
+		   const struct gfa_write_opts *opts)
+{
+	// a partial graph has L lines to vertices it does not hold and split
+	// walks with no place in the whole one
+	if (!gfa || !fp || gfa->status != SUCCESS || !gfa->v ||
+	    gfa_is_partial(gfa))
+		return ERROR_CODE_INVALID_ARGUMENT;
+
+	idx_t item_count = 0;
+	struct write_item *items = plan_items(gfa, opts, &item_count);
+	u64 *offsets = malloc(sizeof(u64) * ((size_t)item_count + 1));
+
+	u32 thread_count = gfa->thread_count ? gfa->thread_count : 1;
+	if (thread_count > item_count)
+		thread_count = item_count;
+
+	struct write_thread_meta *metas =
+		malloc(sizeof(struct write_thread_meta) * thread_count);
+	if (!items || !offsets || !metas) {
+		free(items);
+		free(offsets);
+		free(metas);
+		return ERROR_CODE_OUT_OF_MEMORY;
+	}
+
+	int fd = open(fp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd == -1) {
+		log_error("Failed to open %s for writing", fp);
+		free(items);
+		free(offsets);
+		free(metas);
+		return FAILURE;
+	}
+
+	idx_t next_item = 0;
+	for (u32 t = 0; t < thread_count; t++)
+		metas[t] = (struct write_thread_meta){
+			.gfa = gfa,
+			.items = items,
+			.item_count = item_count,
+			.offsets = offsets,
+			.next_item = &next_item,
+			.fd = fd,
+			.status = SUCCESS,
+		};
+
+	status_t res = run_pass(metas, thread_count, t_size_items);
+
+	if (res == SUCCESS) {
+		// the sizes to the offsets, one past the end is the file size
+		u64 offset = 0;
+		for (idx_t i = 0; i < item_count; i++) {
+			u64 size = offsets[i];
+			offsets[i] = offset;
+			offset += size;
+		}
+		offsets[item_count] = offset;
+
+		if (ftruncate(fd, (off_t)offset) == -1) {
+			log_error("Failed to size %s", fp);
+			res = FAILURE;
+		}
+	}
+
+	if (res == SUCCESS)
+		res = run_pass(metas, thread_count, t_write_items);
+
+	if (close(fd) == -1 && res == SUCCESS)
+		res = FAILURE;
+
+	if (res != SUCCESS)
+		log_error("Failed to write GFA to %s", fp);
+
+	free(items);
+	free(offsets);
+	free(metas);
+
+	return res;
+}
@@ -0,0 +1,153 @@
+#include <stdalign.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./lq_arena.h"
+#include "./lq_utils.h"
+
+#define LQ_ARENA_ALIGN (alignof(max_align_t))
+
+struct lq_arena_block {
+	struct lq_arena_block *next; // the previously filled block
+	size_t cap;		     // usable bytes in data
+	size_t used;		     // bytes handed out so far
+	alignas(max_align_t) byte data[];
+};
+
+static inline size_t align_up(size_t n)
+{
+	return (n + (LQ_ARENA_ALIGN - 1)) & ~(LQ_ARENA_ALIGN - 1);
+}
+
+static struct lq_arena_block *alloc_block(size_t cap)
+{
+	struct lq_arena_block *b =
+		malloc(sizeof(struct lq_arena_block) + cap);
+	if (!b)
+		return NULL;
+
+	b->next = NULL;
+	b->cap = cap;
+	b->used = 0;
+
+	return b;
+}
+
+struct lq_arena *lq_arena_new(size_t block_size)
+{
+	struct lq_arena *a = malloc(sizeof(struct lq_arena));
+	if (!a)
+		return NULL;
+
+	a->block_size = block_size ? align_up(block_size) : LQ_ARENA_BLOCK_SIZE;
+	a->head = alloc_block(a->block_size);
+	if (!a->head) {
+		free(a);
+		return NULL;
+	}
+	a->block_count = 1;
+	a->alloc_count = 0;
+	a->block_allocs = 1;
+
+	return a;
+}
+
+void *lq_arena_alloc(struct lq_arena *a, size_t size)
+{
+	size = align_up(size);
+	a->alloc_count++;
+
+	struct lq_arena_block *h = a->head;
+	if (likely(h->cap - h->used >= size)) {
+		void *p = h->data + h->used;
+		h->used += size;
+		return p;
+	}
+
+	// large objects get a block of their own which is slotted in behind the
+	// head so that the space left in the head can still be used
+	if (size > a->block_size / 4) {
+		struct lq_arena_block *b = alloc_block(size);
+		if (!b)
+			return NULL;
+		b->used = size;
+		b->next = h->next;
+		h->next = b;
+		a->block_count++;
+		a->block_allocs++;
+		return b->data;
+	}
+
+	struct lq_arena_block *b = alloc_block(a->block_size);
+	if (!b)
+		return NULL;
+	b->next = h;
+	a->head = b;
+	a->block_count++;
+	a->block_allocs++;
+
+	b->used = size;
+	return b->data;
+}
+
+char *lq_arena_strndup(struct lq_arena *a, const char *s, size_t n)
+{
+	char *c = lq_arena_alloc(a, n + 1);
+	if (!c)
+		return NULL;
+
+	memcpy(c, s, n);
+	c[n] = NULL_CHAR;
+
+	return c;
+}
+
+void lq_arena_reset(struct lq_arena *a)
+{
+	struct lq_arena_block *b = a->head->next;
+	while (b != NULL) {
+		struct lq_arena_block *next = b->next;
+		free(b);
+		b = next;
+	}
+
+	a->head->next = NULL;
+	a->head->used = 0;
+	a->block_count = 1;
+}
+
+void lq_arena_destroy(struct lq_arena **a)
+{
+	if (a == NULL || *a == NULL)
+		return;
+
+	struct lq_arena_block *b = (*a)->head;
+	while (b != NULL) {
+		struct lq_arena_block *next = b->next;
+		free(b);
+		b = next;
+	}
+
+	free(*a);
+	*a = NULL;
+}
+
+void *lq_alloc(struct lq_arena *a, size_t size)
+{
+	return a ? lq_arena_alloc(a, size) : malloc(size);
+}
+
+char *lq_strndup(struct lq_arena *a, const char *s, size_t n)
+{
+	if (a)
+		return lq_arena_strndup(a, s, n);
+
+	char *c = malloc(n + 1);
+	if (!c)
+		return NULL;
+
+	memcpy(c, s, n);
+	c[n] = NULL_CHAR;
+
+	return c;
+}
@@ -0,0 +1,72 @@
+#ifndef LQ_ARENA_H
+#define LQ_ARENA_H
+
+#include <stddef.h>
+
+#include "../include/liteseq/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+namespace liteseq
+{
+#endif
+
+/**
+ * Default size of an arena block.
+ * Allocations larger than a quarter of this get a dedicated block.
+ */
+#define LQ_ARENA_BLOCK_SIZE BUFFER_SIZE
+
+struct lq_arena_block;
+
+/**
+ * A bump allocator made up of a chain of blocks.
+ *
+ * Objects allocated from an arena cannot be freed individually, they are all
+ * released together by lq_arena_destroy. An arena is not thread safe, each
+ * parsing thread owns its own.
+ */
+struct lq_arena {
+	struct lq_arena_block *head; // the block we are currently bumping into
+	size_t block_size;	     // the size of a regular block
+	idx_t block_count;	     // the number of blocks in the chain
+
+	// since lq_arena_new, a reset does not clear them, see gfa_metrics
+	u64 alloc_count;  // objects handed out
+	u64 block_allocs; // blocks taken from the heap
+};
+
+struct lq_arena *lq_arena_new(size_t block_size);
+
+/**
+ * Returns a pointer to size bytes aligned for any type, or NULL when out of
+ * memory
+ */
+void *lq_arena_alloc(struct lq_arena *a, size_t size);
+
+/**
+ * Copy n bytes of s into the arena and null terminate the copy
+ */
+char *lq_arena_strndup(struct lq_arena *a, const char *s, size_t n);
+
+/**
+ * Drop everything allocated so far but keep the current block around.
+ * Used for scratch arenas that are recycled once per line.
+ */
+void lq_arena_reset(struct lq_arena *a);
+
+void lq_arena_destroy(struct lq_arena **a);
+
+/*
+ * Helpers for code that may or may not be backed by an arena.
+ * When a is NULL they fall back to malloc and the caller owns the result.
+ */
+void *lq_alloc(struct lq_arena *a, size_t size);
+char *lq_strndup(struct lq_arena *a, const char *s, size_t n);
+
+#ifdef __cplusplus
+} // liteseq
+} // extern "C"
+#endif
+
+#endif /* LQ_ARENA_H */
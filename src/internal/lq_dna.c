@@ -0,0 +1,145 @@
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LQ_HAVE_SSSE3
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define LQ_HAVE_NEON
+#endif
+
+#include "./lq_dna.h"
+#include "./lq_utils.h"
+
+#define REVCOMP_BLOCK 16
+
+static const char COMPLEMENT[256] = {
+	['A'] = 'T', ['C'] = 'G', ['G'] = 'C', ['T'] = 'A', ['U'] = 'A',
+	['N'] = 'N', ['R'] = 'Y', ['Y'] = 'R', ['S'] = 'S', ['W'] = 'W',
+	['K'] = 'M', ['M'] = 'K', ['B'] = 'V', ['V'] = 'B', ['D'] = 'H',
+	['H'] = 'D', ['a'] = 't', ['c'] = 'g', ['g'] = 'c', ['t'] = 'a',
+	['u'] = 'a', ['n'] = 'n', ['r'] = 'y', ['y'] = 'r', ['s'] = 's',
+	['w'] = 'w', ['k'] = 'm', ['m'] = 'k', ['b'] = 'v', ['v'] = 'b',
+	['d'] = 'h', ['h'] = 'd',
+};
+
+char lq_complement(char base)
+{
+	char c = COMPLEMENT[(uint8_t)base];
+	return c ? c : base;
+}
+
+static void revcomp_scalar(char *dst, const char *src, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+		dst[i] = lq_complement(src[n - 1 - i]);
+}
+
+#ifdef TESTING
+void lq_revcomp_scalar(char *dst, const char *src, size_t n)
+{
+	revcomp_scalar(dst, src, n);
+}
+#endif
+
+/*
+ * The SIMD kernels handle blocks made up only of ACGTN in either case, which
+ * is nearly all of them, and leave the rest to the scalar kernel.
+ *
+ * The low nibbles of A C G T N are 1 3 7 4 E, all distinct, and a base and
+ * its complement differ only in their low 5 bits. So a 16 entry shuffle on the
+ * low nibble gives the low 5 bits of the complement and the case bits are
+ * carried over from the input.
+ */
+#define COMP_LUT_ENTRIES                                                       \
+	0, 0x14, 0, 0x07, 0x01, 0, 0, 0x03, 0, 0, 0, 0, 0, 0, 0x0E, 0
+
+#if defined(LQ_HAVE_SSSE3)
+__attribute__((target("ssse3"))) static void
+revcomp_ssse3(char *dst, const char *src, size_t n)
+{
+	const __m128i lut = _mm_setr_epi8(COMP_LUT_ENTRIES);
+	const __m128i rev = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6,
+					  5, 4, 3, 2, 1, 0);
+	const __m128i nibble = _mm_set1_epi8(0x0F);
+	const __m128i case_bits = _mm_set1_epi8((char)0xE0);
+	const __m128i lower = _mm_set1_epi8(0x20);
+
+	size_t i = 0;
+	for (; i + REVCOMP_BLOCK <= n; i += REVCOMP_BLOCK) {
+		const char *s = src + n - i - REVCOMP_BLOCK;
+		__m128i v = _mm_loadu_si128((const __m128i *)s);
+
+		__m128i l = _mm_or_si128(v, lower);
+		__m128i ok = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(l, _mm_set1_epi8('a')),
+				     _mm_cmpeq_epi8(l, _mm_set1_epi8('c'))),
+			_mm_or_si128(_mm_cmpeq_epi8(l, _mm_set1_epi8('g')),
+				     _mm_cmpeq_epi8(l, _mm_set1_epi8('t'))));
+		ok = _mm_or_si128(ok, _mm_cmpeq_epi8(l, _mm_set1_epi8('n')));
+		if (unlikely(_mm_movemask_epi8(ok) != 0xFFFF)) {
+			revcomp_scalar(dst + i, s, REVCOMP_BLOCK);
+			continue;
+		}
+
+		__m128i c = _mm_shuffle_epi8(lut, _mm_and_si128(v, nibble));
+		c = _mm_or_si128(c, _mm_and_si128(v, case_bits));
+		c = _mm_shuffle_epi8(c, rev);
+		_mm_storeu_si128((__m128i *)(dst + i), c);
+	}
+
+	revcomp_scalar(dst + i, src, n - i);
+}
+#elif defined(LQ_HAVE_NEON)
+static void revcomp_neon(char *dst, const char *src, size_t n)
+{
+	const uint8_t lut_entries[16] = {COMP_LUT_ENTRIES};
+	const uint8x16_t lut = vld1q_u8(lut_entries);
+	const uint8x16_t nibble = vdupq_n_u8(0x0F);
+	const uint8x16_t case_bits = vdupq_n_u8(0xE0);
+	const uint8x16_t lower = vdupq_n_u8(0x20);
+
+	size_t i = 0;
+	for (; i + REVCOMP_BLOCK <= n; i += REVCOMP_BLOCK) {
+		const char *s = src + n - i - REVCOMP_BLOCK;
+		uint8x16_t v = vld1q_u8((const uint8_t *)s);
+
+		uint8x16_t l = vorrq_u8(v, lower);
+		uint8x16_t ok = vorrq_u8(
+			vorrq_u8(vceqq_u8(l, vdupq_n_u8('a')),
+				 vceqq_u8(l, vdupq_n_u8('c'))),
+			vorrq_u8(vceqq_u8(l, vdupq_n_u8('g')),
+				 vceqq_u8(l, vdupq_n_u8('t'))));
+		ok = vorrq_u8(ok, vceqq_u8(l, vdupq_n_u8('n')));
+		if (unlikely(vminvq_u8(ok) != 0xFF)) {
+			revcomp_scalar(dst + i, s, REVCOMP_BLOCK);
+			continue;
+		}
+
+		uint8x16_t c = vqtbl1q_u8(lut, vandq_u8(v, nibble));
+		c = vorrq_u8(c, vandq_u8(v, case_bits));
+		// reverse the bytes of each half then swap the halves
+		c = vrev64q_u8(c);
+		c = vextq_u8(c, c, 8);
+		vst1q_u8((uint8_t *)(dst + i), c);
+	}
+
+	revcomp_scalar(dst + i, src, n - i);
+}
+#endif
+
+void lq_revcomp(char *dst, const char *src, size_t n)
+{
+#if defined(LQ_HAVE_SSSE3)
+	if (n >= REVCOMP_BLOCK && __builtin_cpu_supports("ssse3")) {
+		revcomp_ssse3(dst, src, n);
+		return;
+	}
+#elif defined(LQ_HAVE_NEON)
+	if (n >= REVCOMP_BLOCK) {
+		revcomp_neon(dst, src, n);
+		return;
+	}
+#endif
+	revcomp_scalar(dst, src, n);
+}
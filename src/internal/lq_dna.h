@@ -0,0 +1,34 @@
+#ifndef LQ_DNA_H
+#define LQ_DNA_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+namespace liteseq
+{
+#endif
+
+/**
+ * Complement of a base. IUPAC codes map to their complement, case is kept and
+ * anything else maps to itself.
+ */
+char lq_complement(char base);
+
+/**
+ * Write the reverse complement of the n bytes at src to dst, the two must not
+ * overlap. Uses a shuffle based SIMD kernel when the CPU has one.
+ */
+void lq_revcomp(char *dst, const char *src, size_t n);
+
+#ifdef TESTING
+// the portable kernel the SIMD ones are checked against
+void lq_revcomp_scalar(char *dst, const char *src, size_t n);
+#endif
+
+#ifdef __cplusplus
+} // liteseq
+} // extern "C"
+#endif
+
+#endif /* LQ_DNA_H */
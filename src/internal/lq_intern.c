@@ -0,0 +1,161 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "./lq_arena.h"
+#include "./lq_intern.h"
+#include "./lq_utils.h"
+
+#define INTERN_INIT_CAP 64
+#define INTERN_STR_BLOCK_SIZE (64 * 1024)
+
+struct lq_intern *lq_intern_new(void)
+{
+	struct lq_intern *pool = malloc(sizeof(struct lq_intern));
+	if (!pool)
+		return NULL;
+
+	pool->arena = lq_arena_new(INTERN_STR_BLOCK_SIZE);
+	pool->strs = malloc(sizeof(const char *) * INTERN_INIT_CAP);
+	pool->hashes = malloc(sizeof(uint64_t) * INTERN_INIT_CAP);
+	// keep the load factor at or below a half
+	pool->slot_count = INTERN_INIT_CAP * 2;
+	pool->slots = malloc(sizeof(idx_t) * pool->slot_count);
+	pool->count = 0;
+	pool->cap = INTERN_INIT_CAP;
+	pthread_mutex_init(&pool->lock, NULL);
+
+	if (!pool->arena || !pool->strs || !pool->hashes || !pool->slots) {
+		lq_intern_destroy(&pool);
+		return NULL;
+	}
+
+	memset(pool->slots, 0xff, sizeof(idx_t) * pool->slot_count);
+
+	return pool;
+}
+
+void lq_intern_destroy(struct lq_intern **pool)
+{
+	if (pool == NULL || *pool == NULL)
+		return;
+
+	struct lq_intern *p = *pool;
+	lq_arena_destroy(&p->arena);
+	free(p->strs);
+	free(p->hashes);
+	free(p->slots);
+	pthread_mutex_destroy(&p->lock);
+
+	free(p);
+	*pool = NULL;
+}
+
+static idx_t find_slot(const struct lq_intern *pool, const char *s, size_t n,
+		       uint64_t h)
+{
+	idx_t mask = pool->slot_count - 1;
+	idx_t i = (idx_t)h & mask;
+	for (;; i = (i + 1) & mask) {
+		idx_t handle = pool->slots[i];
+		if (handle == NULL_IDX)
+			return i;
+
+		const char *c = pool->strs[handle];
+		if (pool->hashes[handle] == h && strncmp(c, s, n) == 0 &&
+		    c[n] == NULL_CHAR)
+			return i;
+	}
+}
+
+static status_t grow(struct lq_intern *pool)
+{
+	idx_t cap = pool->cap * 2;
+	const char **strs = realloc(pool->strs, sizeof(const char *) * cap);
+	if (!strs)
+		return ERROR_CODE_OUT_OF_MEMORY;
+	pool->strs = strs;
+
+	uint64_t *hashes = realloc(pool->hashes, sizeof(uint64_t) * cap);
+	if (!hashes)
+		return ERROR_CODE_OUT_OF_MEMORY;
+	pool->hashes = hashes;
+	pool->cap = cap;
+
+	idx_t slot_count = cap * 2;
+	idx_t *slots = malloc(sizeof(idx_t) * slot_count);
+	if (!slots)
+		return ERROR_CODE_OUT_OF_MEMORY;
+	memset(slots, 0xff, sizeof(idx_t) * slot_count);
+
+	idx_t mask = slot_count - 1;
+	for (idx_t handle = 0; handle < pool->count; handle++) {
+		idx_t i = (idx_t)pool->hashes[handle] & mask;
+		while (slots[i] != NULL_IDX)
+			i = (i + 1) & mask;
+		slots[i] = handle;
+	}
+
+	free(pool->slots);
+	pool->slots = slots;
+	pool->slot_count = slot_count;
+
+	return SUCCESS;
+}
+
+id_t lq_intern_str(struct lq_intern *pool, const char *s, size_t n,
+		   const char **str)
+{
+	uint64_t h = lq_hash_bytes(s, n);
+
+	pthread_mutex_lock(&pool->lock);
+
+	idx_t i = find_slot(pool, s, n, h);
+	id_t handle = pool->slots[i];
+	if (handle != NULL_IDX) {
+		if (str)
+			*str = pool->strs[handle];
+		pthread_mutex_unlock(&pool->lock);
+		return handle;
+	}
+
+	if (pool->count == pool->cap) {
+		if (grow(pool) != SUCCESS) {
+			pthread_mutex_unlock(&pool->lock);
+			return NULL_ID;
+		}
+		i = find_slot(pool, s, n, h);
+	}
+
+	char *c = lq_arena_strndup(pool->arena, s, n);
+	if (!c) {
+		pthread_mutex_unlock(&pool->lock);
+		return NULL_ID;
+	}
+
+	handle = pool->count++;
+	pool->strs[handle] = c;
+	pool->hashes[handle] = h;
+	pool->slots[i] = handle;
+	if (str)
+		*str = c;
+
+	pthread_mutex_unlock(&pool->lock);
+
+	return handle;
+}
+
+id_t lq_intern_find(const struct lq_intern *pool, const char *s, size_t n)
+{
+	if (!pool || !s)
+		return NULL_ID;
+
+	return pool->slots[find_slot(pool, s, n, lq_hash_bytes(s, n))];
+}
+
+const char *lq_intern_get(const struct lq_intern *pool, id_t handle)
+{
+	if (!pool || handle >= pool->count)
+		return NULL;
+
+	return pool->strs[handle];
+}
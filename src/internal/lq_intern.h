@@ -0,0 +1,63 @@
+#ifndef LQ_INTERN_H
+#define LQ_INTERN_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../include/liteseq/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+namespace liteseq
+{
+#endif
+
+struct lq_arena;
+
+/**
+ * A pool of interned strings.
+ *
+ * Each distinct string is stored once and is identified by a small integer
+ * handle, handles are dense and start at 0 in the order the strings were
+ * first seen. Interning is thread safe, lookups are only safe once no other
+ * thread is interning.
+ */
+struct lq_intern {
+	pthread_mutex_t lock;
+	struct lq_arena *arena; // the bytes of the strings
+
+	const char **strs; // handle -> string
+	uint64_t *hashes;  // handle -> hash of the string
+	idx_t count;	   // the number of strings in the pool
+	idx_t cap;	   // the capacity of strs and hashes
+
+	idx_t *slots;	  // open addressing table of handles
+	idx_t slot_count; // always a power of two
+};
+
+struct lq_intern *lq_intern_new(void);
+void lq_intern_destroy(struct lq_intern **pool);
+
+/**
+ * Returns the handle of the n bytes starting at s adding them to the pool if
+ * they are not already in it, or NULL_ID when out of memory.
+ * If str is not NULL it is set to the pooled copy of the string.
+ */
+id_t lq_intern_str(struct lq_intern *pool, const char *s, size_t n,
+		   const char **str);
+
+/**
+ * Returns the handle of the n bytes starting at s or NULL_ID when they are
+ * not in the pool
+ */
+id_t lq_intern_find(const struct lq_intern *pool, const char *s, size_t n);
+
+const char *lq_intern_get(const struct lq_intern *pool, id_t handle);
+
+#ifdef __cplusplus
+} // liteseq
+} // extern "C"
+#endif
+
+#endif /* LQ_INTERN_H */
@@ -1,3 +1,9 @@
+#if defined(__linux__)
+#define _GNU_SOURCE // pwrite and ftruncate
+#endif
+
+#include <errno.h>
+
 #include "./lq_io.h"
 
 /*
@@ -49,3 +55,44 @@ void close_mmap(char *mapped, size_t file_size)
 		exit(EXIT_FAILURE);
 	}
 }
+
+status_t lq_pwrite_all(int fd, const void *buf, size_t n, u64 offset)
+{
+	const char *p = buf;
+	while (n > 0) {
+		ssize_t written = pwrite(fd, p, n, (off_t)offset);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("Failed to write file");
+			return FAILURE;
+		}
+		p += written;
+		n -= (size_t)written;
+		offset += (u64)written;
+	}
+
+	return SUCCESS;
+}
+
+void lq_out_flush(struct lq_out_buf *o)
+{
+	if (o->used > 0 && o->status == SUCCESS)
+		o->status = lq_pwrite_all(o->fd, o->data, o->used, o->offset);
+	o->offset += o->used;
+	o->used = 0;
+}
+
+void lq_out_append(struct lq_out_buf *o, const char *s, size_t n)
+{
+	if (n > o->cap) { // too big to buffer
+		lq_out_flush(o);
+		if (o->status == SUCCESS)
+			o->status = lq_pwrite_all(o->fd, s, n, o->offset);
+		o->offset += n;
+		return;
+	}
+
+	memcpy(lq_out_reserve(o, n), s, n);
+	o->used += n;
+}
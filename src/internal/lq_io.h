@@ -22,4 +22,34 @@ void open_mmap(const char *file_path, char **mapped, size_t *file_size);
  */
 void close_mmap(char *mapped, size_t file_size);
 
+/**
+ * Write all n bytes of buf to fd at offset, retrying short writes
+ */
+status_t lq_pwrite_all(int fd, const void *buf, size_t n, u64 offset);
+
+/*
+ * A buffer of output that lands at a known offset of the file so that
+ * writers never need to coordinate
+ */
+struct lq_out_buf {
+	int fd;
+	char *data;
+	size_t used;
+	size_t cap;
+	u64 offset; // the file offset of data[0]
+	status_t status;
+};
+
+void lq_out_flush(struct lq_out_buf *o);
+
+// room for n <= cap bytes at the end of the buffer
+static inline char *lq_out_reserve(struct lq_out_buf *o, size_t n)
+{
+	if (o->used + n > o->cap)
+		lq_out_flush(o);
+	return o->data + o->used;
+}
+
+void lq_out_append(struct lq_out_buf *o, const char *s, size_t n);
+
 #endif /* LQ_IO_H */
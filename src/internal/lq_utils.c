@@ -1,11 +1,13 @@
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h> // sysconf
 
 #include <log.h>
-#include <math.h>
 
 #include "../../include/liteseq/types.h"
+#include "./lq_arena.h"
 #include "./lq_utils.h"
 
 uint8_t encodeBase(char base)
@@ -104,6 +106,7 @@ status_t split_str(struct split_str_params *p)
 	idx_t fallback_chars_count = p->fallback_chars_count;
 	idx_t max_tokens = p->max_splits;
 	char **all_tokens = p->tokens;
+	struct lq_arena *arena = p->arena;
 
 	idx_t tokens_found = 0;
 	int len = 0;
@@ -126,15 +129,12 @@ status_t split_str(struct split_str_params *p)
 		if (len <= 0)
 			break;
 
-		char *tok = malloc(sizeof(char) * len + 1);
+		char *tok = lq_strndup(arena, str, len);
 		if (tok == NULL) {
 			log_error("%s Memory allocation failed\n", fn);
 			return ERROR_CODE_FAILURE;
 		}
 
-		memcpy(tok, str, len);
-		tok[len] = '\0';
-
 		all_tokens[tokens_found++] = tok;
 
 		str += len + 1;
@@ -148,11 +148,146 @@ status_t split_str(struct split_str_params *p)
 	return SUCCESS;
 }
 
+static const u32 POW10[] = {
+	1,	 10,	   100,	      1000,	  10000,
+	100000,	 1000000,  10000000,  100000000, 1000000000,
+};
+
 idx_t count_digits(idx_t num)
 {
-	if (num == 0)
-		return 1;
-	return (idx_t)log10(num) + 1;
+	// floor(log10) from floor(log2), off by at most one which the table
+	// corrects. 1233 / 4096 is close to log10(2) and 0 counts as 1
+	num |= 1;
+	idx_t t = (idx_t)(32 - __builtin_clz(num)) * 1233 >> 12;
+	return t + (num >= POW10[t]);
+}
+
+static const char DIGIT_PAIRS[] = "00010203040506070809"
+				  "10111213141516171819"
+				  "20212223242526272829"
+				  "30313233343536373839"
+				  "40414243444546474849"
+				  "50515253545556575859"
+				  "60616263646566676869"
+				  "70717273747576777879"
+				  "80818283848586878889"
+				  "90919293949596979899";
+
+char *lq_u32_to_dec(char *out, u32 v)
+{
+	char *end = out + count_digits(v);
+	char *p = end;
+
+	// two digits at a time from the right
+	while (v >= 100) {
+		u32 pair = (v % 100) * 2;
+		v /= 100;
+		p -= 2;
+		memcpy(p, DIGIT_PAIRS + pair, 2);
+	}
+	if (v >= 10) {
+		p -= 2;
+		memcpy(p, DIGIT_PAIRS + v * 2, 2);
+	} else {
+		*--p = (char)('0' + v);
+	}
+
+	return end;
+}
+
+void *lq_memrchr(const void *s, int c, size_t n)
+{
+	const unsigned char *p = s;
+	while (n > 0) {
+		if (p[--n] == (unsigned char)c)
+			return (void *)(p + n);
+	}
+
+	return NULL;
+}
+
+u32 lq_thread_count(u32 requested)
+{
+	if (requested > 0)
+		return requested;
+
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (u32)n : 1;
+}
+
+status_t lq_run_threads(u32 n, void *(*fn)(void *), void *args,
+			size_t arg_size)
+{
+	pthread_t *threads = malloc(sizeof(pthread_t) * n);
+	if (!threads)
+		return ERROR_CODE_OUT_OF_MEMORY;
+
+	status_t res = SUCCESS;
+	u32 started = 0;
+	for (; started < n; started++) {
+		void *arg = (byte *)args + arg_size * started;
+		if (pthread_create(&threads[started], NULL, fn, arg) != 0) {
+			res = FAILURE;
+			break;
+		}
+	}
+
+	for (u32 i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+
+	free(threads);
+
+	return res;
+}
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+uint64_t lq_hash_bytes(const char *s, size_t n)
+{
+	uint64_t h = FNV_OFFSET_BASIS;
+	for (size_t i = 0; i < n; i++) {
+		h ^= (unsigned char)s[i];
+		h *= FNV_PRIME;
+	}
+
+	return h;
+}
+
+#define CHECKSUM_PRIME_1 0x9E3779B185EBCA87ULL
+#define CHECKSUM_PRIME_2 0xC2B2AE3D27D4EB4FULL
+
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t checksum_round(uint64_t lane, uint64_t word)
+{
+	return rotl64(lane + word * CHECKSUM_PRIME_2, 31) * CHECKSUM_PRIME_1;
+}
+
+uint64_t lq_checksum(const void *data, size_t n)
+{
+	const unsigned char *p = data;
+	uint64_t lanes[4] = {CHECKSUM_PRIME_1, CHECKSUM_PRIME_2, 0,
+			     -CHECKSUM_PRIME_1};
+
+	for (; n >= 32; n -= 32, p += 32) {
+		for (int l = 0; l < 4; l++) {
+			uint64_t word;
+			memcpy(&word, p + 8 * l, sizeof(word));
+			lanes[l] = checksum_round(lanes[l], word);
+		}
+	}
+
+	uint64_t h = rotl64(lanes[0], 1) + rotl64(lanes[1], 7) +
+		     rotl64(lanes[2], 12) + rotl64(lanes[3], 18);
+
+	// the tail
+	h ^= lq_hash_bytes((const char *)p, n);
+
+	return h;
 }
 
 void tokens_free(char **tokens, u32 N)
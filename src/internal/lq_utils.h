@@ -46,6 +46,15 @@ namespace liteseq
 #define unlikely(x) (x)
 #endif
 
+/**
+ * Hint that the cache line holding p is about to be read
+ */
+#ifdef __GNUC__
+#define prefetch(p) __builtin_prefetch((p), 0, 3)
+#else
+#define prefetch(p) UNUSED(p)
+#endif
+
 /**
  * Validates that the character is in the alphabet
  * if not it will print an error message and exit the program
@@ -63,6 +72,8 @@ bool in_alphabet(char c);
  */
 uint8_t encodeBase(char base);
 
+struct lq_arena;
+
 struct split_str_params {
 	// input, not mutated.
 	const char *str;	    // input string
@@ -77,13 +88,57 @@ struct split_str_params {
 	idx_t tokens_found; // output, number of tokens found, mutated
 	char **tokens;	    // output, only part changed by the function
 	const char *end;    // output, pointer to the end of the last token
+
+	// optional, if not NULL tokens are allocated from this arena and must
+	// not be freed by the caller
+	struct lq_arena *arena;
 };
 
+// the number of decimal digits of num
 idx_t count_digits(idx_t num);
+
+// a buffer that fits any u32 in decimal
+#define LQ_U32_DEC_MAX 10
+
+/**
+ * Write v in decimal to out without a terminator
+ *
+ * @return one past the last digit written
+ */
+char *lq_u32_to_dec(char *out, u32 v);
+
+// memrchr, which is not on every libc
+void *lq_memrchr(const void *s, int c, size_t n);
+
+/**
+ * The number of worker threads to use, requested if it is not 0 otherwise the
+ * number of online processors
+ */
+u32 lq_thread_count(u32 requested);
+
+/**
+ * Run fn on each of the n elements of args (each arg_size bytes) in its own
+ * thread and wait for all of them to finish
+ */
+status_t lq_run_threads(u32 n, void *(*fn)(void *), void *args,
+			size_t arg_size);
+
+/**
+ * 64 bit FNV-1a hash of the n bytes starting at s
+ */
+uint64_t lq_hash_bytes(const char *s, size_t n);
+
+/**
+ * 64 bit checksum of large buffers, four independent multiply-rotate lanes
+ * over 8 byte words so that it runs at memory speed
+ */
+uint64_t lq_checksum(const void *data, size_t n);
+
 void tokens_free(char **tokens, u32 N);
 /**
  * Tokenises a line into tokens based on a delimiter.
- * The tokens are allocated using malloc and should be freed by the caller.
+ * The tokens are allocated using malloc and should be freed by the caller
+ * unless an arena is passed in the params.
  * Returns the number of tokens found, or -1 on error.
  */
 status_t split_str(struct split_str_params *params);
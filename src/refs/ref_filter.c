@@ -0,0 +1,166 @@
+#include <string.h>
+
+#include "../../include/liteseq/refs.h"
+#include "../../include/liteseq/types.h"
+#include "../internal/lq_utils.h"
+
+#include "./ref_filter.h"
+
+#define P_LINE_NAME_COL 1
+
+// how PanSN fields are organised in a W line
+#define W_LINE_SAMPLE_COL 1
+#define W_LINE_HAP_ID_COL 2
+#define W_LINE_CONTIG_COL 3
+
+// the bounds of column col of the line, false when the line is shorter
+static bool find_col(const char *line, u32 len, idx_t col, const char **start,
+		     idx_t *col_len)
+{
+	const char *end = line + len;
+	const char *c = line;
+	for (idx_t i = 0; i < col; i++) {
+		c = memchr(c, TAB_CHAR, end - c);
+		if (!c)
+			return false;
+		c++;
+	}
+
+	const char *tab = memchr(c, TAB_CHAR, end - c);
+	*start = c;
+	*col_len = (idx_t)((tab ? tab : end) - c);
+
+	return true;
+}
+
+// the leading digits of s as a number like atol, 0 when there are none
+static id_t dec_prefix(const char *s, idx_t n)
+{
+	id_t v = 0;
+	for (idx_t i = 0; i < n && s[i] >= '0' && s[i] <= '9'; i++)
+		v = v * 10 + (id_t)(s[i] - '0');
+
+	return v;
+}
+
+/**
+ * Split a P line name in the same way as try_extract_pansn_from_str, the
+ * whole name is the sample when it is not PanSN
+ */
+static void split_p_name(const char *name, idx_t len, struct ref_names *out)
+{
+	out->name = name;
+	out->name_len = len;
+	out->sample = name;
+	out->sample_len = len;
+
+	const char *end = name + len;
+	const char *h = memchr(name, HASH_CHAR, len);
+	const char *cn = h ? memchr(h + 1, HASH_CHAR, end - h - 1) : NULL;
+	if (!cn)
+		return;
+	h++;
+	cn++;
+
+	idx_t sn_len = (idx_t)(h - name) - 1;
+	idx_t h_len = (idx_t)(cn - h) - 1;
+	idx_t cn_len = (idx_t)(end - cn);
+	if (sn_len == 0 || h_len == 0 || cn_len == 0 || h_len >= MAX_DIGITS ||
+	    memchr(cn, HASH_CHAR, cn_len) != NULL)
+		return;
+	for (idx_t i = 0; i < h_len; i++)
+		if (h[i] < '0' || h[i] > '9')
+			return;
+
+	out->sample_len = sn_len;
+	out->hap_id = dec_prefix(h, h_len);
+	out->contig = cn;
+	out->contig_len = cn_len;
+}
+
+static bool read_names(enum gfa_line_prefix prefix, const char *line, u32 len,
+		       struct ref_names *out)
+{
+	*out = (struct ref_names){.line_prefix = prefix, .hap_id = NULL_ID};
+
+	if (prefix == P_LINE) {
+		const char *name;
+		idx_t name_len;
+		if (!find_col(line, len, P_LINE_NAME_COL, &name, &name_len))
+			return false;
+		split_p_name(name, name_len, out);
+		return true;
+	}
+
+	const char *h;
+	idx_t h_len;
+	if (!find_col(line, len, W_LINE_SAMPLE_COL, &out->sample,
+		      &out->sample_len) ||
+	    !find_col(line, len, W_LINE_HAP_ID_COL, &h, &h_len) ||
+	    !find_col(line, len, W_LINE_CONTIG_COL, &out->contig,
+		      &out->contig_len))
+		return false;
+	out->hap_id = dec_prefix(h, h_len);
+
+	return true;
+}
+
+static bool name_eq(const char *want, const char *s, idx_t n)
+{
+	return s && strlen(want) == n && memcmp(want, s, n) == 0;
+}
+
+// match the next n chars of the tag at s against what is left of the prefix
+static bool prefix_step(const char **prefix, size_t *left, const char *s,
+			size_t n)
+{
+	size_t m = n < *left ? n : *left;
+	if (memcmp(*prefix, s, m) != 0)
+		return false;
+	*prefix += m;
+	*left -= m;
+
+	return true;
+}
+
+// the tag is the name of a P line or sample#hap_id#contig for a W line
+static bool tag_has_prefix(const struct ref_names *n, const char *prefix)
+{
+	size_t left = strlen(prefix);
+
+	if (n->line_prefix == P_LINE)
+		return left <= n->name_len &&
+		       memcmp(prefix, n->name, left) == 0;
+
+	char hap[LQ_U32_DEC_MAX];
+	size_t hap_len = (size_t)(lq_u32_to_dec(hap, n->hap_id) - hap);
+	const char hash = HASH_CHAR;
+
+	return prefix_step(&prefix, &left, n->sample, n->sample_len) &&
+	       prefix_step(&prefix, &left, &hash, 1) &&
+	       prefix_step(&prefix, &left, hap, hap_len) &&
+	       prefix_step(&prefix, &left, &hash, 1) &&
+	       prefix_step(&prefix, &left, n->contig, n->contig_len) &&
+	       left == 0;
+}
+
+bool ref_filter_keep(const struct ref_filter *filter,
+		     enum gfa_line_prefix prefix, const char *line, u32 len)
+{
+	struct ref_names n;
+	if (!filter || !read_names(prefix, line, len, &n))
+		return true;
+
+	if (filter->sample && !name_eq(filter->sample, n.sample, n.sample_len))
+		return false;
+	if (filter->contig && !name_eq(filter->contig, n.contig, n.contig_len))
+		return false;
+	if (filter->by_hap_id && n.hap_id != filter->hap_id)
+		return false;
+	if (filter->tag_prefix && !tag_has_prefix(&n, filter->tag_prefix))
+		return false;
+	if (filter->keep && !filter->keep(&n, filter->data))
+		return false;
+
+	return true;
+}
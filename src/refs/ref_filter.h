@@ -0,0 +1,28 @@
+#ifndef LQ_REF_FILTER_H
+#define LQ_REF_FILTER_H
+
+#include <stdbool.h>
+
+#include "../../include/liteseq/refs.h"
+#include "../../include/liteseq/types.h"
+
+#ifdef __cplusplus
+extern "C" { // Ensure the function has C linkage
+namespace liteseq
+{
+#endif
+
+/**
+ * Whether the P or W line of len chars at line passes filter, from a scan of
+ * its name columns alone. A NULL filter passes everything and so does a line
+ * too short to have names, which is left to the parser to reject.
+ */
+bool ref_filter_keep(const struct ref_filter *filter,
+		     enum gfa_line_prefix prefix, const char *line, u32 len);
+
+#ifdef __cplusplus
+} // namespace liteseq
+} // extern "C"
+#endif
+
+#endif // LQ_REF_FILTER_H
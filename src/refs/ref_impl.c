@@ -18,8 +18,13 @@
 
 #include "../../include/liteseq/refs.h"
 #include "../../include/liteseq/types.h"
+#include "../../src/internal/lq_arena.h"
 #include "../../src/internal/lq_utils.h"
 
+#include "../../src/gfa_load.h"
+#include "../../src/gfa_metrics.h"
+
+#include "./ref_filter.h"
 #include "./ref_impl.h"
 #include "./ref_name.h"
 #include "./ref_walk.h"
@@ -43,9 +48,10 @@
 #define PANSN_CONTIG_NAME_COL 3
 
 struct ref *alloc_ref(enum gfa_line_prefix line_prefix,
-		      struct ref_walk **r_walk, struct ref_id **id)
+		      struct ref_walk **r_walk, struct ref_id **id,
+		      struct lq_arena *arena)
 {
-	struct ref *r = malloc(sizeof(struct ref));
+	struct ref *r = lq_alloc(arena, sizeof(struct ref));
 	if (!r)
 		return NULL;
 
@@ -104,6 +110,22 @@ const char *get_contig_name(const struct ref *r)
 	return r->id->value.id_value->contig_name;
 }
 
+id_t get_sample_id(const struct ref *r)
+{
+	if (!r || get_ref_id_type(r) == REF_ID_RAW)
+		return NULL_ID;
+
+	return r->id->value.id_value->sample_id;
+}
+
+id_t get_contig_id(const struct ref *r)
+{
+	if (!r || get_ref_id_type(r) == REF_ID_RAW)
+		return NULL_ID;
+
+	return r->id->value.id_value->contig_id;
+}
+
 const char *get_sample_name(const struct ref *r)
 {
 	if (!r)
@@ -134,6 +156,16 @@ const enum strand *get_walk_strands(const struct ref *r)
 	return r->walk->strands;
 }
 
+const idx_t *get_walk_loci(const struct ref *r)
+{
+	return r->walk->loci;
+}
+
+idx_t get_first_step(const struct ref *r)
+{
+	return r->walk->first_step;
+}
+
 idx_t get_hap_len(const struct ref *r)
 {
 	return r->walk->hap_len;
@@ -228,11 +260,16 @@ const struct line_metadata *get_line_metadata(enum gfa_line_prefix prefix)
 	return NULL;
 }
 
-// Consolidated line parsing logic using metadata
-struct ref *parse_line_generic(const char *line, u32 len,
-			       const struct line_metadata *meta)
+static inline bool in_v_range(id_t v_id, id_t v_lo, id_t v_hi)
+{
+	return v_id - v_lo < v_hi - v_lo;
+}
+
+// split line into tokens, false when it has too few of them
+static bool split_ref_line(const char *line, u32 len,
+			   const struct line_metadata *meta,
+			   struct lq_arena *scratch, char **tokens)
 {
-	char *tokens[MAX_TOKENS] = {NULL};
 	struct split_str_params p = {
 		// input
 		.str = line,
@@ -245,37 +282,29 @@ struct ref *parse_line_generic(const char *line, u32 len,
 		// output
 		.tokens_found = 0,
 		.tokens = tokens,
+		.arena = scratch,
 	};
 
-	status_t s = split_str(&p);
+	split_str(&p);
 	if (p.tokens_found < meta->required_tokens) {
 		log_fatal("Failed to split %d-line. Found %u tokens.",
 			  p.delimiter, p.tokens_found);
-		return NULL;
-	}
-
-	// Extract ID tokens
-	char *id_tokens[meta->id_token_count];
-	for (idx_t i = 0; i < meta->id_token_count; i++) {
-		id_tokens[i] = tokens[meta->id_token_indices[i]];
+		return false;
 	}
 
-	const char **tok = (const char **)id_tokens;
-	struct ref_id *r_id = alloc_ref_id(tok, meta->id_token_count);
-	if (!r_id) {
-		log_fatal("Failed to allocate ref_id for %d-line.",
-			  meta->line_prefix);
-		return NULL;
-	}
+	return true;
+}
 
-	// Parse the data string
+static struct ref_walk *parse_walk_col(char **tokens,
+				       const struct line_metadata *meta,
+				       struct lq_arena *arena)
+{
 	const char *data_str = tokens[meta->data_col_index];
 	idx_t step_count = count_steps(meta->line_prefix, data_str);
-	struct ref_walk *w = alloc_ref_walk(step_count);
+	struct ref_walk *w = alloc_ref_walk(step_count, arena);
 	if (!w) {
 		log_fatal("Failed to allocate walk for %d-line.",
 			  meta->line_prefix);
-		destroy_ref_id(&r_id);
 		exit(1);
 	}
 
@@ -286,30 +315,237 @@ struct ref *parse_line_generic(const char *line, u32 len,
 		return NULL;
 	}
 
+	return w;
+}
+
+static struct ref_id *parse_id_cols(char **tokens,
+				    const struct line_metadata *meta,
+				    struct lq_arena *arena,
+				    struct lq_intern *names)
+{
+	char *id_tokens[meta->id_token_count];
+	for (idx_t i = 0; i < meta->id_token_count; i++) {
+		id_tokens[i] = tokens[meta->id_token_indices[i]];
+	}
+
+	const char **tok = (const char **)id_tokens;
+	struct ref_id *r_id =
+		alloc_ref_id(tok, meta->id_token_count, arena, names);
+	if (!r_id)
+		log_fatal("Failed to allocate ref_id for %d-line.",
+			  meta->line_prefix);
+
+	return r_id;
+}
+
+static void free_tokens(char **tokens, struct lq_arena *scratch)
+{
+	if (scratch) {
+		lq_arena_reset(scratch);
+		return;
+	}
+
 	for (size_t i = 0; i < MAX_TOKENS; i++) {
 		if (tokens[i] != NULL)
 			free(tokens[i]);
 		tokens[i] = NULL;
 	}
-	/* struct ref_walk *w = alloc_ref_walk(0); */
+}
+
+// Consolidated line parsing logic using metadata
+// when arena is not NULL the ref is allocated from it and when scratch is not
+// NULL the tokens are, scratch is reset before returning.
+// PanSN names are interned in names when it is not NULL.
+static struct ref *parse_line_generic(const char *line, u32 len,
+				      const struct line_metadata *meta,
+				      struct lq_arena *arena,
+				      struct lq_arena *scratch,
+				      struct lq_intern *names)
+{
+	char *tokens[MAX_TOKENS] = {NULL};
+	if (!split_ref_line(line, len, meta, scratch, tokens))
+		return NULL;
+
+	struct ref_walk *w = parse_walk_col(tokens, meta, arena);
+	if (!w)
+		return NULL;
+
+	struct ref_id *r_id = parse_id_cols(tokens, meta, arena, names);
+	if (!r_id) {
+		if (!arena)
+			destroy_ref_walk(&w);
+		return NULL;
+	}
+
+	free_tokens(tokens, scratch);
 
-	return alloc_ref(meta->line_prefix, &w, &r_id);
+	return alloc_ref(meta->line_prefix, &w, &r_id, arena);
 }
 
-struct ref *parse_ref_line(enum gfa_line_prefix prefix, const char *line,
-			   u32 len)
+// the maximal runs of steps of w through a vertex in [v_lo, v_hi)
+static idx_t count_runs(const struct ref_walk *w, id_t v_lo, id_t v_hi)
+{
+	idx_t runs = 0;
+	bool in = false;
+	for (idx_t i = 0; i < w->step_count; i++) {
+		bool next = in_v_range(w->v_ids[i], v_lo, v_hi);
+		runs += next && !in;
+		in = next;
+	}
+
+	return runs;
+}
+
+// make room in out for n more refs
+static status_t reserve_refs(struct ref_vec *out, idx_t n)
+{
+	if (out->count + n <= out->cap)
+		return SUCCESS;
+
+	idx_t cap = out->cap * 2 > out->count + n ? out->cap * 2
+						  : out->count + n;
+	struct ref **refs = realloc(out->refs, sizeof(struct ref *) * cap);
+	if (!refs)
+		return ERROR_CODE_OUT_OF_MEMORY;
+	out->refs = refs;
+	out->cap = cap;
+
+	return SUCCESS;
+}
+
+/**
+ * Copy each run of steps of w through a vertex in [v_lo, v_hi) to a ref of
+ * its own from arena in out, which has room for them
+ *
+ * @return the number of refs added
+ */
+static idx_t add_runs(const struct ref_walk *w, enum gfa_line_prefix prefix,
+		      struct ref_id *r_id, id_t v_lo, id_t v_hi,
+		      struct lq_arena *arena, struct ref_vec *out)
+{
+	idx_t added = 0;
+	for (idx_t i = 0; i < w->step_count;) {
+		if (!in_v_range(w->v_ids[i], v_lo, v_hi)) {
+			i++;
+			continue;
+		}
+
+		idx_t end = i + 1;
+		while (end < w->step_count &&
+		       in_v_range(w->v_ids[end], v_lo, v_hi))
+			end++;
+
+		idx_t n = end - i;
+		struct ref_walk *c = alloc_ref_walk(n, arena);
+		if (!c)
+			return added;
+		memcpy(c->v_ids, w->v_ids + i, sizeof(id_t) * n);
+		memcpy(c->strands, w->strands + i, sizeof(enum strand) * n);
+		c->first_step = i;
+
+		struct ref_id *id = r_id; // the runs share the id
+		struct ref *r = alloc_ref(prefix, &c, &id, arena);
+		if (!r)
+			return added;
+		out->refs[out->count++] = r;
+		added++;
+		i = end;
+	}
+
+	return added;
+}
+
+idx_t parse_ref_line_clipped(enum gfa_line_prefix prefix, const char *line,
+			     u32 len, struct lq_arena *arena,
+			     struct lq_arena *scratch, struct lq_intern *names,
+			     id_t v_lo, id_t v_hi, struct ref_vec *out)
+{
+	if (prefix != P_LINE && prefix != W_LINE) {
+		log_error("Unsupported line prefix %d", prefix);
+		return 0;
+	}
+	const struct line_metadata *meta = &metadata[prefix];
+
+	char *tokens[MAX_TOKENS] = {NULL};
+	if (!split_ref_line(line, len, meta, scratch, tokens)) {
+		lq_arena_reset(scratch);
+		return 0;
+	}
+
+	// the walk before the id so that a walk that is cut away entirely
+	// leaves no names behind
+	struct ref_walk *w = parse_walk_col(tokens, meta, scratch);
+	idx_t runs = w ? count_runs(w, v_lo, v_hi) : 0;
+	struct ref_id *r_id =
+		runs ? parse_id_cols(tokens, meta, arena, names) : NULL;
+
+	idx_t added = 0;
+	if (r_id && reserve_refs(out, runs) == SUCCESS)
+		added = add_runs(w, prefix, r_id, v_lo, v_hi, arena, out);
+	else if (r_id)
+		log_fatal("Could not grow the refs for %d-line", prefix);
+	lq_arena_reset(scratch);
+
+	return added;
+}
+
+struct ref *parse_ref_line_arena(enum gfa_line_prefix prefix, const char *line,
+				 u32 len, struct lq_arena *arena,
+				 struct lq_arena *scratch,
+				 struct lq_intern *names)
 {
 	switch (prefix) {
 	case (P_LINE):
-		return parse_line_generic(line, len, &metadata[P_LINE]);
+		return parse_line_generic(line, len, &metadata[P_LINE], arena,
+					  scratch, names);
 	case (W_LINE):
-		return parse_line_generic(line, len, &metadata[W_LINE]);
+		return parse_line_generic(line, len, &metadata[W_LINE], arena,
+					  scratch, names);
 	default:
 		log_error("%s Unsupported line prefix.");
 		return NULL;
 	}
 }
 
+struct ref *parse_ref_line(enum gfa_line_prefix prefix, const char *line,
+			   u32 len)
+{
+	return parse_ref_line_arena(prefix, line, len, NULL, NULL, NULL);
+}
+
+// publish the lines handled so far now and then, true once the load is
+// cancelled
+static bool ref_load_stop(struct gfa_load_state *load, idx_t lines_done)
+{
+	if (!load || lines_done % GFA_LOAD_CHECK_LINES != 0)
+		return false;
+	gfa_load_publish(&load->progress.refs_parsed, lines_done);
+
+	return gfa_load_cancelled(load);
+}
+
+static inline bool clips_walks(const struct ref_thread_data *data)
+{
+	return data->v_lo != 0 || data->v_hi != NULL_ID;
+}
+
+// parse l into out, a partial load adds a ref for each run of its walk in
+// range and none when the walk never steps into it
+static void add_ref(const struct ref_thread_data *data,
+		    enum gfa_line_prefix prefix, const line *l,
+		    struct lq_arena *scratch, struct ref_vec *out)
+{
+	if (clips_walks(data)) {
+		parse_ref_line_clipped(prefix, l->start, l->len, data->arena,
+				       scratch, data->names, data->v_lo,
+				       data->v_hi, out);
+		return;
+	}
+
+	out->refs[out->count++] = parse_ref_line_arena(
+		prefix, l->start, l->len, data->arena, scratch, data->names);
+}
+
 /**
  * @brief a wrapper function for handle_p_lines
  */
@@ -320,16 +556,68 @@ void *t_handle_p(void *ref_metadata)
 	line *wl = data->w_lines;
 	idx_t p_line_count = data->p_line_count;
 	idx_t w_line_count = data->w_line_count;
-	struct ref **refs = data->refs;
-	idx_t ref_idx = 0;
+	struct lq_arena *arena = data->arena;
+	struct lq_intern *names = data->names;
+	struct ref_vec out = {
+		.refs = *data->refs,
+		.count = data->first_ref,
+		.cap = data->first_ref + p_line_count + w_line_count,
+	};
+
+	struct gfa_metrics_clock clock;
+	gfa_metrics_start(&clock, data->metrics, arena, 0);
+	gfa_metrics_lines(&clock, pl, p_line_count);
+	gfa_metrics_lines(&clock, wl, w_line_count);
+
+	struct lq_arena *scratch = lq_arena_new(LQ_ARENA_BLOCK_SIZE);
+	if (scratch == NULL) {
+		log_fatal("Could not allocate scratch arena for refs");
+		return NULL;
+	}
 
-	for (idx_t i = 0; i < p_line_count; i++)
-		refs[ref_idx++] =
-			parse_ref_line(P_LINE, pl[i].start, pl[i].len);
+	// the lines the filter rejects are never tokenized
+	const struct ref_filter *filter = data->filter;
+	struct gfa_load_state *load = data->load;
+	for (idx_t i = 0; i < p_line_count; i++) {
+		if (ref_load_stop(load, i))
+			break;
+		if (!ref_filter_keep(filter, P_LINE, pl[i].start, pl[i].len))
+			continue;
+		add_ref(data, P_LINE, &pl[i], scratch, &out);
+	}
+
+	for (idx_t i = 0; i < w_line_count; i++) {
+		if (ref_load_stop(load, p_line_count + i))
+			break;
+		if (!ref_filter_keep(filter, W_LINE, wl[i].start, wl[i].len))
+			continue;
+		add_ref(data, W_LINE, &wl[i], scratch, &out);
+	}
+
+	lq_arena_destroy(&scratch);
+	*data->refs = out.refs; // which the runs may have moved
+	if (gfa_load_cancelled(load))
+		return NULL;
+	if (data->ref_count)
+		*data->ref_count = out.count - data->first_ref;
+	if (load)
+		gfa_load_publish(&load->progress.refs_parsed,
+				 p_line_count + w_line_count);
+
+	// the caller indexes the refs itself
+	if (data->lookup == NULL) {
+		gfa_metrics_stop(&clock);
+		return NULL;
+	}
 
-	for (idx_t i = 0; i < w_line_count; i++)
-		refs[ref_idx++] =
-			parse_ref_line(W_LINE, wl[i].start, wl[i].len);
+	// index the refs while the S and L lines may still be parsing
+	idx_t name_count = names ? names->count : 0;
+	*data->lookup =
+		build_ref_lookup(out.refs, out.count, name_count, arena);
+	if (*data->lookup == NULL)
+		log_error("Could not build the ref lookup");
+	gfa_metrics_stop(&clock);
+	gfa_phase_done(load, GFA_PHASE_REFS);
 
 	return NULL;
 }
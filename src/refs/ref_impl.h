@@ -6,6 +6,9 @@
 #include "../../include/liteseq/refs.h"
 #include "../../include/liteseq/types.h"
 #include "../include/liteseq/gfa.h"
+#include "../internal/lq_arena.h"
+#include "../internal/lq_intern.h"
+#include "./ref_lookup.h"
 
 #ifdef __cplusplus
 extern "C" { // Ensure the function has C linkage
@@ -16,21 +19,66 @@ namespace liteseq
 #define P_LINE_ID_TOKEN_COUNT 1
 #define W_LINE_ID_TOKEN_COUNT 3
 
-struct ref_thread_data {
+// refs[0, count) of an array with room for cap refs, grown with realloc
+struct ref_vec {
 	struct ref **refs;
+	idx_t count;
+	idx_t cap;
+};
+
+struct ref_thread_data {
+	struct lq_arena *arena;	 // backs the refs
+	struct lq_intern *names; // the PanSN sample and contig names
+	// the refs go in (*refs)[first_ref, ...), which has room for one per
+	// line and is grown when a partial load splits a walk into runs
+	struct ref ***refs;
+	idx_t first_ref;
+	struct ref_lookup **lookup; // set once all the refs are parsed or NULL
 	line *p_lines; // metadata for a P line
 	line *w_lines; // metadata for a W line
 	idx_t p_line_count;
 	idx_t w_line_count;
+	const struct ref_filter *filter; // the lines to parse, NULL for all
+	// the walks are split into runs in the vertex ids [v_lo, v_hi) as in a
+	// partial load, 0 and NULL_ID for whole walks
+	id_t v_lo;
+	id_t v_hi;
+	idx_t *ref_count; // if not NULL set to the number of refs parsed
+	struct gfa_load_state *load; // NULL unless run by gfa_new_async
+	struct gfa_phase_metrics *metrics; // NULL unless recorded
 };
 
 void *t_handle_p(void *ref_metadata);
 
+/**
+ * Like parse_ref_line but the ref is allocated from arena, the tokens from
+ * scratch and PanSN names are interned in names. Any of them may be NULL in
+ * which case malloc is used.
+ */
+struct ref *parse_ref_line_arena(enum gfa_line_prefix prefix, const char *line,
+				 u32 len, struct lq_arena *arena,
+				 struct lq_arena *scratch,
+				 struct lq_intern *names);
+
+/**
+ * Like parse_ref_line_arena but the walk is split into its maximal runs of
+ * steps through a vertex in [v_lo, v_hi), each added to out as a ref of its
+ * own that shares the id of the line. The whole walk is parsed in scratch so
+ * that arena only holds the steps kept, neither may be NULL.
+ *
+ * @return the number of refs added, 0 when no step is in range or on error
+ */
+idx_t parse_ref_line_clipped(enum gfa_line_prefix prefix, const char *line,
+			     u32 len, struct lq_arena *arena,
+			     struct lq_arena *scratch, struct lq_intern *names,
+			     id_t v_lo, id_t v_hi, struct ref_vec *out);
+
 // fns I want to expose only for testing
 #ifdef TESTING
 
 struct ref *alloc_ref(enum gfa_line_prefix line_prefix,
-		      struct ref_walk **r_walk, struct ref_id **id);
+		      struct ref_walk **r_walk, struct ref_id **id,
+		      struct lq_arena *arena);
 
 /**
  * Function to retrieve metadata for a given line prefix.
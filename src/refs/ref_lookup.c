@@ -0,0 +1,152 @@
+#include <string.h>
+
+#include "../../include/liteseq/refs.h"
+#include "../../include/liteseq/types.h"
+#include "../internal/lq_arena.h"
+#include "../internal/lq_utils.h"
+
+#include "./ref_lookup.h"
+
+static inline bool is_pansn(const struct ref *r)
+{
+	return r && get_ref_id_type(r) == REF_ID_PANSN &&
+	       get_sample_id(r) != NULL_ID;
+}
+
+static inline uint64_t hash_pansn(id_t sample_id, id_t hap_id, id_t contig_id)
+{
+	id_t key[3] = {sample_id, hap_id, contig_id};
+	return lq_hash_bytes((const char *)key, sizeof(key));
+}
+
+static inline bool pansn_eq(const struct ref *r, id_t sample_id, id_t hap_id,
+			    id_t contig_id)
+{
+	return get_sample_id(r) == sample_id && get_hap_id(r) == hap_id &&
+	       get_contig_id(r) == contig_id;
+}
+
+/**
+ * Fill offsets and list with the refs of each name, key returns the name of a
+ * ref or NULL_ID when it has none
+ */
+static void fill_csr(struct ref *const *refs, idx_t ref_count,
+		     idx_t name_count, id_t (*key)(const struct ref *),
+		     idx_t *offsets, idx_t *list)
+{
+	memset(offsets, 0, sizeof(idx_t) * (name_count + 1));
+	for (idx_t i = 0; i < ref_count; i++)
+		if (is_pansn(refs[i]))
+			offsets[key(refs[i]) + 1]++;
+
+	for (idx_t n = 0; n < name_count; n++)
+		offsets[n + 1] += offsets[n];
+
+	// offsets[n] is the cursor of n while filling, after which it is the
+	// end of n i.e. the start of n + 1 so shift it back by one
+	for (idx_t i = 0; i < ref_count; i++)
+		if (is_pansn(refs[i]))
+			list[offsets[key(refs[i])]++] = i;
+
+	memmove(offsets + 1, offsets, sizeof(idx_t) * name_count);
+	offsets[0] = 0;
+}
+
+struct ref_lookup *build_ref_lookup(struct ref *const *refs, idx_t ref_count,
+				    idx_t name_count, struct lq_arena *arena)
+{
+	struct ref_lookup *l = lq_arena_alloc(arena, sizeof(struct ref_lookup));
+	if (!l)
+		return NULL;
+
+	// keep the load factor at or below a half
+	idx_t slot_count = 2;
+	while (slot_count < ref_count * 2)
+		slot_count *= 2;
+
+	l->slot_count = slot_count;
+	l->name_count = name_count;
+	l->tag_hashes = lq_arena_alloc(arena, sizeof(uint64_t) * ref_count);
+	l->tag_slots = lq_arena_alloc(arena, sizeof(idx_t) * slot_count);
+	l->pansn_slots = lq_arena_alloc(arena, sizeof(idx_t) * slot_count);
+	l->sample_offsets =
+		lq_arena_alloc(arena, sizeof(idx_t) * (name_count + 1));
+	l->contig_offsets =
+		lq_arena_alloc(arena, sizeof(idx_t) * (name_count + 1));
+	l->sample_refs = lq_arena_alloc(arena, sizeof(idx_t) * ref_count);
+	l->contig_refs = lq_arena_alloc(arena, sizeof(idx_t) * ref_count);
+	if (!l->tag_hashes || !l->tag_slots || !l->pansn_slots ||
+	    !l->sample_offsets || !l->contig_offsets || !l->sample_refs ||
+	    !l->contig_refs)
+		return NULL;
+
+	memset(l->tag_slots, 0xff, sizeof(idx_t) * slot_count);
+	memset(l->pansn_slots, 0xff, sizeof(idx_t) * slot_count);
+
+	idx_t mask = slot_count - 1;
+	for (idx_t i = 0; i < ref_count; i++) {
+		const struct ref *r = refs[i];
+		if (!r || !get_tag(r))
+			continue;
+
+		const char *tag = get_tag(r);
+		uint64_t h = lq_hash_bytes(tag, strlen(tag));
+		l->tag_hashes[i] = h;
+
+		idx_t s = (idx_t)h & mask;
+		while (l->tag_slots[s] != NULL_IDX &&
+		       strcmp(get_tag(refs[l->tag_slots[s]]), tag) != 0)
+			s = (s + 1) & mask;
+		if (l->tag_slots[s] == NULL_IDX)
+			l->tag_slots[s] = i;
+
+		if (!is_pansn(r))
+			continue;
+
+		id_t sample_id = get_sample_id(r);
+		id_t hap_id = get_hap_id(r);
+		id_t contig_id = get_contig_id(r);
+		s = (idx_t)hash_pansn(sample_id, hap_id, contig_id) & mask;
+		while (l->pansn_slots[s] != NULL_IDX &&
+		       !pansn_eq(refs[l->pansn_slots[s]], sample_id, hap_id,
+				 contig_id))
+			s = (s + 1) & mask;
+		if (l->pansn_slots[s] == NULL_IDX)
+			l->pansn_slots[s] = i;
+	}
+
+	fill_csr(refs, ref_count, name_count, get_sample_id, l->sample_offsets,
+		 l->sample_refs);
+	fill_csr(refs, ref_count, name_count, get_contig_id, l->contig_offsets,
+		 l->contig_refs);
+
+	return l;
+}
+
+idx_t ref_lookup_tag(const struct ref_lookup *l, struct ref *const *refs,
+		     const char *tag)
+{
+	uint64_t h = lq_hash_bytes(tag, strlen(tag));
+	idx_t mask = l->slot_count - 1;
+	for (idx_t s = (idx_t)h & mask;; s = (s + 1) & mask) {
+		idx_t i = l->tag_slots[s];
+		if (i == NULL_IDX)
+			return NULL_IDX;
+		if (l->tag_hashes[i] == h && strcmp(get_tag(refs[i]), tag) == 0)
+			return i;
+	}
+}
+
+idx_t ref_lookup_pansn(const struct ref_lookup *l, struct ref *const *refs,
+		       id_t sample_id, id_t hap_id, id_t contig_id)
+{
+	uint64_t h = hash_pansn(sample_id, hap_id, contig_id);
+	idx_t mask = l->slot_count - 1;
+	for (idx_t s = (idx_t)h & mask;; s = (s + 1) & mask) {
+		idx_t i = l->pansn_slots[s];
+		if (i == NULL_IDX)
+			return NULL_IDX;
+		if (pansn_eq(refs[i], sample_id, hap_id, contig_id))
+			return i;
+	}
+}
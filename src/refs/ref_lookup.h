@@ -0,0 +1,54 @@
+#ifndef LQ_REF_LOOKUP_H
+#define LQ_REF_LOOKUP_H
+
+#include "../../include/liteseq/refs.h"
+#include "../../include/liteseq/types.h"
+#include "../internal/lq_arena.h"
+
+#ifdef __cplusplus
+extern "C" { // Ensure the function has C linkage
+namespace liteseq
+{
+#endif
+
+/**
+ * Hash index over the refs of a graph.
+ *
+ * Refs are found by their full tag or by their PanSN fields through open
+ * addressing tables of ref indices. The refs of each sample and of each contig
+ * are kept in CSR form keyed by the handles of the names, which come from the
+ * same pool so each of the two lists is only filled for one kind of name.
+ */
+struct ref_lookup {
+	uint64_t *tag_hashes; // ref_idx -> hash of the tag
+	idx_t *tag_slots;
+	idx_t *pansn_slots;
+	idx_t slot_count; // of each table, always a power of two
+
+	idx_t name_count;      // the number of names in the pool
+	idx_t *sample_offsets; // name_count + 1 entries
+	idx_t *sample_refs;
+	idx_t *contig_offsets; // name_count + 1 entries
+	idx_t *contig_refs;
+};
+
+/**
+ * Build the lookup of the ref_count refs in refs whose PanSN names were
+ * interned in a pool of name_count names. Everything is allocated from arena.
+ * NULL refs are skipped, on a duplicate tag or PanSN triple the first ref wins.
+ */
+struct ref_lookup *build_ref_lookup(struct ref *const *refs, idx_t ref_count,
+				    idx_t name_count, struct lq_arena *arena);
+
+idx_t ref_lookup_tag(const struct ref_lookup *l, struct ref *const *refs,
+		     const char *tag);
+
+idx_t ref_lookup_pansn(const struct ref_lookup *l, struct ref *const *refs,
+		       id_t sample_id, id_t hap_id, id_t contig_id);
+
+#ifdef __cplusplus
+} // namespace liteseq
+} // extern "C"
+#endif
+
+#endif // LQ_REF_LOOKUP_H
@@ -16,13 +16,14 @@
 #include <string.h> // for strlen
 
 #include "../../include/liteseq/refs.h"
+#include "../internal/lq_arena.h"
+#include "../internal/lq_intern.h"
 #include "../internal/lq_utils.h"
 
 const char DELIM = HASH_CHAR;
 
 /* Define constants globally or within the file */
 #define PANSN_MAX_TOKENS 3
-#define PANSN_PARSER_BUF_SIZE PANSN_MAX_TOKENS + 1
 
 // how PanSN fields are organised in a the tokens passed to alloc_pansn
 // different from the ones in the W line which are offset +1
@@ -35,13 +36,14 @@ void destroy_pansn(struct pansn **pn)
 	if (pn == NULL || *pn == NULL)
 		return;
 
-	if ((*pn)->sample_name != NULL) {
-		free((*pn)->sample_name);
+	// interned names belong to the pool
+	if ((*pn)->sample_name != NULL && (*pn)->sample_id == NULL_ID) {
+		free((char *)(*pn)->sample_name);
 		(*pn)->sample_name = NULL;
 	}
 
-	if ((*pn)->contig_name != NULL) {
-		free((*pn)->contig_name);
+	if ((*pn)->contig_name != NULL && (*pn)->contig_id == NULL_ID) {
+		free((char *)(*pn)->contig_name);
 		(*pn)->contig_name = NULL;
 	}
 
@@ -51,42 +53,69 @@ void destroy_pansn(struct pansn **pn)
 	}
 }
 
-struct pansn *alloc_pansn(const char *tokens[PANSN_MAX_TOKENS])
+/**
+ * The sample and contig names need not be null terminated.
+ * When names is not NULL they are interned in it otherwise they are copied.
+ */
+static struct pansn *make_pansn(const char *sn, size_t sn_len, id_t hap_id,
+				const char *cn, size_t cn_len,
+				struct lq_arena *arena,
+				struct lq_intern *names)
 {
-	struct pansn *pn = malloc(sizeof(struct pansn));
+	struct pansn *pn = lq_alloc(arena, sizeof(struct pansn));
 	if (!pn)
 		return NULL;
 
+	pn->hap_id = hap_id;
+	pn->sample_name = NULL;
+	pn->contig_name = NULL;
+	pn->sample_id = NULL_ID;
+	pn->contig_id = NULL_ID;
+
+	if (names) {
+		pn->sample_id =
+			lq_intern_str(names, sn, sn_len, &pn->sample_name);
+		pn->contig_id =
+			lq_intern_str(names, cn, cn_len, &pn->contig_name);
+	} else {
+		pn->sample_name = lq_strndup(arena, sn, sn_len);
+		pn->contig_name = lq_strndup(arena, cn, cn_len);
+	}
+
+	if (!pn->sample_name || !pn->contig_name) {
+		if (!arena)
+			destroy_pansn(&pn);
+		return NULL;
+	}
+
+	return pn;
+}
+
+struct pansn *alloc_pansn(const char *tokens[PANSN_MAX_TOKENS],
+			  struct lq_arena *arena, struct lq_intern *names)
+{
 	const char *sn = tokens[PANSN_SAMPLE_COL];
 	const char *h = tokens[PANSN_HAP_ID_COL];
 	const char *cn = tokens[PANSN_CONTIG_NAME_COL];
 
-	pn->sample_name = sn ? strdup(sn) : NULL;
-	pn->hap_id = h ? atol(h) : NULL_ID;
-	pn->contig_name = cn ? strdup(cn) : NULL;
-
-	if (!pn->sample_name || !pn->contig_name || pn->hap_id == NULL_ID) {
-		destroy_pansn(&pn);
+	if (!sn || !h || !cn)
 		return NULL;
-	}
 
-	return pn;
+	return make_pansn(sn, strlen(sn), atol(h), cn, strlen(cn), arena,
+			  names);
 }
 
-char *alloc_pansn_tag(const struct pansn *pn)
+char *alloc_pansn_tag(const struct pansn *pn, struct lq_arena *arena)
 {
 	// idx_t hap_id_len = (idx_t)log10(pn->hap_id);
 	idx_t hap_id_len = count_digits(pn->hap_id);
 
-	char hap_id_str[MAX_DIGITS];
-	snprintf(hap_id_str, sizeof hap_id_str, "%u", pn->hap_id);
-
 	size_t need =
 		strlen(pn->sample_name) + hap_id_len + strlen(pn->contig_name);
 	need += 2; // +2 for the two '#' characters
 	need += 1; // +1 for the null terminator
 
-	char *tag = (char *)malloc(need);
+	char *tag = (char *)lq_alloc(arena, need);
 	if (!tag)
 		return NULL;
 
@@ -95,106 +124,96 @@ char *alloc_pansn_tag(const struct pansn *pn)
 	return tag;
 }
 
-struct pansn *free_pansn_buf(char **out_tokens)
+/*
+ * used for PanSN in P lines
+ * The name is split in place, only the sample and contig names are copied (or
+ * interned).
+ */
+struct pansn *try_extract_pansn_from_str(const char *name, const char delim,
+					 struct lq_arena *arena,
+					 struct lq_intern *names)
 {
-	for (idx_t i = 0; i < PANSN_MAX_TOKENS; i++) {
-		if (out_tokens[i] != NULL) {
-			free(out_tokens[i]);
-			out_tokens[i] = NULL;
-		}
-	}
-	return NULL;
-}
+	const char *h = strchr(name, delim);
+	if (h == NULL)
+		return NULL;
+	h++; // skip the delimiter
 
-/* used for PanSN in P lines */
-struct pansn *try_extract_pansn_from_str(const char *name, const char delim)
-{
-	char *out_tokens[PANSN_MAX_TOKENS] = {NULL};
-	struct split_str_params p = {
-		// input
-		.str = name,
-		.up_to = NULL,
-		.delimiter = delim,
-		.max_splits = PANSN_MAX_TOKENS,
-		.fallbacks = (const char[]){NEWLINE, NULL_CHAR},
-		.fallback_chars_count = 2,
-		// output
-		.tokens_found = 0,
-		.tokens = out_tokens,
-	};
-	status_t res = split_str(&p);
-	if (res != SUCCESS)
-		return free_pansn_buf(out_tokens);
-
-	if (p.tokens_found != PANSN_MAX_TOKENS) {
-		return free_pansn_buf(out_tokens);
-	}
+	const char *cn = strchr(h, delim);
+	if (cn == NULL)
+		return NULL;
+	cn++; // skip the delimiter
 
-	idx_t offset = 0;
-	int sample_idx = PANSN_SAMPLE_COL - offset;
-	int contig_idx = PANSN_CONTIG_NAME_COL - offset;
-	int hap_id_idx = PANSN_HAP_ID_COL - offset;
+	size_t sn_len = (size_t)(h - name) - 1;
+	size_t h_len = (size_t)(cn - h) - 1;
+	size_t cn_len = strcspn(cn, (const char[]){NEWLINE, NULL_CHAR});
 
-	for (int i = 0; i < PANSN_MAX_TOKENS; i++) {
-		if (strlen(out_tokens[i]) == 0) {
-			return free_pansn_buf(out_tokens);
-		}
-	}
-
-	char *endptr;
+	if (sn_len == 0 || h_len == 0 || cn_len == 0 || h_len >= MAX_DIGITS)
+		return NULL;
 
-	strtoul(out_tokens[hap_id_idx], &endptr, 10);
-	if (*endptr != NULL_CHAR) {
-		return free_pansn_buf(out_tokens);
-	}
+	// the contig name is the last field
+	if (memchr(cn, delim, cn_len) != NULL)
+		return NULL;
 
-	if (strchr(out_tokens[contig_idx], delim) != NULL) {
-		return free_pansn_buf(out_tokens);
+	// the haplotype id must be a number
+	id_t hap_id = 0;
+	for (size_t i = 0; i < h_len; i++) {
+		if (h[i] < '0' || h[i] > '9')
+			return NULL;
+		hap_id = hap_id * 10 + (id_t)(h[i] - '0');
 	}
 
-	const char **o = (const char **)out_tokens;
-	struct pansn *pn = alloc_pansn(o);
-	free_pansn_buf(out_tokens);
-
-	return pn;
+	return make_pansn(name, sn_len, hap_id, cn, cn_len, arena, names);
 }
 
 struct pansn *try_create_pansn(const char **id_tokens, idx_t token_count,
-			       char delim)
+			       char delim, struct lq_arena *arena,
+			       struct lq_intern *names)
 {
 	if (token_count == 1) {
 		const char *ref_name = id_tokens[PANSN_SAMPLE_COL];
-		return try_extract_pansn_from_str(ref_name, DELIM);
+		return try_extract_pansn_from_str(ref_name, delim, arena,
+						  names);
 	} else if (token_count == 3) {
-		return alloc_pansn(id_tokens);
+		return alloc_pansn(id_tokens, arena, names);
 	}
 
 	return NULL;
 }
 
-struct ref_id *alloc_ref_id(const char **id_tokens, idx_t token_count)
+struct ref_id *alloc_ref_id(const char **id_tokens, idx_t token_count,
+			    struct lq_arena *arena, struct lq_intern *names)
 {
-	struct ref_id *r_id = malloc(sizeof(struct ref_id));
+	struct ref_id *r_id = lq_alloc(arena, sizeof(struct ref_id));
 	if (!r_id)
 		return NULL;
 
-	struct pansn *pn = try_create_pansn(id_tokens, token_count, DELIM);
+	struct pansn *pn =
+		try_create_pansn(id_tokens, token_count, DELIM, arena, names);
 
 	if (pn) {
 		r_id->type = REF_ID_PANSN;
 		r_id->value.id_value = pn;
-		// create the tag
-		r_id->tag = alloc_pansn_tag(pn);
+		// create the tag, a P line name already is one
+		if (token_count == 1) {
+			const char *n = id_tokens[PANSN_SAMPLE_COL];
+			r_id->tag = lq_strndup(arena, n, strlen(n));
+		} else {
+			r_id->tag = alloc_pansn_tag(pn, arena);
+		}
 		if (!r_id->tag) {
-			free(r_id);
-			destroy_pansn(&pn);
+			if (!arena) {
+				free(r_id);
+				destroy_pansn(&pn);
+			}
 			return NULL;
 		}
 	} else {
+		const char *raw = id_tokens[PANSN_SAMPLE_COL];
 		r_id->type = REF_ID_RAW;
-		r_id->value.raw = strdup(id_tokens[PANSN_SAMPLE_COL]);
+		r_id->value.raw = lq_strndup(arena, raw, strlen(raw));
 		if (!r_id->value.raw) {
-			free(r_id);
+			if (!arena)
+				free(r_id);
 			return NULL;
 		}
 		// for raw ids, tag is the raw string
@@ -210,23 +229,12 @@ void destroy_ref_id(struct ref_id **r_id)
 		return;
 
 	if ((*r_id)->type == REF_ID_PANSN) {
-		if ((*r_id)->value.id_value->sample_name != NULL) {
-			free((*r_id)->value.id_value->sample_name);
-			(*r_id)->value.id_value->sample_name = NULL;
-		}
-		if ((*r_id)->value.id_value->contig_name != NULL) {
-			free((*r_id)->value.id_value->contig_name);
-			(*r_id)->value.id_value->contig_name = NULL;
-		}
 		if ((*r_id)->tag != NULL) {
 			free((*r_id)->tag);
 			(*r_id)->tag = NULL;
 		}
 
-		if ((*r_id)->value.id_value != NULL) {
-			free((*r_id)->value.id_value);
-			(*r_id)->value.id_value = NULL;
-		}
+		destroy_pansn(&(*r_id)->value.id_value);
 
 	} else if ((*r_id)->type == REF_ID_RAW) {
 		if ((*r_id)->value.raw != NULL) {
@@ -3,6 +3,8 @@
 
 #include "../../include/liteseq/refs.h"
 #include "../../include/liteseq/types.h"
+#include "../internal/lq_arena.h"
+#include "../internal/lq_intern.h"
 
 #ifdef __cplusplus
 extern "C" { // Ensure the function has C linkage
@@ -10,13 +12,22 @@ namespace liteseq
 {
 #endif
 
+/**
+ * When arena is NULL the ref_id is malloc'd and must be freed with
+ * destroy_ref_id, otherwise it lives as long as the arena.
+ * When names is not NULL PanSN sample and contig names are interned in it.
+ */
 void destroy_ref_id(struct ref_id **r_id);
-struct ref_id *alloc_ref_id(const char **tokens, idx_t token_count);
+struct ref_id *alloc_ref_id(const char **tokens, idx_t token_count,
+			    struct lq_arena *arena, struct lq_intern *names);
 
 #ifdef TESTING
-struct pansn *try_extract_pansn_from_str(const char *name, const char delim);
+struct pansn *try_extract_pansn_from_str(const char *name, const char delim,
+					 struct lq_arena *arena,
+					 struct lq_intern *names);
 void destroy_pansn(struct pansn **pn);
-struct pansn *alloc_pansn(const char **tokens);
+struct pansn *alloc_pansn(const char **tokens, struct lq_arena *arena,
+			  struct lq_intern *names);
 
 #endif // TESTING
 
@@ -0,0 +1,196 @@
+#include <stdlib.h>
+
+#include "../../include/liteseq/refs.h"
+#include "../../include/liteseq/types.h"
+#include "../internal/lq_arena.h"
+#include "../internal/lq_utils.h"
+
+#include "./ref_pos.h"
+
+// the number of searches interleaved by ref_locate_batch
+#define LOCATE_BATCH_SIZE 16
+
+// how far ahead to prefetch in the Eytzinger array, 16 idx_t per cache line
+// means the great-great-grandchildren of k start at k * 16
+#define EYTZ_PREFETCH_STRIDE 16
+
+/**
+ * Lay out the sorted samples in Eytzinger order through an in-order walk of
+ * the implicit tree. Iterative to keep the stack flat for long walks.
+ */
+static void eytzinger_fill(const idx_t *loci, idx_t count, idx_t *eytz,
+			   idx_t *rank)
+{
+	idx_t sample = 0;
+	idx_t k = 1;
+
+	// descend to the leftmost node
+	while (2 * k <= count)
+		k *= 2;
+
+	while (sample < count) {
+		eytz[k] = loci[(size_t)sample * LOCI_SAMPLE_RATE];
+		rank[k] = sample++;
+
+		// in-order successor of k
+		if (2 * k + 1 <= count) {
+			k = 2 * k + 1;
+			while (2 * k <= count)
+				k *= 2;
+		} else {
+			// climb while we are a right child
+			while (k & 1)
+				k >>= 1;
+			k >>= 1;
+		}
+	}
+}
+
+status_t build_ref_pos_index(struct ref *r, struct lq_arena *arena)
+{
+	if (!r || !r->walk || !r->walk->loci)
+		return ERROR_CODE_INVALID_ARGUMENT;
+
+	struct ref_walk *w = r->walk;
+	idx_t count = (w->step_count + LOCI_SAMPLE_RATE - 1) / LOCI_SAMPLE_RATE;
+
+	// entry 0 is unused so that the children of k are 2k and 2k + 1
+	idx_t *eytz = lq_alloc(arena, sizeof(idx_t) * (count + 1));
+	idx_t *rank = lq_alloc(arena, sizeof(idx_t) * (count + 1));
+	if (!eytz || !rank) {
+		if (!arena) {
+			free(eytz);
+			free(rank);
+		}
+		return ERROR_CODE_OUT_OF_MEMORY;
+	}
+
+	eytz[0] = 0;
+	rank[0] = NULL_IDX;
+	eytzinger_fill(w->loci, count, eytz, rank);
+
+	w->eytz = eytz;
+	w->eytz_rank = rank;
+	w->eytz_count = count;
+
+	return SUCCESS;
+}
+
+/**
+ * From the node a search ended at to the sample the position falls in.
+ * A search ends past the leaves; dropping the trailing 1 bits and the 0 before
+ * them gives the first sample greater than the position, or 0 if none is.
+ */
+static inline idx_t eytz_sample(const struct ref_walk *w, idx_t k)
+{
+	k >>= __builtin_ffs(~k);
+	return k == 0 ? w->eytz_count - 1 : w->eytz_rank[k] - 1;
+}
+
+/**
+ * Within the block of the sample find the last step starting at or before pos
+ */
+static inline void locate_in_block(const struct ref_walk *w, idx_t sample,
+				   idx_t pos, struct ref_locus *out)
+{
+	idx_t first = sample * LOCI_SAMPLE_RATE;
+	idx_t last = first + LOCI_SAMPLE_RATE;
+	if (last > w->step_count)
+		last = w->step_count;
+
+	// loci are sorted, count instead of branching
+	idx_t n = 0;
+	for (idx_t j = first; j < last; j++)
+		n += w->loci[j] <= pos;
+
+	idx_t step = first + n - 1;
+	out->step = step;
+	out->v_id = w->v_ids[step];
+	out->offset = pos - w->loci[step];
+}
+
+static inline void locus_not_found(struct ref_locus *out)
+{
+	out->step = NULL_IDX;
+	out->v_id = NULL_ID;
+	out->offset = NULL_IDX;
+}
+
+status_t ref_locate(const struct ref *r, idx_t pos, struct ref_locus *out)
+{
+	if (!r || !out || !r->walk->eytz)
+		return ERROR_CODE_INVALID_ARGUMENT;
+
+	const struct ref_walk *w = r->walk;
+	if (pos < 1 || pos > w->hap_len) {
+		locus_not_found(out);
+		return ERROR_CODE_OUT_OF_BOUNDS;
+	}
+
+	const idx_t *eytz = w->eytz;
+	idx_t count = w->eytz_count;
+	idx_t k = 1;
+	while (k <= count) {
+		prefetch(eytz + (size_t)k * EYTZ_PREFETCH_STRIDE);
+		k = 2 * k + (eytz[k] <= pos);
+	}
+
+	locate_in_block(w, eytz_sample(w, k), pos, out);
+
+	return SUCCESS;
+}
+
+status_t ref_locate_batch(const struct ref *r, const idx_t *pos, idx_t n,
+			  struct ref_locus *out)
+{
+	if (!r || !pos || !out || !r->walk->eytz)
+		return ERROR_CODE_INVALID_ARGUMENT;
+
+	const struct ref_walk *w = r->walk;
+	const idx_t *eytz = w->eytz;
+	idx_t count = w->eytz_count;
+	idx_t hap_len = w->hap_len;
+
+	// the depth of the implicit tree
+	idx_t depth = 0;
+	for (idx_t c = count; c > 0; c >>= 1)
+		depth++;
+
+	idx_t k[LOCATE_BATCH_SIZE];
+	for (idx_t i = 0; i < n; i += LOCATE_BATCH_SIZE) {
+		idx_t b = n - i < LOCATE_BATCH_SIZE ? n - i : LOCATE_BATCH_SIZE;
+		const idx_t *p = pos + i;
+
+		for (idx_t q = 0; q < b; q++)
+			k[q] = 1;
+
+		// advance every search by one level at a time so that the cache
+		// misses of the batch are in flight together
+		for (idx_t level = 0; level < depth; level++) {
+			for (idx_t q = 0; q < b; q++) {
+				if (k[q] > count)
+					continue;
+				k[q] = 2 * k[q] + (eytz[k[q]] <= p[q]);
+				prefetch(eytz + (size_t)k[q] *
+							EYTZ_PREFETCH_STRIDE);
+			}
+		}
+
+		idx_t sample[LOCATE_BATCH_SIZE];
+		for (idx_t q = 0; q < b; q++) {
+			sample[q] = eytz_sample(w, k[q]);
+			size_t first = (size_t)sample[q] * LOCI_SAMPLE_RATE;
+			prefetch(w->loci + first);
+		}
+
+		for (idx_t q = 0; q < b; q++) {
+			struct ref_locus *o = &out[i + q];
+			if (p[q] < 1 || p[q] > hap_len)
+				locus_not_found(o);
+			else
+				locate_in_block(w, sample[q], p[q], o);
+		}
+	}
+
+	return SUCCESS;
+}
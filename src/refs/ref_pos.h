@@ -0,0 +1,26 @@
+#ifndef LQ_REF_POS_H
+#define LQ_REF_POS_H
+
+#include "../../include/liteseq/refs.h"
+#include "../../include/liteseq/types.h"
+#include "../internal/lq_arena.h"
+
+#ifdef __cplusplus
+extern "C" { // Ensure the function has C linkage
+namespace liteseq
+{
+#endif
+
+/**
+ * Build the positional index of a ref whose loci are set.
+ * The index is allocated from arena, or malloc'd when it is NULL in which case
+ * destroy_ref_walk frees it.
+ */
+status_t build_ref_pos_index(struct ref *r, struct lq_arena *arena);
+
+#ifdef __cplusplus
+} // namespace liteseq
+} // extern "C"
+#endif
+
+#endif // LQ_REF_POS_H
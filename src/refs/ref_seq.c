@@ -0,0 +1,71 @@
+#include <string.h>
+
+#include "../../include/liteseq/gfa.h"
+#include "../../include/liteseq/refs.h"
+#include "../../include/liteseq/types.h"
+#include "../internal/lq_dna.h"
+
+status_t ref_get_sequence(const gfa_props *gfa, const struct ref *r,
+			  idx_t start, idx_t len, char *buf)
+{
+	if (!gfa || !r || !buf || !gfa->inc_vtx_labels)
+		return ERROR_CODE_INVALID_ARGUMENT;
+
+	idx_t hap_len = get_hap_len(r);
+	if (len == 0) {
+		buf[0] = NULL_CHAR;
+		return SUCCESS;
+	}
+
+	if (start < 1 || start > hap_len || len > hap_len - start + 1)
+		return ERROR_CODE_OUT_OF_BOUNDS;
+
+	// start from the step under start rather than step 0
+	struct ref_locus l;
+	status_t res = ref_locate(r, start, &l);
+	if (res != SUCCESS)
+		return res;
+
+	const id_t *v_ids = get_walk_v_ids(r);
+	const enum strand *strands = get_walk_strands(r);
+	const idx_t *loci = get_walk_loci(r);
+	idx_t step_count = get_step_count(r);
+
+	char *out = buf;
+	idx_t left = len;
+	idx_t offset = l.offset;
+	for (idx_t step = l.step; left > 0; step++, offset = 0) {
+		idx_t next = step + 1 < step_count ? loci[step + 1]
+						   : hap_len + 1;
+		idx_t step_len = next - loci[step];
+		if (step_len == 0)
+			continue; // a vertex missing from the graph
+
+		idx_t take = step_len - offset;
+		if (take > left)
+			take = left;
+		const char *seq = gfa->v[gfa_vtx_slot(gfa, v_ids[step])]->seq;
+
+		// the bases of a reverse step are the reverse complement of the
+		// label so base offset comes from the end of the label
+		if (strands[step] == STRAND_FWD)
+			memcpy(out, seq + offset, take);
+		else
+			lq_revcomp(out, seq + step_len - offset - take, take);
+
+		out += take;
+		left -= take;
+	}
+	*out = NULL_CHAR;
+
+	return SUCCESS;
+}
+
+status_t ref_get_haplotype(const gfa_props *gfa, const struct ref *r,
+			   char *buf)
+{
+	if (!r)
+		return ERROR_CODE_INVALID_ARGUMENT;
+
+	return ref_get_sequence(gfa, r, 1, get_hap_len(r), buf);
+}
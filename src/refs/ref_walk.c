@@ -3,6 +3,7 @@
 #include <string.h> // for memset
 
 #include "../../include/liteseq/refs.h"
+#include "../internal/lq_arena.h"
 
 void destroy_ref_walk(struct ref_walk **w)
 {
@@ -25,21 +26,55 @@ void destroy_ref_walk(struct ref_walk **w)
 		(*w)->loci = NULL;
 	}
 
+	if ((*w)->eytz != NULL) {
+		free((*w)->eytz);
+		(*w)->eytz = NULL;
+	}
+
+	if ((*w)->eytz_rank != NULL) {
+		free((*w)->eytz_rank);
+		(*w)->eytz_rank = NULL;
+	}
+
 	if (*w != NULL) {
 		free(*w);
 		*w = NULL;
 	}
 }
 
-struct ref_walk *alloc_ref_walk(idx_t step_count)
+struct ref_walk *alloc_ref_walk(idx_t step_count, struct lq_arena *arena)
 {
-	struct ref_walk *w = malloc(sizeof(struct ref_walk));
+	struct ref_walk *w = lq_alloc(arena, sizeof(struct ref_walk));
 	if (!w)
 		return NULL;
 
 	w->strands = NULL;
 	w->v_ids = NULL;
 	w->loci = NULL;
+	w->eytz = NULL;
+	w->eytz_rank = NULL;
+	w->eytz_count = 0;
+	w->first_step = 0;
+
+	if (arena) {
+		// a single allocation, the arena releases it as a whole
+		size_t sz = (sizeof(enum strand) + sizeof(id_t) +
+			     sizeof(idx_t)) *
+			    step_count;
+		byte *buf = lq_arena_alloc(arena, sz);
+		if (!buf)
+			return NULL;
+
+		w->v_ids = (id_t *)buf;
+		w->loci = (idx_t *)(buf + sizeof(id_t) * step_count);
+		w->strands = (enum strand *)(buf + (sizeof(id_t) +
+						    sizeof(idx_t)) *
+							   step_count);
+		w->step_count = step_count;
+		w->hap_len = 0; // default to 0
+
+		return w;
+	}
 
 	w->strands = malloc(sizeof(enum strand) * step_count);
 	if (!w->strands) {
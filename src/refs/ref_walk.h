@@ -3,6 +3,7 @@
 
 #include "../../include/liteseq/refs.h"
 #include "../../include/liteseq/types.h"
+#include "../internal/lq_arena.h"
 
 #ifdef __cplusplus
 extern "C" { // Ensure the function has C linkage
@@ -10,15 +11,16 @@ namespace liteseq
 {
 #endif
 
+/**
+ * When arena is NULL the walk is malloc'd and must be freed with
+ * destroy_ref_walk, otherwise it lives as long as the arena.
+ */
 void destroy_ref_walk(struct ref_walk **w);
-struct ref_walk *alloc_ref_walk(idx_t step_count);
+struct ref_walk *alloc_ref_walk(idx_t step_count, struct lq_arena *arena);
 status_t parse_data_line_w(const char *str, struct ref_walk **empty_r_walk);
 status_t parse_data_line_p(const char *str, struct ref_walk **empty_r_walk);
 
 #ifdef TESTING
-struct ref_walk *alloc_ref_walk(idx_t step_count);
-void destroy_ref_walk(struct ref_walk **r_walk);
-
 idx_t count_steps(enum gfa_line_prefix line_type, const char *str);
 #endif // TESTING
 
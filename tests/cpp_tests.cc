@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <liteseq/liteseq.hpp>
+
+using namespace liteseq;
+
+#define CPP_W_LINES_GFA LQ_TEST_DATA_DIR "/gfa_with_w_lines.gfa"
+#define CPP_LPA_GFA LQ_TEST_DATA_DIR "/LPA.gfa"
+
+static_assert(!std::is_copy_constructible_v<Graph>);
+static_assert(std::is_nothrow_move_constructible_v<Graph>);
+
+TEST(CppGraph, ViewsMatchTheCApi)
+{
+	Graph g(gfa_config_cpp(CPP_LPA_GFA, true, true, true));
+	gfa_props *gfa = g.get();
+
+	std::vector<id_t> ids;
+	for (Vertex v : g.vertices()) {
+		ASSERT_EQ(v.label.data(), gfa->v[v.id]->seq); // not a copy
+		ids.push_back(v.id);
+	}
+	ASSERT_EQ(ids.size(), gfa->s_line_count);
+	for (size_t i = 1; i < ids.size(); i++)
+		ASSERT_LT(ids[i - 1], ids[i]);
+
+	ASSERT_EQ(g.edges().data(), gfa->e);
+	ASSERT_EQ(g.edges().size(), gfa->l_line_count);
+
+	ASSERT_EQ(g.refs().size(), gfa->ref_count);
+	idx_t ref_idx = 0;
+	for (Ref r : g.refs()) {
+		const struct ref *c = get_ref(gfa, ref_idx);
+		ASSERT_EQ(r.get(), c);
+		ASSERT_EQ(r.tag(), get_tag(c));
+		ASSERT_EQ(r.v_ids().data(), get_walk_v_ids(c));
+		ASSERT_EQ(r.loci().size(), get_step_count(c));
+		ASSERT_EQ(g.find_ref(std::string(r.tag())), ref_idx);
+
+		idx_t i = 0;
+		for (Step s : r.steps()) {
+			ASSERT_EQ(s.v_id, get_walk_v_ids(c)[i]);
+			ASSERT_EQ(s.strand, get_walk_strands(c)[i]);
+			i++;
+		}
+		ASSERT_EQ(i, get_step_count(c));
+		ASSERT_EQ(r.steps().end() - r.steps().begin(),
+			  (std::ptrdiff_t)i);
+
+		// the last base is in the last step
+		struct ref_locus l = r.locate(r.hap_len());
+		ASSERT_EQ(l.step, i - 1);
+		ASSERT_EQ(r.locate(r.hap_len() + 1).step, NULL_IDX);
+
+		std::string hap = g.haplotype(r);
+		ASSERT_EQ(hap.size(), r.hap_len());
+
+		ref_idx++;
+	}
+
+	for (Vertex v : g.vertices()) {
+		for (const struct vtx_occ &o : g.occurrences(v.id))
+			ASSERT_EQ(g.refs()[o.ref_idx].steps()[o.step].v_id,
+				  v.id);
+	}
+}
+
+static bool same(const Step &a, const Step &b)
+{
+	return a.v_id == b.v_id && a.strand == b.strand;
+}
+
+static bool same(const Ref &a, const Ref &b)
+{
+	return a.get() == b.get();
+}
+
+// the operations a random access iterator is required to have
+template <typename It> static void expect_random_access(It begin, It end)
+{
+	using D = typename std::iterator_traits<It>::difference_type;
+	D n = end - begin;
+	ASSERT_GT(n, 1);
+
+	It last = end - 1;
+	ASSERT_EQ(last - begin, n - 1);
+	ASSERT_TRUE(1 + begin == begin + 1);
+	ASSERT_TRUE(begin < last && last > begin);
+	ASSERT_TRUE(begin <= begin && last >= begin && !(begin >= last));
+
+	It it = end;
+	it -= n;
+	ASSERT_TRUE(it == begin);
+	it = end;
+	ASSERT_TRUE(it-- == end);
+	ASSERT_TRUE(it == last);
+	ASSERT_TRUE(std::prev(end) == last);
+	ASSERT_EQ(std::distance(begin, end), n);
+
+	// walked backwards the elements come in reverse
+	std::reverse_iterator<It> r(end);
+	for (D i = n - 1; i >= 0; i--, ++r)
+		ASSERT_TRUE(same(*r, begin[i]));
+}
+
+TEST(CppGraph, IteratorsAreRandomAccess)
+{
+	Graph g(gfa_config_cpp(CPP_LPA_GFA, true, true));
+	RefRange refs = g.refs();
+	expect_random_access(refs.begin(), refs.end());
+
+	WalkRange steps = refs[0].steps();
+	expect_random_access(steps.begin(), steps.end());
+}
+
+TEST(CppGraph, PanSNAndMoves)
+{
+	Graph g(gfa_config_cpp(CPP_W_LINES_GFA, true, true));
+	ASSERT_EQ(g.refs().size(), 6u);
+
+	Ref w = g.refs()[3];
+	ASSERT_EQ(w.line_prefix(), W_LINE);
+	ASSERT_EQ(w.sample(), "short");
+	ASSERT_EQ(w.hap_id(), 1u);
+	ASSERT_EQ(w.contig(), "chr");
+
+	// the views stay valid across a move, only the handle changes hands
+	gfa_props *raw = g.get();
+	Graph moved(std::move(g));
+	ASSERT_FALSE(g);
+	ASSERT_EQ(moved.get(), raw);
+	ASSERT_EQ(w.sample(), "short");
+
+	Graph other(gfa_config_cpp(CPP_LPA_GFA));
+	other = std::move(moved);
+	ASSERT_EQ(other.get(), raw);
+	ASSERT_EQ(other.refs().size(), 6u);
+
+	// no refs were parsed
+	Graph bare(gfa_config_cpp(CPP_W_LINES_GFA));
+	ASSERT_EQ(bare.refs().size(), 0u);
+	ASSERT_EQ(bare.label(1), "");
+	ASSERT_EQ(bare.occurrences(1).size(), 0u);
+
+	ASSERT_THROW(Graph::load_snapshot(CPP_W_LINES_GFA),
+		     std::runtime_error);
+}
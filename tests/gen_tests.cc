@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <set>
+#include <string>
+#include <utility>
+#include <liteseq/gfa.h>
+#include <liteseq/refs.h>
+#include <liteseq/types.h>
+
+#include "../tools/gfa_gen.h"
+
+using namespace liteseq;
+
+static std::string gen_text(const struct gfa_gen_opts *o, status_t *res)
+{
+	char *buf = NULL;
+	size_t size = 0;
+	FILE *f = open_memstream(&buf, &size);
+	*res = gfa_gen_write(o, f, NULL);
+	fclose(f);
+
+	std::string text(buf, size);
+	free(buf);
+
+	return text;
+}
+
+TEST(GfaGen, LoadsWithWhatItWrote)
+{
+	const std::string fp = testing::TempDir() + "liteseq_gen.gfa";
+
+	struct gfa_gen_opts o;
+	gfa_gen_defaults(&o);
+	o.seed = 7;
+	o.segment_count = 20000;
+	o.path_count = 12;
+	o.min_walk_frac = 0.2;
+	o.max_walk_frac = 0.9;
+	o.ploidy = 3;
+
+	struct gfa_gen_counts c;
+	ASSERT_EQ(gfa_gen_file(&o, fp.c_str(), &c), SUCCESS);
+	ASSERT_EQ(c.segments, o.segment_count);
+	ASSERT_EQ(c.p_lines + c.w_lines, o.path_count);
+	ASSERT_GT(c.p_lines, 0u);
+	ASSERT_GT(c.w_lines, 0u);
+
+	gfa_config_cpp conf(fp.c_str(), true, true);
+	gfa_props *gfa = gfa_new(&conf);
+	ASSERT_EQ(gfa->status, 0);
+	ASSERT_EQ(gfa->version, liteseq::GFA_1_1);
+	ASSERT_EQ(gfa->s_line_count, c.segments);
+	ASSERT_EQ(gfa->l_line_count, c.links);
+	ASSERT_EQ(gfa->p_line_count, c.p_lines);
+	ASSERT_EQ(gfa->w_line_count, c.w_lines);
+	ASSERT_EQ(gfa->max_v_id, c.segments);
+
+	for (id_t v = 1; v <= c.segments; v++) {
+		size_t len = strlen(gfa->v[v]->seq);
+		ASSERT_GE(len, o.min_label_len);
+		ASSERT_LE(len, o.max_label_len);
+	}
+
+	// the paths only take edges of the graph, forwards
+	std::set<std::pair<id_t, id_t>> edges;
+	for (idx_t i = 0; i < gfa->l_line_count; i++)
+		edges.insert({gfa->e[i].v1_id, gfa->e[i].v2_id});
+	for (idx_t i = 0; i < gfa->ref_count; i++) {
+		const struct ref *r = get_ref(gfa, i);
+		const id_t *v_ids = get_walk_v_ids(r);
+		ASSERT_GT(get_step_count(r), 0u);
+		for (idx_t j = 0; j < get_step_count(r); j++) {
+			ASSERT_EQ(get_walk_strands(r)[j], STRAND_FWD);
+			if (j > 0) {
+				ASSERT_TRUE(edges.count({v_ids[j - 1],
+							 v_ids[j]}));
+			}
+		}
+		ASSERT_NE(get_sample_id(r), NULL_ID);
+		ASSERT_LE(get_hap_id(r), o.ploidy);
+	}
+
+	gfa_free(gfa);
+	std::remove(fp.c_str());
+}
+
+TEST(GfaGen, IsSeeded)
+{
+	struct gfa_gen_opts o;
+	gfa_gen_defaults(&o);
+	o.segment_count = 5000;
+	o.len_dist = GFA_GEN_LEN_GEOMETRIC;
+	o.min_label_len = 2;
+	o.mean_label_len = 10;
+	o.max_label_len = 200;
+
+	status_t res;
+	std::string a = gen_text(&o, &res);
+	ASSERT_EQ(res, SUCCESS);
+	ASSERT_EQ(gen_text(&o, &res), a);
+
+	o.seed++;
+	ASSERT_NE(gen_text(&o, &res), a);
+
+	// GFA 1.0 has no W lines
+	o.version = liteseq::GFA_1_0;
+	gen_text(&o, &res);
+	ASSERT_EQ(res, ERROR_CODE_INVALID_ARGUMENT);
+	o.w_line_frac = 0;
+	o.pansn = false;
+	std::string b = gen_text(&o, &res);
+	ASSERT_EQ(res, SUCCESS);
+	ASSERT_EQ(b.rfind("H\tVN:Z:1.0\n", 0), 0u);
+	ASSERT_EQ(b.find("\nW\t"), std::string::npos);
+	ASSERT_NE(b.find("\nP\tpath0\t"), std::string::npos);
+
+	o.max_label_len = 1;
+	gen_text(&o, &res);
+	ASSERT_EQ(res, ERROR_CODE_INVALID_ARGUMENT);
+}
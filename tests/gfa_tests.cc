@@ -1,7 +1,1783 @@
 #include <gtest/gtest.h>
 
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <array>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <liteseq/gfa.h>
 #include <liteseq/refs.h>
 #include <liteseq/types.h>
 
+#include "../src/gfa_adj.h"
+#include "../src/gfa_cov.h"
+
 using namespace liteseq;
+
+#define W_LINES_GFA LQ_TEST_DATA_DIR "/gfa_with_w_lines.gfa"
+#define LPA_GFA LQ_TEST_DATA_DIR "/LPA.gfa"
+#define REV_STRANDS_GFA LQ_TEST_DATA_DIR "/rev_strands.gfa"
+#define COMPONENTS_GFA LQ_TEST_DATA_DIR "/components.gfa"
+
+TEST(GfaNew, InternsPanSNNames)
+{
+	gfa_config_cpp conf(W_LINES_GFA, true, true);
+	gfa_props *gfa = gfa_new(&conf);
+	ASSERT_EQ(gfa->status, 0);
+	ASSERT_EQ(gfa->ref_count, 6u);
+
+	// W lines: short#1#chr, alt#0#chr, short#2#chr
+	const struct ref *r1 = get_ref(gfa, 3);
+	const struct ref *r2 = get_ref(gfa, 4);
+	const struct ref *r3 = get_ref(gfa, 5);
+
+	ASSERT_EQ(get_sample_id(r1), get_sample_id(r3));
+	ASSERT_NE(get_sample_id(r1), get_sample_id(r2));
+	ASSERT_EQ(get_contig_id(r1), get_contig_id(r2));
+	ASSERT_EQ(get_sample_name(r1), get_sample_name(r3)); // one copy
+
+	ASSERT_STREQ(get_pansn_name(gfa, get_sample_id(r2)), "alt");
+	ASSERT_EQ(find_pansn_name(gfa, "chr"), get_contig_id(r3));
+	ASSERT_EQ(find_pansn_name(gfa, "absent"), NULL_ID);
+
+	// P lines with raw names are not interned
+	ASSERT_EQ(get_sample_id(get_ref(gfa, 0)), NULL_ID);
+
+	gfa_free(gfa);
+}
+
+TEST(RefLocate, SmallWalk)
+{
+	gfa_config_cpp conf(W_LINES_GFA, true, true);
+	gfa_props *gfa = gfa_new(&conf);
+	ASSERT_EQ(gfa->status, 0);
+
+	// P short 1+,4+,5+,6+,7+,9+ i.e. G GGG T A C A
+	const struct ref *r = get_ref(gfa, 0);
+	const idx_t expected_loci[] = {1, 2, 5, 6, 7, 8};
+	for (idx_t j = 0; j < get_step_count(r); j++)
+		ASSERT_EQ(get_walk_loci(r)[j], expected_loci[j]);
+
+	struct ref_locus l;
+	ASSERT_EQ(ref_locate(r, 3, &l), SUCCESS);
+	ASSERT_EQ(l.step, 1u);
+	ASSERT_EQ(l.v_id, 4u);
+	ASSERT_EQ(l.offset, 1u);
+
+	ASSERT_EQ(ref_locate(r, 8, &l), SUCCESS);
+	ASSERT_EQ(l.step, 5u);
+	ASSERT_EQ(l.v_id, 9u);
+	ASSERT_EQ(l.offset, 0u);
+
+	ASSERT_EQ(ref_locate(r, 0, &l), ERROR_CODE_OUT_OF_BOUNDS);
+	ASSERT_EQ(ref_locate(r, 9, &l), ERROR_CODE_OUT_OF_BOUNDS);
+
+	gfa_free(gfa);
+}
+
+TEST(RefLocate, MatchesLinearScan)
+{
+	gfa_config_cpp conf(LPA_GFA, true, true);
+	gfa_props *gfa = gfa_new(&conf);
+	ASSERT_EQ(gfa->status, 0);
+
+	for (idx_t i = 0; i < gfa->ref_count; i++) {
+		const struct ref *r = get_ref(gfa, i);
+		const idx_t *loci = get_walk_loci(r);
+		idx_t hap_len = get_hap_len(r);
+
+		std::vector<idx_t> pos;
+		for (idx_t p = 0; p <= hap_len + 1; p += 7)
+			pos.push_back(p);
+		pos.push_back(hap_len);
+
+		std::vector<ref_locus> batch(pos.size());
+		ASSERT_EQ(ref_locate_batch(r, pos.data(), pos.size(),
+					   batch.data()),
+			  SUCCESS);
+
+		idx_t step = 0;
+		for (size_t q = 0; q < pos.size(); q++) {
+			idx_t p = pos[q];
+			struct ref_locus l;
+			status_t res = ref_locate(r, p, &l);
+			if (p < 1 || p > hap_len) {
+				ASSERT_EQ(res, ERROR_CODE_OUT_OF_BOUNDS);
+				ASSERT_EQ(batch[q].step, NULL_IDX);
+				continue;
+			}
+			ASSERT_EQ(res, SUCCESS);
+
+			// the last step starting at or before p, the positions
+			// are increasing so the scan carries on from the last
+			while (step + 1 < get_step_count(r) &&
+			       loci[step + 1] <= p)
+				step++;
+			ASSERT_EQ(l.step, step);
+			ASSERT_EQ(l.v_id, get_walk_v_ids(r)[step]);
+			ASSERT_EQ(l.offset, p - loci[step]);
+			ASSERT_EQ(batch[q].step, l.step);
+			ASSERT_EQ(batch[q].offset, l.offset);
+		}
+	}
+
+	gfa_free(gfa);
+}
+
+static void expect_occs_match_walks(const gfa_props *gfa)
+{
+	std::vector<std::vector<vtx_occ>> expected(gfa->vtx_arr_size);
+	for (idx_t i = 0; i < gfa->ref_count; i++) {
+		const struct ref *r = gfa->refs[i];
+		for (idx_t j = 0; j < get_step_count(r); j++)
+			expected[get_walk_v_ids(r)[j]].push_back({i, j});
+	}
+
+	for (id_t v = 0; v < gfa->vtx_arr_size; v++) {
+		idx_t count;
+		const vtx_occ *occs = get_vtx_occs(gfa, v, &count);
+		ASSERT_EQ(count, expected[v].size());
+		for (idx_t k = 0; k < count; k++) {
+			ASSERT_EQ(occs[k].ref_idx, expected[v][k].ref_idx);
+			ASSERT_EQ(occs[k].step, expected[v][k].step);
+		}
+	}
+}
+
+TEST(OccIndex, MatchesWalks)
+{
+	for (u32 threads : {1u, 3u, 0u}) {
+		gfa_config_cpp conf(LPA_GFA, false, true, true, threads);
+		gfa_props *gfa = gfa_new(&conf);
+		ASSERT_EQ(gfa->status, 0);
+		ASSERT_NE(gfa->occs, nullptr);
+		expect_occs_match_walks(gfa);
+		gfa_free(gfa);
+	}
+}
+
+TEST(OccIndex, BuiltOnDemand)
+{
+	gfa_config_cpp conf(W_LINES_GFA, false, true);
+	gfa_props *gfa = gfa_new(&conf);
+	ASSERT_EQ(gfa->status, 0);
+
+	idx_t count;
+	ASSERT_EQ(get_vtx_occs(gfa, 1, &count), nullptr);
+	ASSERT_EQ(count, 0u);
+
+	ASSERT_EQ(gfa_build_occ_index(gfa), SUCCESS);
+	expect_occs_match_walks(gfa);
+
+	// out of range vertex
+	ASSERT_EQ(get_vtx_occs(gfa, gfa->vtx_arr_size, &count), nullptr);
+	ASSERT_EQ(count, 0u);
+
+	gfa_free(gfa);
+}
+
+TEST(RefLookup, ByTagAndPanSN)
+{
+	gfa_config_cpp conf(W_LINES_GFA, false, true);
+	gfa_props *gfa = gfa_new(&conf);
+	ASSERT_EQ(gfa->status, 0);
+
+	for (idx_t i = 0; i < gfa->ref_count; i++)
+		ASSERT_EQ(find_ref_by_tag(gfa, get_tag(get_ref(gfa, i))), i);
+	ASSERT_EQ(find_ref_by_tag(gfa, "alt1"), 1u);
+	ASSERT_EQ(find_ref_by_tag(gfa, "absent"), NULL_IDX);
+
+	// W lines: short#1#chr, alt#0#chr, short#2#chr
+	ASSERT_EQ(find_ref_by_pansn(gfa, "short", 2, "chr"), 5u);
+	ASSERT_EQ(find_ref_by_pansn(gfa, "alt", 0, "chr"), 4u);
+	ASSERT_EQ(find_ref_by_pansn(gfa, "alt", 1, "chr"), NULL_IDX);
+	ASSERT_EQ(find_ref_by_pansn(gfa, "short", 1, "absent"), NULL_IDX);
+
+	idx_t count;
+	const idx_t *refs =
+		get_sample_refs(gfa, find_pansn_name(gfa, "short"), &count);
+	ASSERT_EQ(count, 2u);
+	ASSERT_EQ(refs[0], 3u);
+	ASSERT_EQ(refs[1], 5u);
+
+	refs = get_contig_refs(gfa, find_pansn_name(gfa, "chr"), &count);
+	ASSERT_EQ(count, 3u);
+	ASSERT_EQ(refs[0], 3u);
+	ASSERT_EQ(refs[2], 5u);
+
+	// a contig name is not a sample
+	ASSERT_EQ(get_sample_refs(gfa, find_pansn_name(gfa, "chr"), &count),
+		  nullptr);
+	ASSERT_EQ(count, 0u);
+	ASSERT_EQ(get_contig_refs(gfa, NULL_ID, &count), nullptr);
+
+	gfa_free(gfa);
+}
+
+TEST(Region, ExtractsSubgraph)
+{
+	for (bool occ_index : {false, true}) {
+		gfa_config_cpp conf(W_LINES_GFA, true, true, occ_index);
+		gfa_props *gfa = gfa_new(&conf);
+		ASSERT_EQ(gfa->status, 0);
+
+		// bases 3-5 of short are in the GGG of 4 and the T of 5
+		const struct ref *r = get_ref(gfa, 0);
+		struct gfa_region *rg = gfa_extract_region(gfa, r, 3, 5, 0);
+		ASSERT_NE(rg, nullptr);
+		ASSERT_EQ(rg->v_count, 2u);
+		ASSERT_EQ(rg->v_ids[0], 4u);
+		ASSERT_EQ(rg->v_ids[1], 5u);
+		ASSERT_EQ(rg->e_count, 1u);
+		ASSERT_EQ(rg->e[0].v1_id, 4u);
+		ASSERT_EQ(rg->e[0].v2_id, 5u);
+		// every ref goes through 4 then 5
+		ASSERT_EQ(rg->walk_count, gfa->ref_count);
+		for (idx_t i = 0; i < rg->walk_count; i++) {
+			ASSERT_EQ(rg->walks[i].ref_idx, i);
+			ASSERT_EQ(rg->walks[i].step_count, 2u);
+		}
+		ASSERT_EQ(rg->walks[0].step_start, 1u);
+		ASSERT_EQ(rg->walks[1].step_start, 2u);
+		gfa_region_free(&rg);
+		ASSERT_EQ(rg, nullptr);
+
+		// one hop out reaches 1, 2 and 6
+		rg = gfa_extract_region(gfa, r, 3, 5, 1);
+		ASSERT_NE(rg, nullptr);
+		const id_t expected[] = {1, 2, 4, 5, 6};
+		ASSERT_EQ(rg->v_count, 5u);
+		for (idx_t i = 0; i < rg->v_count; i++)
+			ASSERT_EQ(rg->v_ids[i], expected[i]);
+		ASSERT_EQ(rg->e_count, 5u);
+		ASSERT_EQ(rg->walks[0].step_start, 0u);
+		ASSERT_EQ(rg->walks[0].step_count, 4u);
+		ASSERT_EQ(rg->walks[1].step_count, 5u);
+		gfa_region_free(&rg);
+
+		ASSERT_EQ(gfa_extract_region(gfa, r, 0, 5, 0), nullptr);
+		ASSERT_EQ(gfa_extract_region(gfa, r, 6, 5, 0), nullptr);
+
+		gfa_free(gfa);
+	}
+}
+
+// the haplotype of a ref built one base at a time
+static std::string naive_haplotype(gfa_props *gfa, const struct ref *r)
+{
+	std::string hap;
+	for (idx_t j = 0; j < get_step_count(r); j++) {
+		std::string seq = get_vtx(gfa, get_walk_v_ids(r)[j])->seq;
+		if (get_walk_strands(r)[j] == STRAND_FWD) {
+			hap += seq;
+			continue;
+		}
+		for (auto it = seq.rbegin(); it != seq.rend(); ++it) {
+			const std::string from = "ACGTNRYacgtnry";
+			const std::string to = "TGCANYRtgcanyr";
+			hap += to[from.find(*it)];
+		}
+	}
+	return hap;
+}
+
+TEST(RefSequence, MatchesNaive)
+{
+	for (const char *fp : {REV_STRANDS_GFA, LPA_GFA}) {
+		gfa_config_cpp conf(fp, true, true);
+		gfa_props *gfa = gfa_new(&conf);
+		ASSERT_EQ(gfa->status, 0);
+
+		for (idx_t i = 0; i < gfa->ref_count; i++) {
+			const struct ref *r = get_ref(gfa, i);
+			std::string hap = naive_haplotype(gfa, r);
+			idx_t hap_len = get_hap_len(r);
+			ASSERT_EQ(hap.size(), hap_len);
+
+			std::string buf(hap_len + 1, 'X');
+			ASSERT_EQ(ref_get_haplotype(gfa, r, &buf[0]), SUCCESS);
+			ASSERT_STREQ(buf.c_str(), hap.c_str());
+
+			// substrings that start and end mid step
+			idx_t stride = hap_len / 41 + 1;
+			for (idx_t start = 1; start <= hap_len;
+			     start += stride) {
+				idx_t len = (hap_len - start + 1) / 2 + 1;
+				ASSERT_EQ(ref_get_sequence(gfa, r, start, len,
+							   &buf[0]),
+					  SUCCESS);
+				ASSERT_EQ(std::string(buf.c_str()),
+					  hap.substr(start - 1, len));
+			}
+
+			ASSERT_EQ(ref_get_sequence(gfa, r, hap_len, 2, &buf[0]),
+				  ERROR_CODE_OUT_OF_BOUNDS);
+			ASSERT_EQ(ref_get_sequence(gfa, r, 0, 1, &buf[0]),
+				  ERROR_CODE_OUT_OF_BOUNDS);
+		}
+
+		gfa_free(gfa);
+	}
+}
+
+TEST(WriteFasta, MatchesHaplotypes)
+{
+	const std::string out = testing::TempDir() + "liteseq_test.fa";
+
+	for (u32 threads : {1u, 4u}) {
+		gfa_config_cpp conf(LPA_GFA, true, true, false, threads);
+		gfa_props *gfa = gfa_new(&conf);
+		ASSERT_EQ(gfa->status, 0);
+
+		for (idx_t width : {0u, 60u, 7u}) {
+			std::string expected;
+			for (idx_t i = 0; i < gfa->ref_count; i++) {
+				const struct ref *r = get_ref(gfa, i);
+				std::string hap(get_hap_len(r) + 1, NULL_CHAR);
+				ref_get_haplotype(gfa, r, &hap[0]);
+				hap.pop_back();
+
+				expected += ">";
+				expected += get_tag(r);
+				expected += "\n";
+				size_t w = width ? width : hap.size();
+				for (size_t k = 0; k < hap.size(); k += w)
+					expected += hap.substr(k, w) + "\n";
+			}
+
+			ASSERT_EQ(gfa_write_fasta(gfa, out.c_str(), width),
+				  SUCCESS);
+			std::ifstream in(out, std::ios::binary);
+			std::stringstream written;
+			written << in.rdbuf();
+			ASSERT_EQ(written.str(), expected) << "width " << width;
+		}
+
+		gfa_free(gfa);
+	}
+
+	std::remove(out.c_str());
+}
+
+TEST(Components, LabelsByFirstVertex)
+{
+	gfa_config_cpp conf(COMPONENTS_GFA, false, false, false, 2);
+	gfa_props *gfa = gfa_new(&conf);
+	ASSERT_EQ(gfa->status, 0);
+
+	struct gfa_components *cc = gfa_connected_components(gfa);
+	ASSERT_NE(cc, nullptr);
+
+	// {1, 2} {3} {5} {6, 7, 8}, there is no vertex 0 or 4
+	const id_t expected[] = {NULL_ID, 0, 0, 1, NULL_ID, 2, 3, 3, 3};
+	ASSERT_EQ(gfa->vtx_arr_size, 9u);
+	for (id_t v = 0; v < gfa->vtx_arr_size; v++)
+		ASSERT_EQ(cc->comp_ids[v], expected[v]) << "vertex " << v;
+
+	const idx_t sizes[] = {2, 1, 1, 3};
+	ASSERT_EQ(cc->count, 4u);
+	for (idx_t c = 0; c < cc->count; c++)
+		ASSERT_EQ(cc->sizes[c], sizes[c]);
+
+	gfa_components_free(&cc);
+	ASSERT_EQ(cc, nullptr);
+	gfa_free(gfa);
+}
+
+TEST(Components, SameForAnyThreadCount)
+{
+	std::vector<id_t> first;
+	for (u32 threads : {1u, 4u, 7u}) {
+		gfa_config_cpp conf(LPA_GFA, false, false, false, threads);
+		gfa_props *gfa = gfa_new(&conf);
+		ASSERT_EQ(gfa->status, 0);
+
+		struct gfa_components *cc = gfa_connected_components(gfa);
+		ASSERT_NE(cc, nullptr);
+
+		// the two ends of every edge are in the same component
+		for (idx_t i = 0; i < gfa->l_line_count; i++)
+			ASSERT_EQ(cc->comp_ids[gfa->e[i].v1_id],
+				  cc->comp_ids[gfa->e[i].v2_id]);
+
+		idx_t total = 0;
+		for (idx_t c = 0; c < cc->count; c++)
+			total += cc->sizes[c];
+		ASSERT_EQ(total, gfa->s_line_count);
+
+		std::vector<id_t> ids(cc->comp_ids,
+				      cc->comp_ids + gfa->vtx_arr_size);
+		if (first.empty())
+			first = ids;
+		ASSERT_EQ(ids, first);
+
+		gfa_components_free(&cc);
+		gfa_free(gfa);
+	}
+}
+
+TEST(Coverage, DenseAndSparseAgree)
+{
+	gfa_config_cpp conf(LPA_GFA, true, true, false, 3);
+	gfa_props *gfa = gfa_new(&conf);
+	ASSERT_EQ(gfa->status, 0);
+
+	std::vector<idx_t> depth(gfa->vtx_arr_size);
+	std::vector<idx_t> haps(gfa->vtx_arr_size);
+	for (idx_t i = 0; i < gfa->ref_count; i++) {
+		const struct ref *r = get_ref(gfa, i);
+		std::vector<bool> seen(gfa->vtx_arr_size);
+		for (idx_t j = 0; j < get_step_count(r); j++) {
+			id_t v = get_walk_v_ids(r)[j];
+			depth[v]++;
+			if (!seen[v])
+				haps[v]++;
+			seen[v] = true;
+		}
+	}
+
+	for (bool sparse : {false, true}) {
+		struct gfa_coverage *cov = compute_coverage(gfa, sparse);
+		ASSERT_NE(cov, nullptr);
+		for (id_t v = 0; v < gfa->vtx_arr_size; v++) {
+			ASSERT_EQ(cov->depth[v], depth[v]);
+			ASSERT_EQ(cov->hap_count[v], haps[v]);
+		}
+		gfa_coverage_free(&cov);
+	}
+
+	gfa_free(gfa);
+}
+
+TEST(Coverage, DepthRuns)
+{
+	gfa_config_cpp conf(W_LINES_GFA, true, true);
+	gfa_props *gfa = gfa_new(&conf);
+	ASSERT_EQ(gfa->status, 0);
+
+	struct gfa_coverage *cov = gfa_compute_coverage(gfa);
+	ASSERT_NE(cov, nullptr);
+	ASSERT_EQ(cov->depth[1], 6u);
+	ASSERT_EQ(cov->depth[7], 3u);
+	ASSERT_EQ(cov->hap_count[2], 3u);
+
+	// short is G GGG T A C A over 1 4 5 6 7 9, all of which are in every
+	// ref but 7 which only the three short ones take
+	struct depth_run *runs;
+	idx_t run_count;
+	ASSERT_EQ(ref_depth_runs(cov, get_ref(gfa, 0), &runs, &run_count),
+		  SUCCESS);
+	ASSERT_EQ(run_count, 3u);
+	ASSERT_EQ(runs[0].len, 6u);
+	ASSERT_EQ(runs[0].depth, 6u);
+	ASSERT_EQ(runs[1].len, 1u);
+	ASSERT_EQ(runs[1].depth, 3u);
+	ASSERT_EQ(runs[2].len, 1u);
+	ASSERT_EQ(runs[2].depth, 6u);
+	free(runs);
+
+	gfa_coverage_free(&cov);
+	gfa_free(gfa);
+}
+
+TEST(GfaStats, CollectedWhileParsing)
+{
+	gfa_config_cpp conf(W_LINES_GFA, true, true, false, 0, true);
+	gfa_props *gfa = gfa_new(&conf);
+	ASSERT_EQ(gfa->status, 0);
+	const struct gfa_stats *st = gfa->stats;
+	ASSERT_NE(st, nullptr);
+
+	// G A GGG T A C A A
+	ASSERT_EQ(st->seg_count, 8u);
+	ASSERT_EQ(st->seg_total_len, 10u);
+	ASSERT_EQ(st->seg_min_len, 1u);
+	ASSERT_EQ(st->seg_max_len, 3u);
+	ASSERT_EQ(st->seg_n50, 1u);
+
+	// 1 and 9 are the ends of the bubble chain
+	ASSERT_EQ(st->edge_count, 9u);
+	ASSERT_EQ(st->self_loops, 0u);
+	ASSERT_EQ(st->tips, 2u);
+	ASSERT_EQ(st->isolated, 0u);
+	ASSERT_EQ(st->degree_hist[2], 6u);
+	ASSERT_EQ(st->degree_hist[3], 2u);
+
+	ASSERT_EQ(st->ref_count, 6u);
+	ASSERT_EQ(st->ref_total_steps, 39u);
+	ASSERT_EQ(st->ref_min_steps, 6u);
+	ASSERT_EQ(st->ref_max_steps, 7u);
+	ASSERT_EQ(st->ref_total_len, 51u);
+	ASSERT_EQ(st->ref_min_len, 8u);
+	ASSERT_EQ(st->ref_max_len, 9u);
+	ASSERT_EQ(st->ref_len_hist[3], 6u);
+
+	gfa_free(gfa);
+
+	// off by default
+	gfa_config_cpp plain(COMPONENTS_GFA);
+	gfa = gfa_new(&plain);
+	ASSERT_EQ(gfa->stats, nullptr);
+	gfa_free(gfa);
+
+	plain.inc_stats = true;
+	gfa = gfa_new(&plain);
+	ASSERT_EQ(gfa->stats->self_loops, 1u);
+	ASSERT_EQ(gfa->stats->isolated, 2u);
+	ASSERT_EQ(gfa->stats->seg_n50, 1u);
+	gfa_free(gfa);
+}
+
+TEST(Snapshot, RoundTrip)
+{
+	const std::string snap = testing::TempDir() + "liteseq_test.lqs";
+
+	gfa_config_cpp conf(LPA_GFA, true, true, true, 0, true);
+	gfa_props *gfa = gfa_new(&conf);
+	ASSERT_EQ(gfa->status, 0);
+	ASSERT_EQ(gfa_save_snapshot(gfa, snap.c_str()), SUCCESS);
+
+	gfa_props *loaded = gfa_load_snapshot(snap.c_str());
+	ASSERT_NE(loaded, nullptr);
+	ASSERT_EQ(loaded->status, 0);
+	ASSERT_EQ(loaded->version, gfa->version);
+	ASSERT_EQ(loaded->min_v_id, gfa->min_v_id);
+	ASSERT_EQ(loaded->max_v_id, gfa->max_v_id);
+	ASSERT_EQ(loaded->vtx_arr_size, gfa->vtx_arr_size);
+	ASSERT_EQ(loaded->s_line_count, gfa->s_line_count);
+	ASSERT_EQ(loaded->l_line_count, gfa->l_line_count);
+	ASSERT_EQ(loaded->ref_count, gfa->ref_count);
+
+	for (id_t v = 0; v < gfa->vtx_arr_size; v++) {
+		if (!gfa->v[v]) {
+			ASSERT_EQ(loaded->v[v], nullptr);
+			continue;
+		}
+		ASSERT_EQ(loaded->v[v]->id, gfa->v[v]->id);
+		ASSERT_STREQ(loaded->v[v]->seq, gfa->v[v]->seq);
+	}
+
+	for (idx_t i = 0; i < gfa->l_line_count; i++) {
+		ASSERT_EQ(loaded->e[i].v1_id, gfa->e[i].v1_id);
+		ASSERT_EQ(loaded->e[i].v2_id, gfa->e[i].v2_id);
+		ASSERT_EQ(loaded->e[i].v1_side, gfa->e[i].v1_side);
+		ASSERT_EQ(loaded->e[i].v2_side, gfa->e[i].v2_side);
+	}
+
+	for (idx_t i = 0; i < gfa->ref_count; i++) {
+		const struct ref *a = get_ref(gfa, i);
+		const struct ref *b = get_ref(loaded, i);
+		ASSERT_STREQ(get_tag(b), get_tag(a));
+		ASSERT_EQ(get_ref_id_type(b), get_ref_id_type(a));
+		ASSERT_EQ(get_sample_id(b), get_sample_id(a));
+		ASSERT_EQ(get_contig_id(b), get_contig_id(a));
+		ASSERT_EQ(get_hap_len(b), get_hap_len(a));
+
+		idx_t n = get_step_count(a);
+		ASSERT_EQ(get_step_count(b), n);
+		for (idx_t j = 0; j < n; j++) {
+			ASSERT_EQ(get_walk_v_ids(b)[j], get_walk_v_ids(a)[j]);
+			ASSERT_EQ(get_walk_strands(b)[j],
+				  get_walk_strands(a)[j]);
+			ASSERT_EQ(get_walk_loci(b)[j], get_walk_loci(a)[j]);
+		}
+
+		for (idx_t pos = 1; pos <= get_hap_len(a); pos += 97) {
+			struct ref_locus x, y;
+			ASSERT_EQ(ref_locate(a, pos, &x), SUCCESS);
+			ASSERT_EQ(ref_locate(b, pos, &y), SUCCESS);
+			ASSERT_EQ(y.step, x.step);
+			ASSERT_EQ(y.offset, x.offset);
+		}
+
+		ASSERT_EQ(find_ref_by_tag(loaded, get_tag(a)),
+			  find_ref_by_tag(gfa, get_tag(a)));
+	}
+
+	for (id_t v = 0; v < gfa->vtx_arr_size; v++) {
+		idx_t m, n;
+		const struct vtx_occ *x = get_vtx_occs(gfa, v, &m);
+		const struct vtx_occ *y = get_vtx_occs(loaded, v, &n);
+		ASSERT_EQ(n, m);
+		for (idx_t k = 0; k < n; k++) {
+			ASSERT_EQ(y[k].ref_idx, x[k].ref_idx);
+			ASSERT_EQ(y[k].step, x[k].step);
+		}
+	}
+
+	ASSERT_NE(loaded->stats, nullptr);
+	ASSERT_EQ(memcmp(loaded->stats, gfa->stats, sizeof(struct gfa_stats)),
+		  0);
+
+	gfa_free(loaded);
+	gfa_free(gfa);
+	std::remove(snap.c_str());
+}
+
+TEST(Snapshot, RejectsCorruption)
+{
+	const std::string snap = testing::TempDir() + "liteseq_test.lqs";
+
+	gfa_config_cpp conf(W_LINES_GFA, true, true);
+	gfa_props *gfa = gfa_new(&conf);
+	ASSERT_EQ(gfa->status, 0);
+	ASSERT_EQ(gfa_save_snapshot(gfa, snap.c_str()), SUCCESS);
+	gfa_free(gfa);
+
+	std::string bytes;
+	{
+		std::ifstream in(snap, std::ios::binary);
+		std::stringstream ss;
+		ss << in.rdbuf();
+		bytes = ss.str();
+	}
+
+	// flip a bit past the header
+	bytes[bytes.size() / 2] ^= 1;
+	{
+		std::ofstream out(snap, std::ios::binary | std::ios::trunc);
+		out << bytes;
+	}
+	ASSERT_EQ(gfa_load_snapshot(snap.c_str()), nullptr);
+
+	// and a truncated file
+	{
+		std::ofstream out(snap, std::ios::binary | std::ios::trunc);
+		out << bytes.substr(0, 16);
+	}
+	ASSERT_EQ(gfa_load_snapshot(snap.c_str()), nullptr);
+
+	ASSERT_EQ(gfa_load_snapshot("/nonexistent/liteseq.lqs"), nullptr);
+	std::remove(snap.c_str());
+}
+
+TEST(LineIndex, SidecarMatchesScan)
+{
+	const std::string fp = testing::TempDir() + "liteseq_test.gfa";
+	const std::string lqi = fp + ".lqi";
+	std::remove(lqi.c_str());
+
+	std::string text;
+	{
+		std::ifstream in(W_LINES_GFA, std::ios::binary);
+		std::stringstream ss;
+		ss << in.rdbuf();
+		text = ss.str();
+	}
+	{
+		std::ofstream out(fp, std::ios::binary | std::ios::trunc);
+		out << text;
+	}
+
+	auto load = [&](bool use_line_index) {
+		gfa_config_cpp conf(fp.c_str(), true, true);
+		conf.use_line_index = use_line_index;
+		gfa_props *gfa = gfa_new(&conf);
+		EXPECT_EQ(gfa->status, 0);
+		return gfa;
+	};
+
+	auto same = [](const gfa_props *a, const gfa_props *b) {
+		ASSERT_EQ(a->version, b->version);
+		ASSERT_EQ(a->min_v_id, b->min_v_id);
+		ASSERT_EQ(a->max_v_id, b->max_v_id);
+		ASSERT_EQ(a->s_line_count, b->s_line_count);
+		ASSERT_EQ(a->l_line_count, b->l_line_count);
+		ASSERT_EQ(a->p_line_count, b->p_line_count);
+		ASSERT_EQ(a->w_line_count, b->w_line_count);
+		for (idx_t i = 0; i < a->s_line_count; i++) {
+			ASSERT_EQ(a->s_lines[i].start - a->start,
+				  b->s_lines[i].start - b->start);
+			ASSERT_EQ(a->s_lines[i].len, b->s_lines[i].len);
+			ASSERT_EQ(a->s_lines[i].line_idx,
+				  b->s_lines[i].line_idx);
+		}
+		for (idx_t i = 0; i < a->ref_count; i++)
+			ASSERT_STREQ(get_tag(a->refs[i]), get_tag(b->refs[i]));
+	};
+
+	gfa_props *scanned = load(false);
+	ASSERT_FALSE(std::ifstream(lqi).good());
+
+	// the first load writes the sidecar, the second reads it
+	gfa_props *first = load(true);
+	ASSERT_TRUE(std::ifstream(lqi).good());
+	gfa_props *second = load(true);
+	same(scanned, first);
+	same(scanned, second);
+	gfa_free(first);
+	gfa_free(second);
+	gfa_free(scanned);
+
+	// a sidecar of an older version of the file is not used
+	{
+		std::ofstream out(fp, std::ios::binary | std::ios::app);
+		out << "P\textra\t1+,2+\t*\n";
+	}
+	gfa_props *grown = load(true);
+	scanned = load(false);
+	ASSERT_EQ(grown->p_line_count, scanned->p_line_count);
+	ASSERT_NE(find_ref_by_tag(grown, "extra"), NULL_IDX);
+	same(scanned, grown);
+	gfa_free(grown);
+	gfa_free(scanned);
+
+	std::remove(lqi.c_str());
+	std::remove(fp.c_str());
+}
+
+TEST(Refresh, ParsesAppendedLines)
+{
+	const std::string fp = testing::TempDir() + "liteseq_grow.gfa";
+	const std::string whole = testing::TempDir() + "liteseq_whole.gfa";
+
+	std::string text;
+	{
+		std::ifstream in(W_LINES_GFA, std::ios::binary);
+		std::stringstream ss;
+		ss << in.rdbuf();
+		text = ss.str();
+	}
+	auto write = [](const std::string &path, const std::string &s) {
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		out << s;
+	};
+	write(fp, text);
+
+	gfa_config_cpp conf(fp.c_str(), true, true, true, 0, true);
+	gfa_props *gfa = gfa_new(&conf);
+	ASSERT_EQ(gfa->status, 0);
+	ASSERT_EQ(gfa_refresh(gfa), SUCCESS); // nothing new
+
+	const struct ref *held = get_ref(gfa, 0);
+	const std::string held_tag = get_tag(held);
+	const vtx *held_vtx = gfa->v[4];
+
+	// the arrays and indexes a reader may hold as they were
+	ASSERT_EQ(gfa_ensure_adj(gfa), SUCCESS);
+	vtx **held_v = gfa->v;
+	const std::vector<vtx *> v_before(held_v, held_v + gfa->vtx_arr_size);
+	const edge *held_e = gfa->e;
+	const std::vector<edge> e_before(held_e, held_e + gfa->l_line_count);
+	struct ref **held_refs = gfa->refs;
+	const std::vector<struct ref *> refs_before(held_refs,
+						    held_refs + gfa->ref_count);
+	const idx_t *held_adj = gfa->adj_offsets;
+	const std::vector<idx_t> adj_before(held_adj,
+					    held_adj + gfa->vtx_arr_size + 1);
+	const u64 *held_occ = gfa->occ_offsets;
+	const std::vector<u64> occ_before(held_occ,
+					  held_occ + gfa->vtx_arr_size + 1);
+	const struct gfa_stats *held_stats = gfa->stats;
+	const struct gfa_stats stats_before = *held_stats;
+
+	auto same_as_fresh = [&](const std::string &complete) {
+		write(whole, complete);
+		gfa_config wc = conf;
+		wc.fp = whole.c_str();
+		gfa_props *fresh = gfa_new(&wc);
+		ASSERT_EQ(fresh->status, 0);
+
+		ASSERT_EQ(gfa->vtx_arr_size, fresh->vtx_arr_size);
+		ASSERT_EQ(gfa->s_line_count, fresh->s_line_count);
+		ASSERT_EQ(gfa->ref_count, fresh->ref_count);
+		for (id_t v = 0; v < fresh->vtx_arr_size; v++) {
+			if (!fresh->v[v]) {
+				ASSERT_EQ(gfa->v[v], nullptr);
+				continue;
+			}
+			ASSERT_STREQ(gfa->v[v]->seq, fresh->v[v]->seq);
+
+			idx_t m, n;
+			get_vtx_occs(gfa, v, &m);
+			get_vtx_occs(fresh, v, &n);
+			ASSERT_EQ(m, n) << "vertex " << v;
+		}
+
+		ASSERT_EQ(gfa->l_line_count, fresh->l_line_count);
+		for (idx_t i = 0; i < fresh->l_line_count; i++) {
+			ASSERT_EQ(gfa->e[i].v1_id, fresh->e[i].v1_id);
+			ASSERT_EQ(gfa->e[i].v2_id, fresh->e[i].v2_id);
+		}
+
+		// the refs of the tail come after the W lines that were there
+		for (idx_t i = 0; i < fresh->ref_count; i++) {
+			const struct ref *a = get_ref(fresh, i);
+			idx_t j = find_ref_by_tag(gfa, get_tag(a));
+			ASSERT_NE(j, NULL_IDX) << get_tag(a);
+			const struct ref *b = get_ref(gfa, j);
+			ASSERT_EQ(get_hap_len(b), get_hap_len(a));
+			ASSERT_EQ(get_step_count(b), get_step_count(a));
+			for (idx_t k = 0; k < get_step_count(a); k++)
+				ASSERT_EQ(get_walk_loci(b)[k],
+					  get_walk_loci(a)[k]);
+		}
+
+		ASSERT_EQ(memcmp(gfa->stats, fresh->stats,
+				 sizeof(struct gfa_stats)),
+			  0);
+		gfa_free(fresh);
+	};
+
+	// a new vertex, an edge to it and a path through it, then half a line
+	const std::string tail = "S\t10\tTT\n"
+				 "L\t9\t+\t10\t+\t0M\n"
+				 "P\tgrown\t1+,4+,5+,6+,7+,9+,10+\t*\n";
+	const std::string part = "P\tpart\t1+,2+";
+	{
+		std::ofstream out(fp, std::ios::binary | std::ios::app);
+		out << tail << part;
+	}
+	ASSERT_EQ(gfa_refresh(gfa), SUCCESS);
+	same_as_fresh(text + tail);
+	ASSERT_EQ(find_ref_by_tag(gfa, "part"), NULL_IDX);
+
+	// swapped for new ones, the old ones are left alone until gfa_free
+	ASSERT_NE(gfa->v, held_v);
+	ASSERT_NE(gfa->e, held_e);
+	ASSERT_NE(gfa->refs, held_refs);
+	ASSERT_NE(gfa->adj_offsets, held_adj);
+	ASSERT_NE(gfa->adj_offsets, nullptr);
+	ASSERT_NE(gfa->occ_offsets, held_occ);
+	ASSERT_NE(gfa->stats, held_stats);
+	ASSERT_TRUE(std::equal(v_before.begin(), v_before.end(), held_v));
+	ASSERT_EQ(memcmp(e_before.data(), held_e,
+			 sizeof(edge) * e_before.size()),
+		  0);
+	ASSERT_TRUE(
+		std::equal(refs_before.begin(), refs_before.end(), held_refs));
+	ASSERT_TRUE(
+		std::equal(adj_before.begin(), adj_before.end(), held_adj));
+	ASSERT_TRUE(
+		std::equal(occ_before.begin(), occ_before.end(), held_occ));
+	ASSERT_EQ(memcmp(&stats_before, held_stats, sizeof(stats_before)), 0);
+
+	// the rest of the line
+	{
+		std::ofstream out(fp, std::ios::binary | std::ios::app);
+		out << ",4+\t*\n";
+	}
+	ASSERT_EQ(gfa_refresh(gfa), SUCCESS);
+	same_as_fresh(text + tail + part + ",4+\t*\n");
+	ASSERT_NE(find_ref_by_tag(gfa, "part"), NULL_IDX);
+
+	// what was handed out before is untouched
+	ASSERT_EQ(get_ref(gfa, 0), held);
+	ASSERT_EQ(get_tag(held), held_tag);
+	ASSERT_EQ(gfa->v[4], held_vtx);
+	ASSERT_STREQ(held_vtx->seq, "GGG");
+
+	gfa_free(gfa);
+
+	// a file that shrank is refused
+	write(fp, text);
+	gfa = gfa_new(&conf);
+	write(fp, text.substr(0, text.size() / 2));
+	ASSERT_NE(gfa_refresh(gfa), SUCCESS);
+	gfa_free(gfa);
+
+	std::remove(fp.c_str());
+	std::remove(whole.c_str());
+}
+
+static std::string read_file(const std::string &path)
+{
+	std::ifstream in(path, std::ios::binary);
+	std::stringstream ss;
+	ss << in.rdbuf();
+	return ss.str();
+}
+
+TEST(GfaWrite, RoundTripsCanonicalInput)
+{
+	const std::string in = testing::TempDir() + "liteseq_canon.gfa";
+	const std::string out = testing::TempDir() + "liteseq_out.gfa";
+
+	for (const char *fp : {W_LINES_GFA, REV_STRANDS_GFA, COMPONENTS_GFA}) {
+		// the test data with a single * for the overlaps of P lines
+		std::stringstream canon;
+		std::istringstream lines(read_file(fp));
+		for (std::string l; std::getline(lines, l);) {
+			if (l[0] == 'P')
+				l = l.substr(0, l.rfind('\t')) + "\t*";
+			canon << l << "\n";
+		}
+		{
+			std::ofstream o(in, std::ios::binary | std::ios::trunc);
+			o << canon.str();
+		}
+
+		for (u32 threads : {1u, 3u}) {
+			gfa_config_cpp conf(in.c_str(), true, true, false,
+					    threads);
+			gfa_props *gfa = gfa_new(&conf);
+			ASSERT_EQ(gfa->status, 0);
+			ASSERT_EQ(gfa_write(gfa, out.c_str(), NULL), SUCCESS);
+			ASSERT_EQ(read_file(out), canon.str()) << fp;
+			gfa_free(gfa);
+		}
+	}
+
+	std::remove(in.c_str());
+	std::remove(out.c_str());
+}
+
+TEST(GfaWrite, ReparsesToTheSameGraph)
+{
+	const std::string out = testing::TempDir() + "liteseq_out.gfa";
+	const std::string again = testing::TempDir() + "liteseq_again.gfa";
+
+	gfa_config_cpp conf(LPA_GFA, true, true, false, 4);
+	gfa_props *gfa = gfa_new(&conf);
+	ASSERT_EQ(gfa->status, 0);
+	ASSERT_EQ(gfa_write(gfa, out.c_str(), NULL), SUCCESS);
+
+	conf.fp = out.c_str();
+	gfa_props *re = gfa_new(&conf);
+	ASSERT_EQ(re->status, 0);
+	ASSERT_EQ(re->vtx_arr_size, gfa->vtx_arr_size);
+	ASSERT_EQ(re->l_line_count, gfa->l_line_count);
+	ASSERT_EQ(re->ref_count, gfa->ref_count);
+	for (id_t v = 0; v < gfa->vtx_arr_size; v++) {
+		if (gfa->v[v])
+			ASSERT_STREQ(re->v[v]->seq, gfa->v[v]->seq);
+		else
+			ASSERT_EQ(re->v[v], nullptr);
+	}
+	for (idx_t i = 0; i < gfa->l_line_count; i++) {
+		ASSERT_EQ(re->e[i].v1_id, gfa->e[i].v1_id);
+		ASSERT_EQ(re->e[i].v1_side, gfa->e[i].v1_side);
+		ASSERT_EQ(re->e[i].v2_id, gfa->e[i].v2_id);
+		ASSERT_EQ(re->e[i].v2_side, gfa->e[i].v2_side);
+	}
+	for (idx_t i = 0; i < gfa->ref_count; i++) {
+		const struct ref *a = get_ref(gfa, i);
+		const struct ref *b = get_ref(re, i);
+		ASSERT_STREQ(get_tag(b), get_tag(a));
+		ASSERT_EQ(get_step_count(b), get_step_count(a));
+		ASSERT_EQ(get_hap_len(b), get_hap_len(a));
+	}
+
+	// and the second write is the first
+	ASSERT_EQ(gfa_write(re, again.c_str(), NULL), SUCCESS);
+	ASSERT_EQ(read_file(again), read_file(out));
+	gfa_free(re);
+
+	// only the segments
+	struct gfa_write_opts opts = {false, false};
+	ASSERT_EQ(gfa_write(gfa, out.c_str(), &opts), SUCCESS);
+	std::istringstream lines(read_file(out));
+	idx_t s_lines = 0;
+	for (std::string l; std::getline(lines, l);) {
+		ASSERT_TRUE(l[0] == 'H' || l[0] == 'S') << l;
+		s_lines += l[0] == 'S';
+	}
+	ASSERT_EQ(s_lines, gfa->s_line_count);
+	gfa_free(gfa);
+
+	std::remove(out.c_str());
+	std::remove(again.c_str());
+}
+
+// a chain of n segments with ref_count paths over its first 64 segments
+static void write_chain_gfa(const std::string &fp, id_t n, idx_t ref_count)
+{
+	std::ofstream out(fp, std::ios::binary | std::ios::trunc);
+	out << "H\tVN:Z:1.0\n";
+	for (id_t v = 1; v <= n; v++)
+		out << "S\t" << v << "\tACGT\n";
+	for (id_t v = 1; v < n; v++)
+		out << "L\t" << v << "\t+\t" << v + 1 << "\t+\t0M\n";
+	for (idx_t r = 0; r < ref_count; r++) {
+		out << "P\tp" << r << "\t";
+		for (id_t v = 1; v <= 64; v++)
+			out << (v > 1 ? "," : "") << v << "+";
+		out << "\t*\n";
+	}
+}
+
+TEST(AsyncLoad, MatchesGfaNew)
+{
+	gfa_config_cpp conf(LPA_GFA, true, true, true);
+	struct gfa_load *load = gfa_new_async(&conf);
+	ASSERT_NE(load, nullptr);
+	gfa_props *gfa = gfa_load_wait(&load);
+	ASSERT_EQ(load, nullptr);
+	ASSERT_NE(gfa, nullptr);
+	ASSERT_EQ(gfa->status, 0);
+	ASSERT_EQ(gfa->load, nullptr);
+
+	gfa_props *sync = gfa_new(&conf);
+	ASSERT_EQ(gfa->s_line_count, sync->s_line_count);
+	ASSERT_EQ(gfa->l_line_count, sync->l_line_count);
+	ASSERT_EQ(gfa->ref_count, sync->ref_count);
+	for (idx_t i = 0; i < gfa->ref_count; i++)
+		ASSERT_EQ(get_hap_len(get_ref(gfa, i)),
+			  get_hap_len(get_ref(sync, i)));
+	gfa_free(sync);
+	gfa_free(gfa);
+}
+
+TEST(AsyncLoad, ReportsProgressAndCancels)
+{
+	const std::string fp = testing::TempDir() + "liteseq_chain.gfa";
+	write_chain_gfa(fp, 200000, 2000);
+
+	gfa_config_cpp conf(fp.c_str(), true, true, true, 0, true);
+
+	// to the end, watching the progress only ever grow
+	struct gfa_load *load = gfa_new_async(&conf);
+	ASSERT_NE(load, nullptr);
+	struct gfa_progress prev = {}, p = {};
+	while (!gfa_load_poll(load)) {
+		gfa_load_progress(load, &p);
+		ASSERT_GE(p.stage, prev.stage);
+		ASSERT_GE(p.bytes_scanned, prev.bytes_scanned);
+		ASSERT_GE(p.s_lines_parsed, prev.s_lines_parsed);
+		ASSERT_GE(p.refs_parsed, prev.refs_parsed);
+		prev = p;
+	}
+	gfa_load_progress(load, &p);
+	ASSERT_EQ(p.stage, GFA_LOAD_DONE);
+	ASSERT_EQ(p.bytes_scanned, p.file_size);
+	ASSERT_EQ(p.line_count, 200000u + 199999u + 2000u);
+	ASSERT_EQ(p.lines_indexed, p.line_count);
+	ASSERT_EQ(p.s_lines_parsed, 200000u);
+	ASSERT_EQ(p.l_lines_parsed, 199999u);
+	ASSERT_EQ(p.refs_parsed, 2000u);
+	gfa_props *gfa = gfa_load_wait(&load);
+	ASSERT_NE(gfa, nullptr);
+	ASSERT_EQ(gfa->status, 0);
+	gfa_free(gfa);
+
+	// cancelled before the workers get going
+	load = gfa_new_async(&conf);
+	gfa_load_cancel(load);
+	ASSERT_EQ(gfa_load_wait(&load), nullptr);
+
+	// cancelled at each stage, the load is either cut short or done
+	for (int stage = GFA_LOAD_SCAN; stage < GFA_LOAD_DONE; stage++) {
+		load = gfa_new_async(&conf);
+		do
+			gfa_load_progress(load, &p);
+		while (p.stage < stage);
+		gfa_load_cancel(load);
+		gfa = gfa_load_wait(&load);
+		if (gfa) {
+			ASSERT_EQ(gfa->status, 0);
+			gfa_free(gfa);
+		}
+	}
+
+	std::remove(fp.c_str());
+}
+
+TEST(AsyncLoad, PhasesAreUsableInOrder)
+{
+	const std::string fp = testing::TempDir() + "liteseq_phases.gfa";
+	write_chain_gfa(fp, 100000, 4000);
+
+	gfa_config_cpp conf(fp.c_str(), true, true, true);
+	struct gfa_load *load = gfa_new_async(&conf);
+	ASSERT_NE(load, nullptr);
+	gfa_props *gfa = gfa_load_graph(load);
+
+	ASSERT_EQ(gfa_wait(gfa, GFA_PHASE_VERTICES), SUCCESS);
+	for (id_t v = 1; v <= 100000; v++)
+		ASSERT_STREQ(gfa->v[v]->seq, "ACGT");
+
+	ASSERT_EQ(gfa_wait(gfa, GFA_PHASE_EDGES), SUCCESS);
+	for (idx_t i = 0; i < gfa->l_line_count; i++)
+		ASSERT_EQ(gfa->e[i].v2_id, gfa->e[i].v1_id + 1);
+
+	ASSERT_EQ(gfa_wait(gfa, GFA_PHASE_REFS), SUCCESS);
+	ASSERT_EQ(find_ref_by_tag(gfa, "p3999"), 3999u);
+	ASSERT_EQ(get_step_count(get_ref(gfa, 7)), 64u);
+
+	ASSERT_EQ(gfa_wait(gfa, GFA_PHASE_LOCI), SUCCESS);
+	ASSERT_EQ(get_hap_len(get_ref(gfa, 7)), 64u * 4);
+
+	ASSERT_EQ(gfa_wait(gfa, GFA_PHASE_ALL), SUCCESS);
+	idx_t n = 0;
+	get_vtx_occs(gfa, 1, &n);
+	ASSERT_EQ(n, 4000u);
+	ASSERT_EQ(gfa_load_wait(&load), gfa);
+	ASSERT_EQ(gfa_wait(gfa, GFA_PHASE_REFS), SUCCESS);
+	gfa_free(gfa);
+
+	// a cancelled load wakes its waiters with the status
+	load = gfa_new_async(&conf);
+	gfa = gfa_load_graph(load);
+	gfa_load_cancel(load);
+	ASSERT_EQ(gfa_wait(gfa, GFA_PHASE_VERTICES), ERROR_CODE_CANCELLED);
+	ASSERT_EQ(gfa_load_wait(&load), nullptr);
+
+	// a synchronous load is all done
+	gfa = gfa_new(&conf);
+	for (int phase = 0; phase < GFA_PHASE_COUNT; phase++)
+		ASSERT_EQ(gfa_wait(gfa, (enum gfa_phase)phase), SUCCESS);
+	gfa_free(gfa);
+
+	std::remove(fp.c_str());
+}
+
+static void expect_same_graph(gfa_props *a, gfa_props *b)
+{
+	ASSERT_EQ(a->status, 0);
+	ASSERT_EQ(a->v_lo, b->v_lo);
+	ASSERT_EQ(a->vtx_arr_size, b->vtx_arr_size);
+	ASSERT_EQ(a->l_line_count, b->l_line_count);
+	ASSERT_EQ(a->ref_count, b->ref_count);
+	for (id_t v = 0; v < b->vtx_arr_size; v++) {
+		if (!b->v[v]) {
+			ASSERT_EQ(a->v[v], nullptr);
+			continue;
+		}
+		ASSERT_EQ(a->v[v]->id, b->v[v]->id);
+		if (b->inc_vtx_labels) {
+			ASSERT_STREQ(a->v[v]->seq, b->v[v]->seq);
+		}
+	}
+	for (idx_t i = 0; i < b->l_line_count; i++) {
+		ASSERT_EQ(a->e[i].v1_id, b->e[i].v1_id);
+		ASSERT_EQ(a->e[i].v2_id, b->e[i].v2_id);
+		ASSERT_EQ(a->e[i].v1_side, b->e[i].v1_side);
+		ASSERT_EQ(a->e[i].v2_side, b->e[i].v2_side);
+	}
+	for (idx_t i = 0; i < b->ref_count && b->inc_refs; i++) {
+		struct ref *ra = get_ref(a, i);
+		struct ref *rb = get_ref(b, i);
+		ASSERT_STREQ(get_tag(ra), get_tag(rb));
+		ASSERT_EQ(get_step_count(ra), get_step_count(rb));
+		ASSERT_EQ(get_hap_len(ra), get_hap_len(rb));
+		ASSERT_EQ(find_ref_by_tag(a, get_tag(rb)),
+			  find_ref_by_tag(b, get_tag(rb)));
+	}
+	if (b->stats) {
+		ASSERT_NE(a->stats, nullptr);
+		ASSERT_EQ(a->stats->seg_total_len, b->stats->seg_total_len);
+		ASSERT_EQ(a->stats->seg_n50, b->stats->seg_n50);
+		ASSERT_EQ(a->stats->tips, b->stats->tips);
+		ASSERT_EQ(a->stats->self_loops, b->stats->self_loops);
+		ASSERT_EQ(a->stats->ref_total_len, b->stats->ref_total_len);
+	}
+	if (b->occ_offsets) {
+		idx_t n = 0, m = 0;
+		for (id_t v = b->v_lo; v - b->v_lo < b->vtx_arr_size; v++) {
+			get_vtx_occs(a, v, &n);
+			get_vtx_occs(b, v, &m);
+			ASSERT_EQ(n, m);
+		}
+	}
+}
+
+TEST(BatchLoad, MatchesGfaNewUnderAnyBudget)
+{
+	const std::string big = testing::TempDir() + "liteseq_batch_big.gfa";
+	const std::string mid = testing::TempDir() + "liteseq_batch_mid.gfa";
+	// more S and L lines than fit in one parse task
+	write_chain_gfa(big, 150000, 300);
+	write_chain_gfa(mid, 5000, 40);
+
+	const char *fps[] = {W_LINES_GFA, big.c_str(), LPA_GFA,
+			     mid.c_str(), REV_STRANDS_GFA, COMPONENTS_GFA};
+	const idx_t count = sizeof(fps) / sizeof(fps[0]);
+
+	for (bool inc_stats : {false, true}) {
+		std::vector<gfa_config> confs;
+		for (const char *fp : fps) {
+			gfa_config_cpp c(fp, true, true, true, 0, inc_stats);
+			confs.push_back(c);
+		}
+
+		std::vector<gfa_props *> want;
+		for (const gfa_config &c : confs)
+			want.push_back(gfa_new(&c));
+
+		const struct gfa_batch_opts budgets[] = {
+			{0, 0},
+			{3, 1}, // one at a time
+			{1, 0},
+		};
+		for (const struct gfa_batch_opts &opts : budgets) {
+			std::vector<gfa_props *> got(count, nullptr);
+			ASSERT_EQ(gfa_new_batch(confs.data(), count, &opts,
+						got.data()),
+				  SUCCESS);
+			for (idx_t i = 0; i < count; i++) {
+				SCOPED_TRACE(fps[i]);
+				expect_same_graph(got[i], want[i]);
+				gfa_free(got[i]);
+			}
+		}
+
+		for (gfa_props *g : want)
+			gfa_free(g);
+	}
+
+	ASSERT_EQ(gfa_new_batch(NULL, 0, NULL, NULL),
+		  ERROR_CODE_INVALID_ARGUMENT);
+
+	std::remove(big.c_str());
+	std::remove(mid.c_str());
+}
+
+// the tags of the refs a filter lets through
+static std::vector<std::string> filtered_tags(const char *fp,
+					      const struct ref_filter *filter)
+{
+	gfa_config_cpp conf(fp, true, true, true, 0, true);
+	conf.ref_filter = filter;
+	gfa_props *gfa = gfa_new(&conf);
+	EXPECT_EQ(gfa->status, 0);
+
+	std::vector<std::string> tags;
+	for (idx_t i = 0; i < gfa->ref_count; i++) {
+		const struct ref *r = get_ref(gfa, i);
+		tags.push_back(get_tag(r));
+		EXPECT_EQ(find_ref_by_tag(gfa, get_tag(r)), i);
+		EXPECT_GT(get_hap_len(r), 0u);
+	}
+	EXPECT_EQ(gfa->stats->ref_count, gfa->ref_count);
+	gfa_free(gfa);
+
+	return tags;
+}
+
+static bool keep_p_name(const struct ref_names *n, void *data)
+{
+	return n->name && std::string(n->name, n->name_len) ==
+				  static_cast<const char *>(data);
+}
+
+static bool keep_short_walks(const struct ref_names *n, void *data)
+{
+	(*(int *)data)++;
+	return n->line_prefix == W_LINE && n->sample_len == 5 &&
+	       std::string(n->sample, n->sample_len) == "short";
+}
+
+TEST(RefFilter, SelectsOnTheNames)
+{
+	const std::string fp = testing::TempDir() + "liteseq_filter.gfa";
+	{
+		std::ofstream out(fp, std::ios::binary | std::ios::trunc);
+		out << "H\tVN:Z:1.1\n"
+		    << "S\t1\tAC\nS\t2\tG\nS\t3\tTTT\n"
+		    << "L\t1\t+\t2\t+\t0M\nL\t2\t+\t3\t+\t0M\n"
+		    << "P\tHG1#1#chr1\t1+,2+,3+\t*\n"
+		    << "P\tHG1#2#chr1\t1+,3+\t*\n"
+		    << "P\tHG2#1#chr2\t2+,3+\t*\n"
+		    << "P\tHG1\t1+\t*\n"
+		    << "W\tHG2\t1\tchr1\t0\t6\t>1>2>3\n"
+		    << "W\tHG3\t0\tchr2\t0\t4\t>2<3\n"
+		    << "W\tHG10\t12\tchr1\t0\t2\t>1\n";
+	}
+	using tags = std::vector<std::string>;
+
+	ASSERT_EQ(filtered_tags(fp.c_str(), NULL).size(), 7u);
+
+	struct ref_filter f = {};
+	f.sample = "HG1";
+	ASSERT_EQ(filtered_tags(fp.c_str(), &f),
+		  (tags{"HG1#1#chr1", "HG1#2#chr1", "HG1"}));
+
+	f = {};
+	f.contig = "chr1";
+	ASSERT_EQ(filtered_tags(fp.c_str(), &f),
+		  (tags{"HG1#1#chr1", "HG1#2#chr1", "HG2#1#chr1",
+			"HG10#12#chr1"}));
+
+	f = {};
+	f.by_hap_id = true;
+	f.hap_id = 1;
+	f.contig = "chr1";
+	ASSERT_EQ(filtered_tags(fp.c_str(), &f),
+		  (tags{"HG1#1#chr1", "HG2#1#chr1"}));
+
+	// the tags of W lines are built from three columns
+	f = {};
+	f.tag_prefix = "HG1";
+	ASSERT_EQ(filtered_tags(fp.c_str(), &f),
+		  (tags{"HG1#1#chr1", "HG1#2#chr1", "HG1", "HG10#12#chr1"}));
+	f.tag_prefix = "HG10#1";
+	ASSERT_EQ(filtered_tags(fp.c_str(), &f), (tags{"HG10#12#chr1"}));
+	f.tag_prefix = "HG2#1#chr1";
+	ASSERT_EQ(filtered_tags(fp.c_str(), &f), (tags{"HG2#1#chr1"}));
+	f.tag_prefix = "HG2#1#chr1x";
+	ASSERT_EQ(filtered_tags(fp.c_str(), &f), (tags{}));
+
+	// the whole name of a P line, W lines have none
+	f = {};
+	f.keep = keep_p_name;
+	f.data = const_cast<char *>("HG1#2#chr1");
+	ASSERT_EQ(filtered_tags(fp.c_str(), &f), (tags{"HG1#2#chr1"}));
+
+	int calls = 0;
+	f = {};
+	f.keep = keep_short_walks;
+	f.data = &calls;
+	ASSERT_EQ(filtered_tags(W_LINES_GFA, &f),
+		  (tags{"short#1#chr", "short#2#chr"}));
+	ASSERT_EQ(calls, 6);
+
+	// the filter holds for the lines refresh parses too
+	f = {};
+	f.sample = "HG3";
+	gfa_config_cpp conf(fp.c_str(), true, true);
+	conf.ref_filter = &f;
+	gfa_props *gfa = gfa_new(&conf);
+	ASSERT_EQ(gfa->ref_count, 1u);
+	{
+		std::ofstream out(fp, std::ios::binary | std::ios::app);
+		out << "W\tHG3\t1\tchr1\t0\t1\t>2\nP\tHG4#0#chr1\t1+\t*\n";
+	}
+	ASSERT_EQ(gfa_refresh(gfa), SUCCESS);
+	ASSERT_EQ(gfa->ref_count, 2u);
+	ASSERT_STREQ(get_tag(get_ref(gfa, 1)), "HG3#1#chr1");
+	ASSERT_EQ(get_hap_len(get_ref(gfa, 1)), 1u);
+	gfa_free(gfa);
+
+	std::remove(fp.c_str());
+}
+
+static gfa_props *load_v_range(const char *fp, id_t v_lo, id_t v_hi)
+{
+	gfa_config_cpp conf(fp, true, true, true, 0, true);
+	conf.v_lo = v_lo;
+	conf.v_hi = v_hi;
+
+	return gfa_new(&conf);
+}
+
+// c of the partial graph part is the steps [first, end) of r of all
+static void expect_run(gfa_props *part, const struct ref *c, gfa_props *all,
+		       const struct ref *r, idx_t first, idx_t end)
+{
+	const id_t *v_ids = get_walk_v_ids(r);
+	const idx_t *loci = get_walk_loci(r);
+	idx_t hap_len = 0;
+	for (idx_t j = first; j < end; j++) {
+		ASSERT_EQ(get_walk_v_ids(c)[j - first], v_ids[j]);
+		ASSERT_EQ(get_walk_strands(c)[j - first],
+			  get_walk_strands(r)[j]);
+		ASSERT_EQ(get_walk_loci(c)[j - first],
+			  loci[j] - loci[first] + 1);
+		if (all->v[v_ids[j]])
+			hap_len += strlen(all->v[v_ids[j]]->seq);
+	}
+	ASSERT_EQ(get_hap_len(c), hap_len);
+	if (hap_len == 0)
+		return;
+
+	std::string want(hap_len + 1, '\0');
+	std::string got(hap_len + 1, '\0');
+	ASSERT_EQ(ref_get_sequence(all, r, loci[first], hap_len, want.data()),
+		  SUCCESS);
+	ASSERT_EQ(ref_get_haplotype(part, c, got.data()), SUCCESS);
+	ASSERT_STREQ(got.c_str(), want.c_str());
+}
+
+// a partial load holds what the whole graph holds in its range
+static void expect_partial_of(gfa_props *part, gfa_props *all)
+{
+	ASSERT_EQ(part->status, 0);
+	id_t lo = part->v_lo;
+	id_t hi = part->v_hi;
+	auto in_range = [&](id_t v) { return v >= lo && v < hi; };
+
+	idx_t s_count = 0;
+	for (id_t v = 0; v < all->vtx_arr_size; v++) {
+		const vtx *x = get_vtx(part, v);
+		if (!in_range(v) || !all->v[v]) {
+			ASSERT_EQ(x, nullptr);
+			continue;
+		}
+		ASSERT_NE(x, nullptr);
+		ASSERT_STREQ(x->seq, all->v[v]->seq);
+		s_count++;
+	}
+	ASSERT_EQ(part->s_line_count, s_count);
+	ASSERT_LE(part->vtx_arr_size, hi - lo);
+	ASSERT_EQ(part->stats->seg_count, s_count);
+
+	idx_t k = 0;
+	for (idx_t i = 0; i < all->l_line_count; i++) {
+		const edge *e = &all->e[i];
+		if (!in_range(e->v1_id) && !in_range(e->v2_id))
+			continue;
+		ASSERT_LT(k, part->l_line_count);
+		ASSERT_EQ(part->e[k].v1_id, e->v1_id);
+		ASSERT_EQ(part->e[k].v2_id, e->v2_id);
+		k++;
+	}
+	ASSERT_EQ(part->l_line_count, k);
+
+	// each run of steps in range is a ref of its own, with the bases of
+	// that stretch of the whole walk
+	k = 0;
+	for (idx_t i = 0; i < all->ref_count; i++) {
+		const struct ref *r = get_ref(all, i);
+		const id_t *v_ids = get_walk_v_ids(r);
+		idx_t n = get_step_count(r);
+		idx_t first_run = k;
+		for (idx_t first = 0; first < n;) {
+			if (!in_range(v_ids[first])) {
+				first++;
+				continue;
+			}
+			idx_t end = first + 1;
+			while (end < n && in_range(v_ids[end]))
+				end++;
+
+			const struct ref *c = get_ref(part, k);
+			ASSERT_NE(c, nullptr);
+			ASSERT_STREQ(get_tag(c), get_tag(r));
+			ASSERT_EQ(find_ref_by_tag(part, get_tag(r)), first_run);
+			ASSERT_EQ(get_first_step(c), first);
+			ASSERT_EQ(get_step_count(c), end - first);
+
+			expect_run(part, c, all, r, first, end);
+			k++;
+			first = end;
+		}
+	}
+	ASSERT_EQ(part->ref_count, k);
+
+	// the steps through a vertex in range are those of the whole graph
+	for (id_t v = lo; v < hi && v < all->vtx_arr_size; v++) {
+		idx_t n, m;
+		get_vtx_occs(part, v, &n);
+		get_vtx_occs(all, v, &m);
+		ASSERT_EQ(n, m);
+	}
+
+	// the runs of a walk count as one haplotype
+	struct gfa_coverage *ac = gfa_compute_coverage(all);
+	for (bool sparse : {false, true}) {
+		struct gfa_coverage *pc = compute_coverage(part, sparse);
+		ASSERT_NE(pc, nullptr);
+		for (id_t v = lo; v < hi && v < all->vtx_arr_size; v++) {
+			u32 slot = gfa_vtx_slot(part, v);
+			ASSERT_EQ(pc->depth[slot], ac->depth[v]);
+			ASSERT_EQ(pc->hap_count[slot], ac->hap_count[v]);
+		}
+		gfa_coverage_free(&pc);
+	}
+	gfa_coverage_free(&ac);
+
+	struct gfa_components *cc = gfa_connected_components(part);
+	ASSERT_NE(cc, nullptr);
+	idx_t total = 0;
+	for (idx_t c = 0; c < cc->count; c++)
+		total += cc->sizes[c];
+	ASSERT_EQ(total, s_count);
+	gfa_components_free(&cc);
+}
+
+TEST(PartialLoad, KeepsTheRangeAndWhatTouchesIt)
+{
+	for (const char *fp : {LPA_GFA, W_LINES_GFA}) {
+		gfa_props *all = load_v_range(fp, 0, 0);
+		ASSERT_EQ(all->v_lo, 0u);
+		id_t n = all->max_v_id;
+
+		const std::pair<id_t, id_t> ranges[] = {
+			{0, 0},		{1, n / 3},	{n / 3, 2 * n / 3},
+			{2 * n / 3, 0}, {n / 2, n / 2 + 1}, {n + 5, 0},
+		};
+		for (auto [lo, hi] : ranges) {
+			SCOPED_TRACE(std::to_string(lo) + ", " +
+				     std::to_string(hi));
+			gfa_props *part = load_v_range(fp, lo, hi);
+			expect_partial_of(part, all);
+			gfa_free(part);
+		}
+		gfa_free(all);
+	}
+
+	gfa_props *empty = load_v_range(W_LINES_GFA, 5, 5);
+	ASSERT_EQ(empty->status, ERROR_CODE_INVALID_ARGUMENT);
+	gfa_free(empty);
+}
+
+// the depth and the walks through vertex v of gfa
+static void expect_hap_counts(const gfa_props *gfa, id_t v, idx_t depth,
+			      idx_t hap_count)
+{
+	struct gfa_coverage *cov = gfa_compute_coverage(gfa);
+	ASSERT_NE(cov, nullptr);
+	EXPECT_EQ(cov->depth[gfa_vtx_slot(gfa, v)], depth);
+	EXPECT_EQ(cov->hap_count[gfa_vtx_slot(gfa, v)], hap_count);
+	gfa_coverage_free(&cov);
+}
+
+TEST(PartialLoad, SnapshotsRefreshesAndBatches)
+{
+	const std::string fp = testing::TempDir() + "liteseq_partial.gfa";
+	const std::string snap = testing::TempDir() + "liteseq_partial.lqs";
+	write_chain_gfa(fp, 5000, 12);
+	{ // a walk that leaves the range and comes back
+		std::ofstream out(fp, std::ios::binary | std::ios::app);
+		out << "P\tloop\t1500+,999+,1500-,1501+\t*\n";
+	}
+
+	gfa_props *part = load_v_range(fp.c_str(), 1000, 2000);
+	ASSERT_EQ(part->vtx_arr_size, 1000u);
+	ASSERT_EQ(part->s_line_count, 1000u);
+	ASSERT_EQ(part->l_line_count, 1001u); // with the edge in from 999
+	ASSERT_EQ(part->ref_count, 2u);
+	ASSERT_EQ(get_ref(part, 0)->id, get_ref(part, 1)->id);
+	expect_hap_counts(part, 1500, 2, 1);
+
+	// the batch loader takes the same range
+	gfa_config_cpp conf(fp.c_str(), true, true, true, 0, true);
+	conf.v_lo = 1000;
+	conf.v_hi = 2000;
+	gfa_props *batched = NULL;
+	ASSERT_EQ(gfa_new_batch(&conf, 1, NULL, &batched), SUCCESS);
+	expect_same_graph(batched, part);
+	gfa_free(batched);
+
+	ASSERT_EQ(gfa_save_snapshot(part, snap.c_str()), SUCCESS);
+	gfa_props *loaded = gfa_load_snapshot(snap.c_str());
+	ASSERT_NE(loaded, nullptr);
+	expect_same_graph(loaded, part);
+	ASSERT_EQ(get_vtx(loaded, 999), nullptr);
+	ASSERT_STREQ(get_vtx(loaded, 1500)->seq, "ACGT");
+	// the runs of loop still count as one walk
+	expect_hap_counts(loaded, 1500, 2, 1);
+	gfa_free(loaded);
+
+	int fd = gfa_publish_memfd(part);
+	ASSERT_NE(fd, -1);
+	for (int i = 0; i < 2; i++) { // in place, then moved
+		gfa_props *a = gfa_attach(fd);
+		ASSERT_NE(a, nullptr);
+		expect_hap_counts(a, 1500, 2, 1);
+		gfa_free(a);
+	}
+	close(fd);
+
+	// a partial graph is not written out
+	const std::string out = testing::TempDir() + "liteseq_partial.out";
+	ASSERT_EQ(gfa_write(part, out.c_str(), NULL),
+		  ERROR_CODE_INVALID_ARGUMENT);
+	ASSERT_EQ(gfa_write_fasta(part, out.c_str(), 0),
+		  ERROR_CODE_INVALID_ARGUMENT);
+
+	{
+		std::ofstream out(fp, std::ios::binary | std::ios::app);
+		out << "S\t9000\tAC\n"
+		    << "L\t1999\t+\t9000\t+\t0M\n"
+		    << "L\t9000\t+\t9001\t+\t0M\n"
+		    << "P\tfar\t9000+,9001+\t*\n"
+		    << "P\tnear\t9000+,1500-,9001+\t*\n"
+		    << "P\tgaps\t1500+,9000+,1501-,9001+,1502+\t*\n";
+	}
+	idx_t ref_count = part->ref_count;
+	ASSERT_EQ(gfa_refresh(part), SUCCESS);
+	ASSERT_EQ(part->vtx_arr_size, 1000u);
+	ASSERT_EQ(part->l_line_count, 1002u);
+	// more refs than lines, gaps is split in three
+	ASSERT_EQ(part->ref_count, ref_count + 4);
+	const struct ref *near = get_ref(part, ref_count);
+	ASSERT_STREQ(get_tag(near), "near");
+	ASSERT_EQ(get_step_count(near), 1u);
+	ASSERT_EQ(get_first_step(near), 1u);
+	ASSERT_EQ(get_hap_len(near), 4u);
+	for (idx_t i = 0; i < 3; i++) {
+		const struct ref *run = get_ref(part, ref_count + 1 + i);
+		ASSERT_STREQ(get_tag(run), "gaps");
+		ASSERT_EQ(get_step_count(run), 1u);
+		ASSERT_EQ(get_first_step(run), 2 * i);
+		ASSERT_EQ(get_hap_len(run), 4u);
+		char seq[5];
+		ASSERT_EQ(ref_get_haplotype(part, run, seq), SUCCESS);
+		ASSERT_STREQ(seq, "ACGT");
+	}
+	gfa_free(part);
+
+	std::remove(fp.c_str());
+	std::remove(snap.c_str());
+}
+
+TEST(SharedGraph, AttachesAcrossProcesses)
+{
+	gfa_config_cpp conf(LPA_GFA, true, true, true, 0, true);
+	gfa_props *gfa = gfa_new(&conf);
+	ASSERT_EQ(gfa->status, 0);
+
+	int fd = gfa_publish_memfd(gfa);
+	ASSERT_NE(fd, -1);
+
+	// the address the segment was written for is free again, so the graph
+	// is used in place
+	gfa_props *a = gfa_attach(fd);
+	ASSERT_NE(a, nullptr);
+	expect_same_graph(a, gfa);
+	const char *lo = (const char *)a->snapshot;
+	ASSERT_GE((const char *)a->v, lo);
+	ASSERT_LT((const char *)a->v, lo + a->snapshot_size);
+	struct ref_locus l;
+	ASSERT_EQ(ref_locate(get_ref(a, 0), 1, &l), SUCCESS);
+	ASSERT_EQ(l.step, 0u);
+
+	// the second one finds the address taken and moves the pointers
+	gfa_props *b = gfa_attach(fd);
+	ASSERT_NE(b, nullptr);
+	ASSERT_NE(b->snapshot, a->snapshot);
+	expect_same_graph(b, gfa);
+
+	pid_t pid = fork();
+	ASSERT_NE(pid, -1);
+	if (pid == 0) {
+		gfa_props *c = gfa_attach(fd);
+		if (c)
+			expect_same_graph(c, gfa);
+		_exit(c && !testing::Test::HasFailure() ? 0 : 1);
+	}
+	int child;
+	ASSERT_EQ(waitpid(pid, &child, 0), pid);
+	ASSERT_TRUE(WIFEXITED(child));
+	ASSERT_EQ(WEXITSTATUS(child), 0);
+
+	// sealed
+	char c = 0;
+	ASSERT_EQ(pwrite(fd, &c, 1, 0), -1);
+
+	gfa_free(b);
+	gfa_free(a);
+	close(fd);
+
+	// not a published graph
+	fd = open(LPA_GFA, O_RDONLY);
+	ASSERT_EQ(gfa_attach(fd), nullptr);
+	close(fd);
+
+	gfa_free(gfa);
+}
+
+TEST(SharedGraph, PublishesUnderAName)
+{
+	const std::string name = "/liteseq_test_" + std::to_string(getpid());
+
+	gfa_config_cpp conf(W_LINES_GFA, true, true);
+	gfa_props *gfa = gfa_new(&conf);
+	ASSERT_EQ(gfa->status, 0);
+	ASSERT_EQ(gfa_publish(gfa, name.c_str()), SUCCESS);
+
+	gfa_props *a = gfa_attach_shm(name.c_str());
+	ASSERT_NE(a, nullptr);
+	expect_same_graph(a, gfa);
+	for (idx_t i = 0; i < gfa->ref_count; i++) {
+		const struct ref *r = get_ref(a, i);
+		ASSERT_EQ(get_sample_id(r), get_sample_id(get_ref(gfa, i)));
+		ASSERT_EQ(get_hap_id(r), get_hap_id(get_ref(gfa, i)));
+	}
+
+	// those attached keep the graph once it is gone
+	ASSERT_EQ(gfa_unpublish(name.c_str()), SUCCESS);
+	ASSERT_EQ(gfa_attach_shm(name.c_str()), nullptr);
+	ASSERT_STREQ(get_tag(get_ref(a, 0)), get_tag(get_ref(gfa, 0)));
+	gfa_free(a);
+
+	ASSERT_EQ(gfa_unpublish(name.c_str()), FAILURE);
+	gfa_free(gfa);
+}
+
+// the output of print with fp, as a string
+static std::string metrics_output(const struct gfa_metrics *m,
+				  status_t (*print)(const struct gfa_metrics *,
+						    FILE *))
+{
+	char *buf = NULL;
+	size_t size = 0;
+	FILE *fp = open_memstream(&buf, &size);
+	EXPECT_EQ(print(m, fp), SUCCESS);
+	fclose(fp);
+	std::string out(buf, size);
+	free(buf);
+
+	return out;
+}
+
+TEST(LoadMetrics, CountsEachPhase)
+{
+	gfa_config_cpp conf(LPA_GFA, true, true, true, 2);
+	gfa_props *gfa = gfa_new(&conf);
+	ASSERT_EQ(gfa->status, 0);
+	const struct gfa_metrics *m = &gfa->metrics;
+	const struct gfa_phase_metrics *ph = m->phases;
+
+	ASSERT_EQ(m->file_size, gfa->file_size);
+	ASSERT_EQ(m->thread_count, 2u);
+	ASSERT_FALSE(m->line_index_hit);
+	ASSERT_EQ(ph[GFA_METRIC_MAP].bytes, gfa->file_size);
+	ASSERT_EQ(ph[GFA_METRIC_SCAN].bytes, gfa->file_size);
+	ASSERT_EQ(ph[GFA_METRIC_INDEX].lines,
+		  gfa->s_line_count + gfa->l_line_count + gfa->p_line_count +
+			  gfa->w_line_count);
+
+	ASSERT_EQ(ph[GFA_METRIC_S].lines, gfa->s_line_count);
+	ASSERT_EQ(ph[GFA_METRIC_L].lines, gfa->l_line_count);
+	ASSERT_EQ(ph[GFA_METRIC_REFS].lines,
+		  gfa->p_line_count + gfa->w_line_count);
+	ASSERT_EQ(ph[GFA_METRIC_LOCI].lines, gfa->ref_count);
+	ASSERT_LE(ph[GFA_METRIC_S].bytes + ph[GFA_METRIC_L].bytes +
+			  ph[GFA_METRIC_REFS].bytes,
+		  gfa->file_size);
+
+	// a vertex and its label for each S line
+	ASSERT_GE(ph[GFA_METRIC_S].allocs, 2u * gfa->s_line_count);
+	ASSERT_GT(ph[GFA_METRIC_REFS].allocs, 0u);
+	ASSERT_EQ(ph[GFA_METRIC_L].allocs, 0u);
+	ASSERT_EQ(ph[GFA_METRIC_OCC].threads, 2u);
+
+	for (int i = 0; i < GFA_METRIC_COUNT; i++) {
+		SCOPED_TRACE(to_string_gfa_metric((enum gfa_metric)i));
+		if (i == GFA_METRIC_STATS) { // no inc_stats
+			ASSERT_EQ(ph[i].threads, 0u);
+			ASSERT_EQ(ph[i].wall_ns, 0u);
+			continue;
+		}
+		ASSERT_GE(ph[i].threads, 1u);
+		ASSERT_GE(ph[i].start_ns, m->start_ns);
+		ASSERT_EQ(ph[i].wall_ns, ph[i].end_ns - ph[i].start_ns);
+		ASSERT_LE(ph[i].wall_ns, m->wall_ns);
+	}
+
+	std::string json = metrics_output(m, gfa_metrics_json);
+	ASSERT_EQ(json.front(), '{');
+	ASSERT_EQ(json.substr(json.size() - 3), "}}\n");
+	ASSERT_NE(json.find("\"s_lines\":{\"offset_ns\":"), std::string::npos);
+	ASSERT_NE(json.find("\"lines\":" +
+			    std::to_string(gfa->s_line_count) + ","),
+		  std::string::npos);
+	ASSERT_NE(json.find("\"stats\":{"), std::string::npos);
+
+	// the table skips the phases that did not run
+	std::string table = metrics_output(m, gfa_metrics_print);
+	ASSERT_EQ(table.rfind("phase", 0), 0u);
+	ASSERT_NE(table.find("\nocc_index "), std::string::npos);
+	ASSERT_EQ(table.find("\nstats "), std::string::npos);
+	ASSERT_NE(table.find("\ntotal "), std::string::npos);
+
+	// a batch adds up the tasks of each phase
+	gfa_props *b = NULL;
+	ASSERT_EQ(gfa_new_batch(&conf, 1, NULL, &b), SUCCESS);
+	for (int i = 0; i < GFA_METRIC_COUNT; i++) {
+		SCOPED_TRACE(to_string_gfa_metric((enum gfa_metric)i));
+		ASSERT_EQ(b->metrics.phases[i].lines, ph[i].lines);
+		ASSERT_EQ(b->metrics.phases[i].bytes, ph[i].bytes);
+	}
+	ASSERT_GT(b->metrics.wall_ns, 0u);
+	gfa_free(b);
+
+	gfa_free(gfa);
+}
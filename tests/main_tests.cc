@@ -2,5 +2,7 @@
 
 #include "./enums_tests.cc"
 #include "./gfa_tests.cc"
+#include "./gen_tests.cc"
 #include "./refs_tests.cc"
 #include "./utils_tests.cc"
+#include "./cpp_tests.cc"
@@ -37,15 +37,16 @@ pad_to_max(const std::initializer_list<T> &input)
 TEST(HapLen, SetsHapLen)
 {
 	const idx_t STEP_COUNT = 5;
-	struct ref_walk *rw = alloc_ref_walk(STEP_COUNT);
+	struct ref_walk *rw = alloc_ref_walk(STEP_COUNT, nullptr);
 
 	// set directly
 	rw->hap_len = 42;
 
 	const char *tokens[1] = {"sample#1#contig"};
-	struct ref_id *r_id = alloc_ref_id(tokens, P_LINE_ID_TOKEN_COUNT);
+	struct ref_id *r_id =
+		alloc_ref_id(tokens, P_LINE_ID_TOKEN_COUNT, nullptr, nullptr);
 
-	struct ref *r = alloc_ref(P_LINE, &rw, &r_id);
+	struct ref *r = alloc_ref(P_LINE, &rw, &r_id, nullptr);
 	ASSERT_EQ(get_hap_len(r), 42);
 
 	idx_t res = set_hap_len(r, 100);
@@ -59,7 +60,7 @@ TEST(HapLen, SetsHapLen)
 TEST(PanSNStruct, AllocAndFree)
 {
 	const char *tokens[PANSN_MAX_TOKENS] = {"sampleA", "0", "contig_5"};
-	struct pansn *pn = alloc_pansn(tokens);
+	struct pansn *pn = alloc_pansn(tokens, nullptr, nullptr);
 	ASSERT_NE(pn, nullptr);
 	ASSERT_STREQ(pn->sample_name, "sampleA");
 	ASSERT_EQ(pn->hap_id, 0);
@@ -86,7 +87,9 @@ TEST(ParsePanSNRefId, Valid)
 
 	for (idx_t i = 0; i < N; i++) {
 		// char *name = strdup(names[i]);
-		pansn *pn = try_extract_pansn_from_str(names[i], DELIM);
+		pansn *pn =
+			try_extract_pansn_from_str(names[i], DELIM, nullptr,
+						    nullptr);
 		ASSERT_NE(pn, nullptr);
 		ASSERT_STREQ(pn->sample_name, expected_samples[i]);
 		ASSERT_STREQ(pn->contig_name, expected_contigs[i]);
@@ -108,7 +111,9 @@ TEST(ParsePanSNRefId, Invalid)
 	// expected output: all should fail to parse
 	for (idx_t i = 0; i < N; i++) {
 		char *name = strdup(names[i]);
-		pansn *pn = try_extract_pansn_from_str(name, HASH_CHAR);
+		pansn *pn =
+			try_extract_pansn_from_str(name, HASH_CHAR, nullptr,
+						    nullptr);
 		ASSERT_EQ(pn, nullptr);
 	}
 }
@@ -117,7 +122,8 @@ TEST(AllocRefIdPLine, ValidPanSN)
 {
 	const char *name = "chm13#0#Chr1";
 	const char *tokens[1] = {name};
-	struct ref_id *r_id = alloc_ref_id(tokens, P_LINE_ID_TOKEN_COUNT);
+	struct ref_id *r_id =
+		alloc_ref_id(tokens, P_LINE_ID_TOKEN_COUNT, nullptr, nullptr);
 
 	ASSERT_NE(r_id, nullptr);
 	ASSERT_EQ(r_id->type, REF_ID_PANSN);
@@ -134,7 +140,8 @@ TEST(AllocRefIdPLine, ValidRaw)
 {
 	const char *name = "chm13__LPA__tig00000001";
 	const char *tokens[1] = {name};
-	struct ref_id *r_id = alloc_ref_id(tokens, P_LINE_ID_TOKEN_COUNT);
+	struct ref_id *r_id =
+		alloc_ref_id(tokens, P_LINE_ID_TOKEN_COUNT, nullptr, nullptr);
 
 	ASSERT_NE(r_id, nullptr);
 	ASSERT_EQ(r_id->type, REF_ID_RAW);
@@ -218,7 +225,7 @@ TEST(ParseDataLine, P_LINE)
 		const char *data_str = p_line_data_strs[i];
 		step_count = count_steps(P_LINE, data_str);
 		ASSERT_EQ(step_count, expected_step_counts[i]);
-		struct ref_walk *rw = alloc_ref_walk(step_count);
+		struct ref_walk *rw = alloc_ref_walk(step_count, nullptr);
 		ASSERT_NE(rw, nullptr);
 
 		status_t res = parse_data_line_p(data_str, &rw);
@@ -258,7 +265,8 @@ TEST(ParseDataLine, W_LINE)
 		expected_step_count = expected_step_counts[i];
 
 		ASSERT_EQ(computed_step_count, expected_step_count);
-		struct ref_walk *rw = alloc_ref_walk(expected_step_count);
+		struct ref_walk *rw =
+			alloc_ref_walk(expected_step_count, nullptr);
 		ASSERT_NE(rw, nullptr);
 
 		status_t res = parse_data_line_w(data_str, &rw);
@@ -274,12 +282,13 @@ TEST(ParseDataLine, W_LINE)
 TEST(AllocRef, Valid)
 {
 	const idx_t STEP_COUNT = 5;
-	struct ref_walk *rw = alloc_ref_walk(STEP_COUNT);
+	struct ref_walk *rw = alloc_ref_walk(STEP_COUNT, nullptr);
 
 	const char *tokens[1] = {"sample#1#contig"};
-	struct ref_id *r_id = alloc_ref_id(tokens, P_LINE_ID_TOKEN_COUNT);
+	struct ref_id *r_id =
+		alloc_ref_id(tokens, P_LINE_ID_TOKEN_COUNT, nullptr, nullptr);
 
-	struct ref *r = alloc_ref(P_LINE, &rw, &r_id);
+	struct ref *r = alloc_ref(P_LINE, &rw, &r_id, nullptr);
 	ASSERT_NE(r, nullptr);
 	ASSERT_EQ(r->line_prefix, P_LINE);
 	ASSERT_EQ(rw->step_count, STEP_COUNT);
@@ -421,13 +430,21 @@ TEST(Refs, AllocatesAndFrees)
 	refs = (struct ref **)malloc(sizeof(struct ref *) * ref_count);
 
 	ASSERT_NE(refs, nullptr);
+	const char *tokens[1] = {"sample#1#contig"};
 	for (idx_t i = 0; i < ref_count; i++) {
-		struct ref_walk *rw = alloc_ref_walk(step_count);
+		struct ref_walk *rw = alloc_ref_walk(step_count, nullptr);
 		ASSERT_NE(rw, nullptr);
+		struct ref_id *r_id =
+			alloc_ref_id(tokens, P_LINE_ID_TOKEN_COUNT, nullptr,
+				     nullptr);
+		ASSERT_NE(r_id, nullptr);
+		refs[i] = alloc_ref(P_LINE, &rw, &r_id, nullptr);
+		ASSERT_NE(refs[i], nullptr);
 	}
 
 	for (idx_t i = 0; i < ref_count; i++) {
 		destroy_ref(&refs[i]);
 		ASSERT_EQ(refs[i], nullptr);
 	}
+	free(refs);
 }
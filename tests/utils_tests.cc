@@ -1,7 +1,11 @@
 #include <gtest/gtest.h>
 
 #include <string>
+#include <vector>
 
+#include "../src/internal/lq_arena.h"
+#include "../src/internal/lq_dna.h"
+#include "../src/internal/lq_intern.h"
 #include "../src/internal/lq_utils.h"
 #include <liteseq/types.h>
 
@@ -39,7 +43,8 @@ TEST(Tokenise, Basic)
 		10,		      // max_tokens
 		tokens_found,	      // tokens_found
 		tokens,		      // tokens
-		nullptr		      // end
+		nullptr,	      // end
+		nullptr		      // arena
 	};
 
 	status_t res = split_str(&p);
@@ -78,7 +83,8 @@ TEST(Tokenise, NoDelim)
 		10,		      // max_tokens
 		tokens_found,	      // tokens_found
 		tokens,		      // tokens
-		nullptr		      // end
+		nullptr,	      // end
+		nullptr		      // arena
 	};
 
 	status_t res = split_str(&p);
@@ -120,7 +126,8 @@ TEST(Tokenise, SLine)
 		EXPECTED_S_LINE_TOKENS, // max_tokens
 		tokens_found,		// tokens_found
 		tokens,			// tokens
-		nullptr			// end
+		nullptr,		// end
+		nullptr			// arena
 	};
 
 	status_t res = split_str(&p);
@@ -130,3 +137,154 @@ TEST(Tokenise, SLine)
 		ASSERT_STREQ(p.tokens[i], out_tokens[i]);
 	}
 }
+
+TEST(Arena, AllocAndReset)
+{
+	struct lq_arena *a = lq_arena_new(1024);
+	ASSERT_NE(a, nullptr);
+
+	// small objects are bumped out of the same block and are aligned
+	char *x = (char *)lq_arena_alloc(a, 3);
+	char *y = (char *)lq_arena_alloc(a, 8);
+	ASSERT_NE(x, nullptr);
+	ASSERT_NE(y, nullptr);
+	ASSERT_EQ((uintptr_t)y % alignof(max_align_t), 0u);
+	ASSERT_EQ(a->block_count, 1u);
+
+	// large objects get a block of their own
+	char *big = (char *)lq_arena_alloc(a, 4096);
+	ASSERT_NE(big, nullptr);
+	memset(big, 'A', 4096);
+	ASSERT_EQ(a->block_count, 2u);
+
+	char *s = lq_arena_strndup(a, "ACGT\tTTT", 4);
+	ASSERT_STREQ(s, "ACGT");
+
+	lq_arena_reset(a);
+	ASSERT_EQ(a->block_count, 1u);
+
+	lq_arena_destroy(&a);
+	ASSERT_EQ(a, nullptr);
+}
+
+TEST(Tokenise, Arena)
+{
+	const char *input = "S\t12\tGATTACA";
+	char *tokens[MAX_TOKENS] = {NULL};
+	struct lq_arena *a = lq_arena_new(1024);
+
+	struct split_str_params p = {
+		input,	 // str
+		nullptr, // up_to
+		TAB_CHAR,
+		"",
+		0,
+		3,
+		0,
+		tokens,
+		nullptr,
+		a // arena
+	};
+
+	status_t res = split_str(&p);
+	ASSERT_EQ(res, SUCCESS);
+	ASSERT_EQ(p.tokens_found, 2u);
+	ASSERT_STREQ(tokens[0], "S");
+	ASSERT_STREQ(tokens[1], "12");
+
+	// tokens are owned by the arena
+	lq_arena_destroy(&a);
+}
+
+TEST(Intern, SameStringSameHandle)
+{
+	struct lq_intern *pool = lq_intern_new();
+	ASSERT_NE(pool, nullptr);
+
+	const char *a = nullptr;
+	const char *b = nullptr;
+	id_t h1 = lq_intern_str(pool, "chm13#0", 5, &a);
+	id_t h2 = lq_intern_str(pool, "HG002", 5, nullptr);
+	id_t h3 = lq_intern_str(pool, "chm13", 5, &b);
+
+	ASSERT_EQ(h1, 0u);
+	ASSERT_EQ(h2, 1u);
+	ASSERT_EQ(h1, h3);
+	ASSERT_EQ(a, b); // stored once
+	ASSERT_STREQ(lq_intern_get(pool, h1), "chm13");
+	ASSERT_EQ(lq_intern_find(pool, "HG002", 5), h2);
+	ASSERT_EQ(lq_intern_find(pool, "HG00", 4), NULL_ID);
+	ASSERT_EQ(lq_intern_get(pool, 7), nullptr);
+
+	lq_intern_destroy(&pool);
+	ASSERT_EQ(pool, nullptr);
+}
+
+TEST(Intern, Grows)
+{
+	struct lq_intern *pool = lq_intern_new();
+	const idx_t N = 1000;
+
+	for (idx_t i = 0; i < N; i++) {
+		std::string s = "sample_" + std::to_string(i);
+		ASSERT_EQ(lq_intern_str(pool, s.c_str(), s.size(), nullptr), i);
+	}
+
+	for (idx_t i = 0; i < N; i++) {
+		std::string s = "sample_" + std::to_string(i);
+		ASSERT_EQ(lq_intern_find(pool, s.c_str(), s.size()), i);
+		ASSERT_STREQ(lq_intern_get(pool, i), s.c_str());
+	}
+
+	lq_intern_destroy(&pool);
+}
+
+TEST(RevComp, MatchesScalar)
+{
+	const std::string alphabet = "ACGTNacgtnRYKMSWBDHVU";
+	std::string src;
+	unsigned seed = 7;
+	for (int i = 0; i < 200; i++) {
+		seed = seed * 1103515245 + 12345;
+		// mostly ACGT so that the SIMD path is taken
+		src += alphabet[(seed >> 16) % (i % 50 == 0 ? 21 : 8)];
+	}
+
+	for (size_t n = 0; n <= src.size(); n++) {
+		std::string simd(n, 'X');
+		std::string scalar(n, 'X');
+		lq_revcomp(&simd[0], src.data(), n);
+		lq_revcomp_scalar(&scalar[0], src.data(), n);
+		ASSERT_EQ(simd, scalar) << "n = " << n;
+	}
+
+	char out[8];
+	lq_revcomp(out, "ACGTNa", 6);
+	ASSERT_EQ(std::string(out, 6), "tNACGT");
+}
+
+TEST(Decimal, MatchesPrintf)
+{
+	std::vector<u32> values = {0, UINT32_MAX};
+	for (u32 p = 1; p <= 1000000000u; p *= 10) {
+		values.push_back(p - 1);
+		values.push_back(p);
+		values.push_back(p + 1);
+		if (p == 1000000000u)
+			break;
+	}
+	unsigned seed = 11;
+	for (int i = 0; i < 1000; i++) {
+		seed = seed * 1103515245 + 12345;
+		values.push_back(seed >> (seed % 32));
+	}
+
+	for (u32 v : values) {
+		std::string expected = std::to_string(v);
+		ASSERT_EQ(count_digits(v), expected.size()) << v;
+
+		char buf[LQ_U32_DEC_MAX];
+		char *end = lq_u32_to_dec(buf, v);
+		ASSERT_EQ(std::string(buf, end - buf), expected);
+	}
+}
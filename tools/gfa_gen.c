@@ -0,0 +1,506 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <log.h>
+
+#include "../include/liteseq/gfa.h"
+#include "../include/liteseq/types.h"
+
+#include "./gfa_gen.h"
+
+// the independent streams of numbers a graph is drawn from
+enum gen_stream {
+	GEN_LABEL,  // the label of a segment
+	GEN_SITE,   // the bubble after an anchor
+	GEN_PATH,   // the kind and the stretch of a path
+	GEN_CHOICE, // the arm a path takes at a bubble
+};
+
+#define GEN_LABEL_CHUNK 64 // bases written at a time
+
+static u64 mix(u64 x)
+{
+	// the splitmix64 finalizer
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ull;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebull;
+	x ^= x >> 31;
+
+	return x;
+}
+
+static u64 gen_hash(u64 seed, enum gen_stream stream, u64 i)
+{
+	return mix(mix(seed + 0x9e3779b97f4a7c15ull * (stream + 1)) + i);
+}
+
+struct gen_rng {
+	u64 state;
+};
+
+static u64 gen_next(struct gen_rng *r)
+{
+	r->state += 0x9e3779b97f4a7c15ull;
+	return mix(r->state);
+}
+
+// uniform over [0, 1)
+static double gen_unit(struct gen_rng *r)
+{
+	return (double)(gen_next(r) >> 11) * 0x1.0p-53;
+}
+
+// uniform over [0, n), n > 0
+static u64 gen_below(struct gen_rng *r, u64 n)
+{
+	return gen_next(r) % n;
+}
+
+/*
+ * Output
+ * ------
+ */
+
+// buffered here, most writes are a few bytes and stdio locks for each
+struct gen_writer {
+	FILE *out;
+	u64 bytes;
+	size_t len; // of buf in use
+	char *buf;  // BUFFER_SIZE bytes
+};
+
+static void flush_writer(struct gen_writer *w)
+{
+	fwrite(w->buf, 1, w->len, w->out);
+	w->len = 0;
+}
+
+static void put_bytes(struct gen_writer *w, const char *s, size_t n)
+{
+	if (w->len + n > BUFFER_SIZE)
+		flush_writer(w);
+	if (n > BUFFER_SIZE) {
+		fwrite(s, 1, n, w->out);
+	} else {
+		memcpy(w->buf + w->len, s, n);
+		w->len += n;
+	}
+	w->bytes += n;
+}
+
+static void put_str(struct gen_writer *w, const char *s)
+{
+	put_bytes(w, s, strlen(s));
+}
+
+static void put_u64(struct gen_writer *w, u64 v)
+{
+	char buf[20];
+	size_t i = sizeof(buf);
+	do {
+		buf[--i] = (char)('0' + v % 10);
+		v /= 10;
+	} while (v);
+	put_bytes(w, buf + i, sizeof(buf) - i);
+}
+
+/*
+ * Segments
+ * --------
+ */
+
+static u32 label_len(const struct gfa_gen_opts *o, struct gen_rng *r)
+{
+	u32 lo = o->min_label_len;
+	u32 hi = o->max_label_len;
+	if (o->len_dist == GFA_GEN_LEN_UNIFORM)
+		return lo + (u32)gen_below(r, (u64)hi - lo + 1);
+
+	// the failures before a success at odds 1 / (mean - lo + 1)
+	double tail = (double)(o->mean_label_len - lo);
+	if (tail <= 0)
+		return lo;
+	double len = floor(log(1.0 - gen_unit(r)) / log(tail / (tail + 1)));
+
+	return len >= (double)(hi - lo) ? hi : lo + (u32)len;
+}
+
+static u32 segment_len(const struct gfa_gen_opts *o, id_t v)
+{
+	struct gen_rng r = {gen_hash(o->seed, GEN_LABEL, v)};
+	return label_len(o, &r);
+}
+
+static void put_segment(struct gen_writer *w, const struct gfa_gen_opts *o,
+			id_t v)
+{
+	struct gen_rng r = {gen_hash(o->seed, GEN_LABEL, v)};
+	u32 len = label_len(o, &r);
+
+	put_str(w, "S\t");
+	put_u64(w, v);
+	put_str(w, "\t");
+
+	// two bits of a draw for each base
+	char chunk[GEN_LABEL_CHUNK];
+	u64 bits = 0;
+	for (u32 i = 0; i < len; i++) {
+		if (i % 32 == 0)
+			bits = gen_next(&r);
+		chunk[i % GEN_LABEL_CHUNK] = "ACGT"[bits & 3];
+		bits >>= 2;
+		if (i % GEN_LABEL_CHUNK == GEN_LABEL_CHUNK - 1)
+			put_bytes(w, chunk, GEN_LABEL_CHUNK);
+	}
+	put_bytes(w, chunk, len % GEN_LABEL_CHUNK);
+	put_str(w, "\n");
+}
+
+/*
+ * The chain
+ * ---------
+ * Walked from the first site every time it is needed, the ids of a site
+ * depend on all the sites before it.
+ */
+
+struct gen_site {
+	idx_t idx;
+	id_t anchor;
+	id_t arm[2];	 // the first id of each arm
+	u32 arm_len[2];	 // both 0 when there is no bubble
+	id_t next;	 // the next anchor, 0 after the last one
+};
+
+struct gen_chain {
+	const struct gfa_gen_opts *o;
+	idx_t idx;    // of the next site
+	id_t next_id; // of the next segment
+};
+
+static void chain_start(struct gen_chain *c, const struct gfa_gen_opts *o)
+{
+	c->o = o;
+	c->idx = 0;
+	c->next_id = 1;
+}
+
+static bool chain_next(struct gen_chain *c, struct gen_site *s)
+{
+	const struct gfa_gen_opts *o = c->o;
+	if (c->next_id > o->segment_count)
+		return false;
+
+	struct gen_rng r = {gen_hash(o->seed, GEN_SITE, c->idx)};
+	s->idx = c->idx++;
+	s->anchor = c->next_id++;
+	s->arm_len[0] = s->arm_len[1] = 0;
+
+	// the arms and the anchor they meet at have to fit
+	id_t left = o->segment_count - s->anchor;
+	if (o->max_arm_len > 0 && left >= 2 &&
+	    gen_unit(&r) < o->bubble_density) {
+		u32 a0 = (u32)gen_below(&r, (u64)o->max_arm_len + 1);
+		u32 a1 = 1 + (u32)gen_below(&r, o->max_arm_len);
+		if (a1 > left - 1)
+			a1 = left - 1;
+		if (a0 > left - 1 - a1)
+			a0 = left - 1 - a1;
+		s->arm_len[0] = a0;
+		s->arm_len[1] = a1;
+	}
+
+	s->arm[0] = c->next_id;
+	c->next_id += s->arm_len[0];
+	s->arm[1] = c->next_id;
+	c->next_id += s->arm_len[1];
+	s->next = c->next_id <= o->segment_count ? c->next_id : 0;
+
+	return true;
+}
+
+static void put_link(struct gen_writer *w, id_t from, id_t to)
+{
+	put_str(w, "L\t");
+	put_u64(w, from);
+	put_str(w, "\t+\t");
+	put_u64(w, to);
+	put_str(w, "\t+\t0M\n");
+}
+
+static idx_t put_links(struct gen_writer *w, const struct gen_site *s)
+{
+	if (!s->next)
+		return 0;
+
+	if (!s->arm_len[1]) {
+		put_link(w, s->anchor, s->next);
+		return 1;
+	}
+
+	idx_t links = 0;
+	for (int a = 0; a < 2; a++) {
+		id_t prev = s->anchor;
+		for (u32 i = 0; i < s->arm_len[a]; i++) {
+			put_link(w, prev, s->arm[a] + i);
+			prev = s->arm[a] + i;
+			links++;
+		}
+		put_link(w, prev, s->next);
+		links++;
+	}
+
+	return links;
+}
+
+/*
+ * Paths
+ * -----
+ */
+
+struct gen_path {
+	idx_t idx;
+	bool w_line;
+	idx_t first_site;
+	idx_t site_count;
+	u64 choices; // the seed of the arms it takes
+};
+
+static void plan_path(const struct gfa_gen_opts *o, idx_t p, idx_t sites,
+		      struct gen_path *path)
+{
+	struct gen_rng r = {gen_hash(o->seed, GEN_PATH, p)};
+	path->idx = p;
+	path->w_line = gen_unit(&r) < o->w_line_frac;
+
+	double frac = o->min_walk_frac +
+		      gen_unit(&r) * (o->max_walk_frac - o->min_walk_frac);
+	idx_t n = (idx_t)(frac * sites + 0.5);
+	if (n < 1)
+		n = 1;
+	if (n > sites)
+		n = sites;
+	path->site_count = n;
+	path->first_site = (idx_t)gen_below(&r, (u64)sites - n + 1);
+	path->choices = gen_hash(o->seed, GEN_CHOICE, p);
+}
+
+typedef void (*step_fn)(id_t v, void *data);
+
+// the steps of path, the arms of the bubbles between its sites included
+static void walk_path(const struct gfa_gen_opts *o,
+		      const struct gen_path *path, step_fn fn, void *data)
+{
+	struct gen_chain c;
+	struct gen_site s;
+	chain_start(&c, o);
+	idx_t last = path->first_site + path->site_count - 1;
+	while (chain_next(&c, &s) && s.idx <= last) {
+		if (s.idx < path->first_site)
+			continue;
+		fn(s.anchor, data);
+		if (s.idx == last || !s.arm_len[1])
+			continue;
+
+		int a = (int)(mix(path->choices + s.idx) & 1);
+		for (u32 i = 0; i < s.arm_len[a]; i++)
+			fn(s.arm[a] + i, data);
+	}
+}
+
+struct len_acc {
+	const struct gfa_gen_opts *o;
+	u64 len;
+};
+
+static void add_len(id_t v, void *data)
+{
+	struct len_acc *acc = data;
+	acc->len += segment_len(acc->o, v);
+}
+
+struct step_writer {
+	struct gen_writer *w;
+	bool w_line;
+	bool first;
+};
+
+static void put_step(id_t v, void *data)
+{
+	struct step_writer *sw = data;
+	if (sw->w_line) {
+		put_str(sw->w, ">");
+		put_u64(sw->w, v);
+		return;
+	}
+
+	if (!sw->first)
+		put_str(sw->w, ",");
+	sw->first = false;
+	put_u64(sw->w, v);
+	put_str(sw->w, "+");
+}
+
+static void put_sample(struct gen_writer *w, idx_t p, u32 ploidy)
+{
+	put_str(w, "HG");
+	put_u64(w, p / ploidy);
+}
+
+static void put_path(struct gen_writer *w, const struct gfa_gen_opts *o,
+		     const struct gen_path *path)
+{
+	u64 hap_id = path->idx % o->ploidy + 1;
+
+	if (path->w_line) {
+		// the W line has the length of the haplotype ahead of its walk
+		struct len_acc acc = {.o = o, .len = 0};
+		walk_path(o, path, add_len, &acc);
+
+		put_str(w, "W\t");
+		put_sample(w, path->idx, o->ploidy);
+		put_str(w, "\t");
+		put_u64(w, hap_id);
+		put_str(w, "\t");
+		put_str(w, o->contig);
+		put_str(w, "\t0\t");
+		put_u64(w, acc.len);
+		put_str(w, "\t");
+	} else if (o->pansn) {
+		put_str(w, "P\t");
+		put_sample(w, path->idx, o->ploidy);
+		put_str(w, "#");
+		put_u64(w, hap_id);
+		put_str(w, "#");
+		put_str(w, o->contig);
+		put_str(w, "\t");
+	} else {
+		put_str(w, "P\tpath");
+		put_u64(w, path->idx);
+		put_str(w, "\t");
+	}
+
+	struct step_writer sw = {.w = w, .w_line = path->w_line, .first = true};
+	walk_path(o, path, put_step, &sw);
+	put_str(w, path->w_line ? "\n" : "\t*\n");
+}
+
+/*
+ * Graphs
+ * ------
+ */
+
+void gfa_gen_defaults(struct gfa_gen_opts *opts)
+{
+	*opts = (struct gfa_gen_opts){
+		.seed = 1,
+		.version = GFA_1_1,
+		.segment_count = 100000,
+		.len_dist = GFA_GEN_LEN_UNIFORM,
+		.min_label_len = 1,
+		.max_label_len = 32,
+		.mean_label_len = 8,
+		.bubble_density = 0.3,
+		.max_arm_len = 3,
+		.path_count = 8,
+		.min_walk_frac = 1.0,
+		.max_walk_frac = 1.0,
+		.w_line_frac = 0.5,
+		.pansn = true,
+		.ploidy = 2,
+		.contig = "chr1",
+	};
+}
+
+static bool valid_opts(const struct gfa_gen_opts *o)
+{
+	if (o->segment_count == 0 || o->segment_count == NULL_ID ||
+	    o->min_label_len == 0 || o->min_label_len > o->max_label_len)
+		return false;
+
+	if (o->len_dist == GFA_GEN_LEN_GEOMETRIC &&
+	    (o->mean_label_len < o->min_label_len ||
+	     o->mean_label_len > o->max_label_len))
+		return false;
+
+	if (!(o->bubble_density >= 0 && o->bubble_density <= 1) ||
+	    !(o->min_walk_frac > 0 && o->min_walk_frac <= o->max_walk_frac &&
+	      o->max_walk_frac <= 1) ||
+	    !(o->w_line_frac >= 0 && o->w_line_frac <= 1))
+		return false;
+
+	// W lines came with GFA 1.1
+	if (o->version == GFA_1_0 && o->w_line_frac > 0)
+		return false;
+
+	return o->ploidy > 0 && o->contig && *o->contig &&
+	       !strpbrk(o->contig, "\t\n#");
+}
+
+status_t gfa_gen_write(const struct gfa_gen_opts *opts, FILE *out,
+		       struct gfa_gen_counts *counts)
+{
+	if (!opts || !out || !valid_opts(opts))
+		return ERROR_CODE_INVALID_ARGUMENT;
+
+	struct gen_writer w = {.out = out, .bytes = 0, .len = 0};
+	w.buf = malloc(BUFFER_SIZE);
+	if (!w.buf)
+		return ERROR_CODE_OUT_OF_MEMORY;
+	struct gfa_gen_counts c = {.segments = opts->segment_count};
+
+	put_str(&w, opts->version == GFA_1_0 ? "H\tVN:Z:1.0\n"
+					     : "H\tVN:Z:1.1\n");
+
+	for (id_t v = 1; v <= opts->segment_count; v++)
+		put_segment(&w, opts, v);
+
+	struct gen_chain chain;
+	struct gen_site s;
+	idx_t sites = 0;
+	chain_start(&chain, opts);
+	while (chain_next(&chain, &s)) {
+		c.links += put_links(&w, &s);
+		sites++;
+	}
+
+	for (idx_t p = 0; p < opts->path_count; p++) {
+		struct gen_path path;
+		plan_path(opts, p, sites, &path);
+		put_path(&w, opts, &path);
+		if (path.w_line)
+			c.w_lines++;
+		else
+			c.p_lines++;
+	}
+	c.bytes = w.bytes;
+	flush_writer(&w);
+	free(w.buf);
+
+	if (fflush(out) != 0 || ferror(out)) {
+		log_error("Failed to write the generated graph");
+		return FAILURE;
+	}
+	if (counts)
+		*counts = c;
+
+	return SUCCESS;
+}
+
+status_t gfa_gen_file(const struct gfa_gen_opts *opts, const char *fp,
+		      struct gfa_gen_counts *counts)
+{
+	FILE *out = fp ? fopen(fp, "wb") : NULL;
+	if (!out) {
+		log_error("Failed to open %s for writing", fp ? fp : "(null)");
+		return FAILURE;
+	}
+
+	status_t res = gfa_gen_write(opts, out, counts);
+	if (fclose(out) != 0 && res == SUCCESS)
+		res = FAILURE;
+
+	return res;
+}
@@ -0,0 +1,87 @@
+#ifndef LQ_GFA_GEN_H
+#define LQ_GFA_GEN_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "../include/liteseq/gfa.h"
+#include "../include/liteseq/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+namespace liteseq
+{
+#endif
+
+/*
+ * Synthetic pangenomes
+ * --------------------
+ * A chain of anchor segments, some followed by a bubble of two arms that
+ * meet again at the next anchor. An arm may be empty, a deletion. Each path
+ * walks a stretch of the chain and picks an arm at every bubble.
+ *
+ * Everything is drawn from hashes of the seed and the index of the segment,
+ * site or path it is about, so the same options give the same graph on
+ * every run and it is streamed out in constant memory.
+ */
+
+enum gfa_gen_len_dist {
+	GFA_GEN_LEN_UNIFORM,   // uniform over [min_label_len, max_label_len]
+	GFA_GEN_LEN_GEOMETRIC, // min_label_len plus a geometric tail
+};
+
+struct gfa_gen_opts {
+	u64 seed;
+	enum gfa_version version; // GFA 1.0 has no W lines
+
+	id_t segment_count;
+
+	enum gfa_gen_len_dist len_dist;
+	u32 min_label_len;
+	u32 max_label_len;  // labels are clipped to it
+	u32 mean_label_len; // for GFA_GEN_LEN_GEOMETRIC
+
+	double bubble_density; // the chance that an anchor starts a bubble
+	u32 max_arm_len;       // segments in an arm of a bubble
+
+	idx_t path_count;
+	double min_walk_frac; // the share of the chain a path walks
+	double max_walk_frac;
+	double w_line_frac; // the share of the paths written as W lines
+
+	// P lines are named sample#hap_id#contig, otherwise path<n>
+	bool pansn;
+	u32 ploidy;	    // paths of a sample, hap ids 1 to ploidy
+	const char *contig; // the contig of every path
+};
+
+// what a generated graph holds
+struct gfa_gen_counts {
+	id_t segments;
+	idx_t links;
+	idx_t p_lines;
+	idx_t w_lines;
+	u64 bytes;
+};
+
+void gfa_gen_defaults(struct gfa_gen_opts *opts);
+
+/**
+ * Write the graph opts describe to out
+ *
+ * @param [out] counts what was written, may be NULL
+ * @return ERROR_CODE_INVALID_ARGUMENT for options that make no graph
+ */
+status_t gfa_gen_write(const struct gfa_gen_opts *opts, FILE *out,
+		       struct gfa_gen_counts *counts);
+
+// gfa_gen_write to the file at fp, replacing it
+status_t gfa_gen_file(const struct gfa_gen_opts *opts, const char *fp,
+		      struct gfa_gen_counts *counts);
+
+#ifdef __cplusplus
+} // namespace liteseq
+} // extern "C"
+#endif
+
+#endif // LQ_GFA_GEN_H
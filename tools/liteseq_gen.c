@@ -0,0 +1,186 @@
+#if defined(__linux__)
+#define _GNU_SOURCE // getopt_long
+#endif
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <liteseq/gfa.h>
+#include <liteseq/types.h>
+
+#include "./gfa_gen.h"
+
+static void usage(FILE *out, const char *prog)
+{
+	struct gfa_gen_opts d;
+	gfa_gen_defaults(&d);
+
+	fprintf(out,
+		"Usage: %s [options] [out.gfa]\n"
+		"Write a synthetic pangenome GFA, to stdout without out.gfa.\n"
+		"\n"
+		"  -s, --seed N          seed of the graph [%llu]\n"
+		"      --gfa-1.0         write GFA 1.0, needs --w-lines 0\n"
+		"  -n, --segments N      segments [%u]\n"
+		"      --len-dist D      label lengths, uniform or geometric\n"
+		"      --min-len N       shortest label [%u]\n"
+		"      --max-len N       longest label [%u]\n"
+		"      --mean-len N      mean label length if geometric [%u]\n"
+		"  -b, --bubbles F       share of the anchors with a bubble "
+		"[%.2f]\n"
+		"      --max-arm N       segments in an arm of a bubble [%u]\n"
+		"  -p, --paths N         paths [%u]\n"
+		"      --min-walk F      least share of the chain a path walks "
+		"[%.2f]\n"
+		"      --max-walk F      most share of the chain a path walks "
+		"[%.2f]\n"
+		"  -w, --w-lines F       share of the paths as W lines [%.2f]\n"
+		"      --no-pansn        name P lines path<n>\n"
+		"      --ploidy N        haplotypes of a sample [%u]\n"
+		"      --contig NAME     contig of the paths [%s]\n"
+		"  -h, --help            print this help\n",
+		prog, (unsigned long long)d.seed, d.segment_count,
+		d.min_label_len, d.max_label_len, d.mean_label_len,
+		d.bubble_density, d.max_arm_len, d.path_count,
+		d.min_walk_frac, d.max_walk_frac, d.w_line_frac, d.ploidy,
+		d.contig);
+}
+
+enum long_only_opts {
+	OPT_GFA_1_0 = 256,
+	OPT_LEN_DIST,
+	OPT_MIN_LEN,
+	OPT_MAX_LEN,
+	OPT_MEAN_LEN,
+	OPT_MAX_ARM,
+	OPT_MIN_WALK,
+	OPT_MAX_WALK,
+	OPT_NO_PANSN,
+	OPT_PLOIDY,
+	OPT_CONTIG,
+};
+
+static const struct option long_opts[] = {
+	{"seed", required_argument, NULL, 's'},
+	{"gfa-1.0", no_argument, NULL, OPT_GFA_1_0},
+	{"segments", required_argument, NULL, 'n'},
+	{"len-dist", required_argument, NULL, OPT_LEN_DIST},
+	{"min-len", required_argument, NULL, OPT_MIN_LEN},
+	{"max-len", required_argument, NULL, OPT_MAX_LEN},
+	{"mean-len", required_argument, NULL, OPT_MEAN_LEN},
+	{"bubbles", required_argument, NULL, 'b'},
+	{"max-arm", required_argument, NULL, OPT_MAX_ARM},
+	{"paths", required_argument, NULL, 'p'},
+	{"min-walk", required_argument, NULL, OPT_MIN_WALK},
+	{"max-walk", required_argument, NULL, OPT_MAX_WALK},
+	{"w-lines", required_argument, NULL, 'w'},
+	{"no-pansn", no_argument, NULL, OPT_NO_PANSN},
+	{"ploidy", required_argument, NULL, OPT_PLOIDY},
+	{"contig", required_argument, NULL, OPT_CONTIG},
+	{"help", no_argument, NULL, 'h'},
+	{NULL, 0, NULL, 0},
+};
+
+int main(int argc, char *argv[])
+{
+	struct gfa_gen_opts o;
+	gfa_gen_defaults(&o);
+
+	int c;
+	while ((c = getopt_long(argc, argv, "s:n:b:p:w:h", long_opts, NULL)) !=
+	       -1) {
+		switch (c) {
+		case 's':
+			o.seed = strtoull(optarg, NULL, 10);
+			break;
+		case OPT_GFA_1_0:
+			o.version = GFA_1_0;
+			break;
+		case 'n':
+			o.segment_count = (id_t)strtoul(optarg, NULL, 10);
+			break;
+		case OPT_LEN_DIST:
+			if (strcmp(optarg, "uniform") == 0) {
+				o.len_dist = GFA_GEN_LEN_UNIFORM;
+			} else if (strcmp(optarg, "geometric") == 0) {
+				o.len_dist = GFA_GEN_LEN_GEOMETRIC;
+			} else {
+				fprintf(stderr, "Unknown length distribution "
+						"%s\n",
+					optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		case OPT_MIN_LEN:
+			o.min_label_len = (u32)strtoul(optarg, NULL, 10);
+			break;
+		case OPT_MAX_LEN:
+			o.max_label_len = (u32)strtoul(optarg, NULL, 10);
+			break;
+		case OPT_MEAN_LEN:
+			o.mean_label_len = (u32)strtoul(optarg, NULL, 10);
+			break;
+		case 'b':
+			o.bubble_density = strtod(optarg, NULL);
+			break;
+		case OPT_MAX_ARM:
+			o.max_arm_len = (u32)strtoul(optarg, NULL, 10);
+			break;
+		case 'p':
+			o.path_count = (idx_t)strtoul(optarg, NULL, 10);
+			break;
+		case OPT_MIN_WALK:
+			o.min_walk_frac = strtod(optarg, NULL);
+			break;
+		case OPT_MAX_WALK:
+			o.max_walk_frac = strtod(optarg, NULL);
+			break;
+		case 'w':
+			o.w_line_frac = strtod(optarg, NULL);
+			break;
+		case OPT_NO_PANSN:
+			o.pansn = false;
+			break;
+		case OPT_PLOIDY:
+			o.ploidy = (u32)strtoul(optarg, NULL, 10);
+			break;
+		case OPT_CONTIG:
+			o.contig = optarg;
+			break;
+		case 'h':
+			usage(stdout, argv[0]);
+			return EXIT_SUCCESS;
+		default:
+			usage(stderr, argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (argc - optind > 1) {
+		usage(stderr, argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	struct gfa_gen_counts counts;
+	status_t res;
+	if (optind < argc)
+		res = gfa_gen_file(&o, argv[optind], &counts);
+	else
+		res = gfa_gen_write(&o, stdout, &counts);
+
+	if (res == ERROR_CODE_INVALID_ARGUMENT) {
+		fprintf(stderr, "The options describe no graph, see --help\n");
+		return EXIT_FAILURE;
+	}
+	if (res != SUCCESS)
+		return EXIT_FAILURE;
+
+	fprintf(stderr,
+		"%u segments, %u links, %u P lines, %u W lines, %llu bytes\n",
+		counts.segments, counts.links, counts.p_lines, counts.w_lines,
+		(unsigned long long)counts.bytes);
+
+	return EXIT_SUCCESS;
+}